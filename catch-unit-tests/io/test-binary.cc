@@ -0,0 +1,76 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "data/dataset.h"
+#include "data/vertical_dataset.h"
+#include "io/binary.h"
+
+#include <cstdio>
+
+TEST_CASE( "Testing binary dataset IO", "[io][binary]" ) {
+  // build a small dataset with 3 queries
+  std::shared_ptr<quickrank::data::Dataset> dataset(
+      new quickrank::data::Dataset(5, 3));
+  dataset->addInstance(1, 2, {0.5f, 1.0f, -3.0f});
+  dataset->addInstance(1, 0, {1.5f, 0.0f, 7.0f});
+  dataset->addInstance(4, 1, {2.5f, 3.0f});
+  dataset->addInstance(2, 3, {0.0f, 0.25f, 1e-3f});
+  dataset->addInstance(2, 0, {9.0f, 8.0f, 7.0f});
+
+  std::string filename = "quickrank-test-binary.bin";
+  quickrank::io::Binary writer;
+  writer.write(dataset, filename);
+
+  REQUIRE(quickrank::io::Binary::is_binary(filename));
+
+  quickrank::io::Binary reader;
+  std::shared_ptr<quickrank::data::Dataset> loaded =
+      reader.read_horizontal(filename);
+  std::remove(filename.c_str());  // the mapping is still valid
+
+  REQUIRE(loaded->num_instances() == dataset->num_instances());
+  REQUIRE(loaded->num_features() == dataset->num_features());
+  REQUIRE(loaded->num_queries() == 3);
+  for (size_t q = 0; q <= loaded->num_queries(); ++q)
+    REQUIRE(loaded->offset(q) == dataset->offset(q));
+  for (size_t i = 0; i < loaded->num_instances(); ++i) {
+    REQUIRE(loaded->getLabel(i) == dataset->getLabel(i));
+    for (size_t f = 0; f < loaded->num_features(); ++f)
+      REQUIRE(*loaded->at(i, f) == *dataset->at(i, f));
+  }
+
+  // the vertical layout is shared with the mapped file
+  REQUIRE(loaded->vertical_data() != NULL);
+  quickrank::data::VerticalDataset vertical(loaded);
+  REQUIRE(vertical.at(0, 0) == loaded->vertical_data());
+  for (size_t i = 0; i < loaded->num_instances(); ++i) {
+    REQUIRE(vertical.getLabel(i) == loaded->getLabel(i));
+    for (size_t f = 0; f < loaded->num_features(); ++f)
+      REQUIRE(*vertical.at(i, f) == *loaded->at(i, f));
+  }
+
+  std::unique_ptr<quickrank::data::QueryResults> qr = loaded->getQueryResults(1);
+  REQUIRE(qr->num_results() == 1);
+  REQUIRE(qr->labels()[0] == 1);
+  REQUIRE(qr->features()[1] == 3.0f);
+}
@@ -0,0 +1,73 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   QuickRank team
+ */
+#include "catch/include/catch.hpp"
+
+#include "data/dataset.h"
+#include "io/svml.h"
+
+#include <cstdio>
+#include <fstream>
+
+TEST_CASE( "Testing SVML reader", "[io][svml]" ) {
+  // write a small file covering comments, blank lines and number formats
+  std::string filename = "quickrank-test-svml.txt";
+  {
+    std::ofstream out(filename);
+    out << "# header comment\n"
+        << "2 qid:10 1:0.5 3:-1.25e2 # trailing comment\n"
+        << "\n"
+        << "0 qid:10 2:7 4:1e-3\n"
+        << "   \n"
+        << "1 qid:11 1:3.14159265358979 4:+42\r\n"
+        << "3 qid:12 2:.25";  // no final newline
+  }
+
+  quickrank::io::Svml reader;
+  std::shared_ptr<quickrank::data::Dataset> dataset =
+      reader.read_horizontal(filename);
+  std::remove(filename.c_str());
+
+  REQUIRE(dataset->num_features() == 4);
+  REQUIRE(dataset->num_instances() == 4);
+  REQUIRE(dataset->num_queries() == 3);
+
+  REQUIRE(dataset->getLabel(0) == 2);
+  REQUIRE(dataset->getLabel(1) == 0);
+  REQUIRE(dataset->getLabel(2) == 1);
+  REQUIRE(dataset->getLabel(3) == 3);
+
+  // features are 1-based in the file, 0-based in the dataset
+  REQUIRE(*dataset->at(0, 0) == 0.5f);
+  REQUIRE(*dataset->at(0, 1) == 0.0f);
+  REQUIRE(*dataset->at(0, 2) == -125.0f);
+  REQUIRE(*dataset->at(1, 1) == 7.0f);
+  REQUIRE(*dataset->at(1, 3) == 1e-3f);
+  REQUIRE(*dataset->at(2, 0) == 3.14159265358979f);
+  REQUIRE(*dataset->at(2, 3) == 42.0f);
+  REQUIRE(*dataset->at(3, 1) == 0.25f);
+
+  std::unique_ptr<quickrank::data::QueryResults> qr =
+      dataset->getQueryResults(0);
+  REQUIRE(qr->num_results() == 2);
+  qr = dataset->getQueryResults(2);
+  REQUIRE(qr->num_results() == 1);
+}
@@ -0,0 +1,121 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "learning/compiled/compiled_ranker.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+
+/// Compiles the model in \a xml with \a generator, and checks that both
+/// entry points agree with the library model, and that a second ranker of
+/// the same model is loaded from the cache.
+void check_compiled_ranker(const std::string &xml,
+                           const std::string &generator) {
+  std::string model_filename = "test-compiled-model.xml";
+  std::string cache_dir = "test-compiled-cache";
+  std::ofstream model(model_filename);
+  model << xml << std::endl;
+  model.close();
+
+  auto reference =
+      quickrank::learning::LTR_Algorithm::load_model_from_file(model_filename);
+  quickrank::learning::CompiledRanker ranker(model_filename, generator,
+                                             cache_dir);
+  REQUIRE( ranker.compiled() );
+
+  // not a multiple of the documents scored together
+  const size_t ndocs = 203;
+  auto dataset = std::make_shared<quickrank::data::Dataset>(ndocs, 3);
+  srand(11);
+  for (size_t i = 0; i < ndocs; ++i)
+    dataset->addInstance(i / 10, 0, {(float) (rand() % 5) / 2.0f,
+                                     (float) (rand() % 5) / 2.0f,
+                                     (float) (rand() % 5) / 2.0f});
+  std::vector<quickrank::Score> scores(ndocs);
+  ranker.score_dataset(dataset, scores.data());
+  for (size_t i = 0; i < ndocs; ++i) {
+    const quickrank::Score score =
+        reference->score_document(dataset->at(i, 0));
+    REQUIRE( ranker.score_document(dataset->at(i, 0)) == Approx(score) );
+    REQUIRE( scores[i] == Approx(score) );
+  }
+
+  quickrank::learning::CompiledRanker cached(model_filename, generator,
+                                             cache_dir);
+  REQUIRE( !cached.compiled() );
+  REQUIRE( cached.library() == ranker.library() );
+
+  std::string library = ranker.library();
+  std::remove(library.c_str());
+  std::remove((library.substr(0, library.size() - 3) + ".cc").c_str());
+  // no generated file is left behind
+  REQUIRE( rmdir(cache_dir.c_str()) == 0 );
+  std::remove(model_filename.c_str());
+}
+
+}  // namespace
+
+TEST_CASE( "Testing CompiledRanker", "[learning][compiled]" ) {
+  check_compiled_ranker(
+      "<ranker><info><type>MART</type><trees>2</trees><leaves>3</leaves>"
+      "<shrinkage>0.5</shrinkage></info><ensemble>"
+      "<tree id=\"1\" weight=\"0.5\"><split>"
+      "<feature>1</feature><threshold>0.5</threshold>"
+      "<split pos=\"left\"><output>1.0</output></split>"
+      "<split pos=\"right\">"
+      "<feature>3</feature><threshold>2.0</threshold>"
+      "<split pos=\"left\"><output>2.0</output></split>"
+      "<split pos=\"right\"><output>4.0</output></split>"
+      "</split></split></tree>"
+      "<tree id=\"2\" weight=\"0.25\"><split>"
+      "<feature>2</feature><threshold>1.5</threshold>"
+      "<split pos=\"left\"><output>-8.0</output></split>"
+      "<split pos=\"right\"><output>8.0</output></split>"
+      "</split></tree>"
+      "</ensemble></ranker>", "condop");
+
+  check_compiled_ranker(
+      "<ranker><info><type>OBVMART</type><trees>2</trees><leaves>4</leaves>"
+      "<depth>2</depth><shrinkage>0.5</shrinkage></info><ensemble>"
+      "<tree id=\"1\" weight=\"0.5\"><split>"
+      "<feature>1</feature><threshold>0.5</threshold>"
+      "<split pos=\"left\">"
+      "<feature>3</feature><threshold>1.0</threshold>"
+      "<split pos=\"left\"><output>1.0</output></split>"
+      "<split pos=\"right\"><output>2.0</output></split></split>"
+      "<split pos=\"right\">"
+      "<feature>3</feature><threshold>1.0</threshold>"
+      "<split pos=\"left\"><output>3.0</output></split>"
+      "<split pos=\"right\"><output>4.0</output></split></split>"
+      "</split></tree>"
+      "<tree id=\"2\" weight=\"0.25\"><split>"
+      "<feature>2</feature><threshold>1.5</threshold>"
+      "<split pos=\"left\"><output>-8.0</output></split>"
+      "<split pos=\"right\"><output>8.0</output></split>"
+      "</split></tree>"
+      "</ensemble></ranker>", "oblivious");
+}
@@ -0,0 +1,110 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include "learning/tree/rtnode.h"
+#include "types.h"
+
+#include <cstdlib>
+#include <vector>
+
+/// Random trees and documents shared by the tests of the tree scorers.
+/// Thresholds and feature values are drawn from few values, so that many
+/// tests are ties. Everything is drawn with rand(), hence it is
+/// reproducible with srand().
+namespace random_trees {
+
+/// Returns a random leaf output in [\a leaf_offset, \a leaf_offset + 10).
+inline double random_leaf(const double leaf_offset) {
+  return (double) (rand() % 1000) / 100.0 + leaf_offset;
+}
+
+/// Returns a random threshold in {0, 0.25, ..., 3.75}.
+inline float random_threshold() {
+  return (float) (rand() % 16) / 4.0f;
+}
+
+/// Builds a random tree with exactly \a nleaves leaves.
+inline RTNode *random_tree_with_leaves(const size_t nleaves,
+                                       const size_t nfeatures,
+                                       const double leaf_offset = 0.0) {
+  if (nleaves == 1)
+    return new RTNode(random_leaf(leaf_offset));
+  const size_t nleft = 1 + rand() % (nleaves - 1);
+  const size_t f = rand() % nfeatures;
+  return new RTNode(random_threshold(), f, f + 1,
+                    random_tree_with_leaves(nleft, nfeatures, leaf_offset),
+                    random_tree_with_leaves(nleaves - nleft, nfeatures,
+                                            leaf_offset));
+}
+
+/// Builds a random tree of depth at most \a depth. If \a leaf_odds is not
+/// 0, every node above the last level is a leaf with probability
+/// 1 / \a leaf_odds, otherwise the tree is complete.
+inline RTNode *random_tree_with_depth(const size_t depth,
+                                      const size_t nfeatures,
+                                      const size_t leaf_odds = 0,
+                                      const double leaf_offset = 0.0) {
+  if (depth == 0 || (leaf_odds && rand() % leaf_odds == 0))
+    return new RTNode(random_leaf(leaf_offset));
+  const size_t f = rand() % nfeatures;
+  return new RTNode(random_threshold(), f, f + 1,
+                    random_tree_with_depth(depth - 1, nfeatures, leaf_odds,
+                                           leaf_offset),
+                    random_tree_with_depth(depth - 1, nfeatures, leaf_odds,
+                                           leaf_offset));
+}
+
+/// Builds an oblivious tree testing \a features[l] against
+/// \a thresholds[l] at level l, with random leaves.
+inline RTNode *oblivious_tree(const std::vector<size_t> &features,
+                              const std::vector<float> &thresholds,
+                              const size_t level = 0) {
+  if (level == features.size())
+    return new RTNode(random_leaf(0.0));
+  return new RTNode(thresholds[level], features[level], features[level] + 1,
+                    oblivious_tree(features, thresholds, level + 1),
+                    oblivious_tree(features, thresholds, level + 1));
+}
+
+/// Builds a random oblivious tree of the given \a depth.
+inline RTNode *random_oblivious_tree(const size_t depth,
+                                     const size_t nfeatures) {
+  std::vector<size_t> features(depth);
+  std::vector<float> thresholds(depth);
+  for (size_t l = 0; l < depth; ++l) {
+    features[l] = rand() % nfeatures;
+    thresholds[l] = random_threshold();
+  }
+  return oblivious_tree(features, thresholds);
+}
+
+/// Fills \a docs with \a ndocs random documents of \a nfeatures features,
+/// stored by row, with values in {0, 0.25, ..., 4}.
+inline void random_documents(const size_t ndocs, const size_t nfeatures,
+                             std::vector<quickrank::Feature> &docs) {
+  docs.resize(ndocs * nfeatures);
+  for (auto &x: docs)
+    x = (float) (rand() % 17) / 4.0f;
+}
+
+}  // namespace random_trees
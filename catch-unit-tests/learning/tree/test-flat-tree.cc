@@ -0,0 +1,54 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "learning/tree/flat_tree.h"
+#include "random_trees.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace random_trees;
+
+TEST_CASE( "Testing FlatTree", "[learning][tree][flat]" ) {
+  srand(3);
+  const size_t nfeatures = 10;
+  const size_t ndocs = 100;
+  std::vector<quickrank::Feature> docs(ndocs * nfeatures);
+  for (auto &x: docs)
+    x = (float) (rand() % 17) / 4.0f;
+
+  for (size_t nleaves = 1; nleaves <= 100; nleaves += 9) {
+    RTNode *root = random_tree_with_leaves(nleaves, nfeatures);
+    FlatTree flat(root);
+    REQUIRE( flat.num_leaves() == nleaves );
+    REQUIRE( flat.num_nodes() == nleaves - 1 );
+    // documents stored both by row and by column
+    for (size_t i = 0; i < ndocs; ++i)
+      REQUIRE( flat.score_instance(&docs[i * nfeatures], 1)
+                   == root->score_instance(&docs[i * nfeatures], 1) );
+    for (size_t i = 0; i < ndocs / nfeatures; ++i)
+      REQUIRE( flat.score_instance(&docs[i], ndocs / nfeatures)
+                   == root->score_instance(&docs[i], ndocs / nfeatures) );
+    delete root;
+  }
+}
@@ -0,0 +1,170 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "data/dataset.h"
+#include "data/vertical_dataset.h"
+#include "learning/tree/rt.h"
+#include "learning/tree/rtnode_histogram.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const size_t nvalues = 17;
+
+/// A training set whose features take few distinct values, binned with one
+/// threshold per value as Mart::init does.
+struct TrainingSet {
+  std::shared_ptr<quickrank::data::VerticalDataset> vertical;
+  std::vector<double> pseudoresponses;
+  std::vector<size_t> sampleids;
+  std::vector<std::vector<float>> thresholds;
+  std::vector<float *> threshold_ptrs;
+  std::vector<size_t> thresholds_size;
+
+  TrainingSet(size_t ndocs, size_t nfeatures) {
+    auto dataset = std::make_shared<quickrank::data::Dataset>(ndocs,
+                                                              nfeatures);
+    for (size_t i = 0; i < ndocs; ++i) {
+      std::vector<quickrank::Feature> features(nfeatures);
+      for (size_t f = 0; f < nfeatures; ++f)
+        features[f] = (rand() % nvalues) * 0.25f;
+      dataset->addInstance(i / 10, rand() % 5, features);
+      pseudoresponses.push_back((double) rand() / RAND_MAX - 0.5
+                                + features[0]);
+      sampleids.push_back(i);
+    }
+    vertical = std::make_shared<quickrank::data::VerticalDataset>(dataset);
+
+    thresholds.resize(nfeatures);
+    for (size_t f = 0; f < nfeatures; ++f) {
+      for (size_t v = 0; v < nvalues; ++v)
+        thresholds[f].push_back(v * 0.25f);
+      thresholds[f].push_back(FLT_MAX);
+      threshold_ptrs.push_back(thresholds[f].data());
+      thresholds_size.push_back(thresholds[f].size());
+    }
+  }
+
+  /// Grows a tree on all the samples with the given policy.
+  RegressionTree *fit(size_t nleaves, size_t max_depth,
+                      RegressionTree::GrowthPolicy policy) {
+    RTRootHistogram hist(vertical.get(), threshold_ptrs.data(),
+                         thresholds_size.data());
+    hist.update(pseudoresponses.data(), sampleids.size(), sampleids.data());
+    RegressionTree *tree = new RegressionTree(nleaves, vertical.get(),
+                                              pseudoresponses.data(), 2, 0.0f,
+                                              policy, max_depth);
+    tree->fit(&hist, sampleids.data(), 1.0f);
+    tree->update_output(pseudoresponses.data());
+    return tree;
+  }
+
+  /// Returns the leaf reached by a training sample.
+  RTNode const *route(RTNode const *node, size_t sampleid) {
+    while (!node->is_leaf())
+      node = *vertical->at(sampleid, node->get_feature_idx())
+          <= node->threshold ? node->left : node->right;
+    return node;
+  }
+};
+
+/// Collects the leaves from left to right and returns the tree depth.
+size_t collect_leaves(RTNode const *node, std::vector<RTNode const *> &leaves) {
+  if (node->is_leaf()) {
+    leaves.push_back(node);
+    return 0;
+  }
+  const size_t ldepth = collect_leaves(node->left, leaves);
+  const size_t rdepth = collect_leaves(node->right, leaves);
+  return 1 + std::max(ldepth, rdepth);
+}
+
+}  // namespace
+
+TEST_CASE( "Testing level-wise growth", "[learning][tree][levelwise]" ) {
+  srand(11);
+  const size_t ndocs = 2000;
+  TrainingSet training(ndocs, 6);
+
+  const size_t configs[][2] = {{64, 3}, {5, 4}, {16, 6}, {2, 1}};
+  for (auto config : configs) {
+    const size_t nleaves = config[0];
+    const size_t max_depth = config[1];
+    std::unique_ptr<RegressionTree> tree(training.fit(
+        nleaves, max_depth, RegressionTree::GrowthPolicy::LEVEL_WISE));
+
+    std::vector<RTNode const *> leaves;
+    const size_t depth = collect_leaves(tree->get_proot(), leaves);
+    REQUIRE( depth <= max_depth );
+    REQUIRE( leaves.size() <= nleaves );
+    REQUIRE( leaves.size() > 1 );
+
+    // the leaves, from left to right, cover the root samples without gaps
+    size_t begin = 0;
+    for (auto leaf : leaves) {
+      REQUIRE( leaf->sample_begin == begin );
+      REQUIRE( leaf->sample_end > leaf->sample_begin );
+      begin = leaf->sample_end;
+    }
+    REQUIRE( begin == ndocs );
+
+    // every sample reaches the leaf that holds it
+    std::vector<size_t> leaf_of(ndocs, leaves.size());
+    for (size_t i = 0; i < ndocs; ++i) {
+      RTNode const *leaf = training.route(tree->get_proot(), i);
+      for (size_t l = 0; l < leaves.size(); ++l)
+        if (leaves[l] == leaf)
+          leaf_of[i] = l;
+    }
+    std::vector<size_t> leaf_size(leaves.size(), 0);
+    for (size_t i = 0; i < ndocs; ++i) {
+      REQUIRE( leaf_of[i] < leaves.size() );
+      ++leaf_size[leaf_of[i]];
+    }
+    for (size_t l = 0; l < leaves.size(); ++l)
+      REQUIRE( leaf_size[l] == leaves[l]->sample_end - leaves[l]->sample_begin );
+  }
+
+  // a single level is the best split of the root, as with best-first growth
+  std::unique_ptr<RegressionTree> level_wise(training.fit(
+      64, 1, RegressionTree::GrowthPolicy::LEVEL_WISE));
+  std::unique_ptr<RegressionTree> best_first(training.fit(
+      2, 0, RegressionTree::GrowthPolicy::BEST_FIRST));
+  RTNode const *lw = level_wise->get_proot();
+  RTNode const *bf = best_first->get_proot();
+  REQUIRE( !lw->is_leaf() );
+  REQUIRE( !bf->is_leaf() );
+  REQUIRE( lw->get_feature_idx() == bf->get_feature_idx() );
+  REQUIRE( lw->threshold == bf->threshold );
+  REQUIRE( lw->left->is_leaf() );
+  REQUIRE( lw->right->is_leaf() );
+  REQUIRE( lw->left->sample_end == bf->left->sample_end );
+  REQUIRE( lw->right->sample_end == bf->right->sample_end );
+  REQUIRE( lw->left->avglabel == bf->left->avglabel );
+  REQUIRE( lw->right->avglabel == bf->right->avglabel );
+}
@@ -0,0 +1,123 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "learning/tree/ensemble.h"
+#include "learning/tree/oblivious_scorer.h"
+#include "learning/tree/quickscorer.h"
+#include "random_trees.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace random_trees;
+
+TEST_CASE( "Testing ObliviousScorer", "[learning][tree][oblivious]" ) {
+  srand(7);
+  const size_t nfeatures = 10;
+  const size_t ntrees = 50;
+  Ensemble ensemble;
+  ensemble.set_capacity(ntrees);
+  for (size_t t = 0; t < ntrees; ++t)
+    ensemble.push(random_oblivious_tree(t % 11, nfeatures), 0.1 + t % 3,
+                  0.0f);
+  REQUIRE( ObliviousScorer::is_supported(ensemble) );
+
+  // the number of documents is not a multiple of the lockstep, and missing
+  // values go right as in the pointer traversal
+  std::vector<quickrank::Feature> docs;
+  const size_t ndocs = 1003;
+  random_documents(ndocs, nfeatures, docs);
+  for (size_t i = 0; i < docs.size(); i += 97)
+    docs[i] = NAN;
+
+  ObliviousScorer scorer(ensemble);
+  REQUIRE( scorer.num_trees() == ntrees );
+  std::vector<quickrank::Score> scores(ndocs);
+  scorer.score(docs.data(), ndocs, nfeatures, scores.data());
+  for (size_t i = 0; i < ndocs; ++i)
+    REQUIRE( scores[i] == ensemble.score_instance(&docs[i * nfeatures]) );
+
+  // nodes of the same level must share feature and threshold
+  Ensemble skewed;
+  skewed.set_capacity(1);
+  skewed.push(new RTNode(1.0f, 0, 1, random_oblivious_tree(1, nfeatures),
+                         new RTNode(1.0)), 1.0, 0.0f);
+  REQUIRE( !ObliviousScorer::is_supported(skewed) );
+  Ensemble mixed;
+  mixed.set_capacity(1);
+  mixed.push(new RTNode(1.0f, 0, 1, new RTNode(1.0f, 1, 2, new RTNode(1.0),
+                                               new RTNode(2.0)),
+                        new RTNode(1.0f, 2, 3, new RTNode(3.0),
+                                   new RTNode(4.0))), 1.0, 0.0f);
+  REQUIRE( !ObliviousScorer::is_supported(mixed) );
+}
+
+TEST_CASE( "Benchmarking ObliviousScorer", "[.][benchmark][oblivious]" ) {
+  srand(7);
+  const size_t nfeatures = 136;
+  const size_t ntrees = 1000;
+  const size_t ndocs = 10000;
+  const size_t depth = 6;
+  Ensemble ensemble;
+  ensemble.set_capacity(ntrees);
+  for (size_t t = 0; t < ntrees; ++t)
+    ensemble.push(random_oblivious_tree(depth, nfeatures), 0.1, 0.0f);
+
+  std::vector<quickrank::Feature> docs;
+  random_documents(ndocs, nfeatures, docs);
+  std::vector<quickrank::Score> scores(ndocs), qs_scores(ndocs),
+      oblivious_scores(ndocs);
+
+  auto begin = std::chrono::high_resolution_clock::now();
+  ensemble.score(docs.data(), ndocs, nfeatures, scores.data());
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> pointers = end - begin;
+
+  QuickScorer qs(ensemble);
+  begin = std::chrono::high_resolution_clock::now();
+  qs.score(docs.data(), ndocs, nfeatures, qs_scores.data());
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> quickscorer = end - begin;
+  REQUIRE( qs_scores == scores );
+
+  ObliviousScorer scorer(ensemble);
+  begin = std::chrono::high_resolution_clock::now();
+  scorer.score(docs.data(), ndocs, nfeatures, oblivious_scores.data());
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> oblivious = end - begin;
+  REQUIRE( oblivious_scores == scores );
+
+  std::cout << "# " << ndocs << " documents, " << ntrees
+            << " oblivious trees of depth " << depth << std::endl
+            << "# blocked pointer traversal: "
+            << pointers.count() / ndocs * 1e6 << " us/doc" << std::endl
+            << "# QuickScorer: " << quickscorer.count() / ndocs * 1e6
+            << " us/doc" << std::endl
+            << "# ObliviousScorer (" << ObliviousScorer::kernel_name()
+            << "): " << oblivious.count() / ndocs * 1e6
+            << " us/doc (speed-up " << pointers.count() / oblivious.count()
+            << "x)" << std::endl;
+}
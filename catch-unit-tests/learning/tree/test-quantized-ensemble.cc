@@ -0,0 +1,78 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "learning/tree/ensemble.h"
+#include "learning/tree/quantized_ensemble.h"
+#include "random_trees.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+using namespace random_trees;
+
+TEST_CASE( "Testing QuantizedEnsemble", "[learning][tree][quantized]" ) {
+  srand(7);
+  const size_t nfeatures = 10;
+  const size_t ntrees = 50;
+  Ensemble ensemble;
+  ensemble.set_capacity(ntrees);
+  size_t ensemble_bytes = 0;
+  for (size_t t = 0; t < ntrees; ++t) {
+    ensemble.push(random_tree_with_depth(8, nfeatures, 4, -5.0),
+                  0.1 + t % 3, 0.0f);
+    ensemble_bytes += ensemble.getFlatTree(t)->num_bytes();
+  }
+  REQUIRE( QuantizedEnsemble::is_supported(ensemble) );
+
+  // values equal to the thresholds, between them, out of their range, NaN
+  const size_t ndocs = 301;
+  std::vector<quickrank::Feature> docs(ndocs * nfeatures);
+  for (auto &x: docs)
+    x = (float) (rand() % 19 - 1) / 4.0f;
+  docs[0] = std::numeric_limits<quickrank::Feature>::quiet_NaN();
+  docs[1] = std::numeric_limits<quickrank::Feature>::infinity();
+
+  std::vector<quickrank::Score> exact(ndocs), scores(ndocs);
+  for (size_t i = 0; i < ndocs; ++i)
+    exact[i] = ensemble.score_instance(&docs[i * nfeatures]);
+
+  // the same leaves are reached, only their rounding differs
+  QuantizedEnsemble float32(ensemble,
+                            QuantizedEnsemble::LeafType::FLOAT32);
+  REQUIRE( float32.num_trees() == ntrees );
+  REQUIRE( float32.num_bytes() < ensemble_bytes );
+  float32.score(docs.data(), ndocs, nfeatures, scores.data());
+  for (size_t i = 0; i < ndocs; ++i)
+    REQUIRE( std::fabs(scores[i] - exact[i]) < 1e-4 );
+
+  // an int16 leaf is off by at most half of the scale of its tree, i.e.,
+  // 1/65534 of the largest leaf (5 * 2.1)
+  QuantizedEnsemble int16(ensemble, QuantizedEnsemble::LeafType::INT16);
+  REQUIRE( int16.num_bytes() < float32.num_bytes() );
+  int16.score(docs.data(), ndocs, nfeatures, scores.data());
+  for (size_t i = 0; i < ndocs; ++i)
+    REQUIRE( std::fabs(scores[i] - exact[i])
+                 < ntrees * 5.0 * 2.1 / 65534.0 + 1e-4 );
+}
@@ -0,0 +1,139 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "learning/tree/ensemble.h"
+#include "learning/tree/quickscorer.h"
+#include "random_trees.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace random_trees;
+
+TEST_CASE( "Testing QuickScorer", "[learning][tree][quickscorer]" ) {
+  srand(3);
+  const size_t nfeatures = 10;
+  const size_t ntrees = 50;
+  Ensemble ensemble;
+  ensemble.set_capacity(ntrees);
+  for (size_t t = 0; t < ntrees; ++t) {
+    const size_t nleaves = t == 0 ? 1 : 1 + rand() % QuickScorer::MAX_LEAVES;
+    ensemble.push(random_tree_with_leaves(nleaves, nfeatures),
+                  0.1 + t % 3, 0.0f);
+  }
+  REQUIRE( QuickScorer::is_supported(ensemble) );
+
+  std::vector<quickrank::Feature> docs;
+  const size_t ndocs = 1000;
+  random_documents(ndocs, nfeatures, docs);
+  // NaN values fail every test and go right, as in the trees
+  for (size_t i = 0; i < ndocs; i += 7)
+    docs[i * nfeatures + i % nfeatures] =
+        std::numeric_limits<quickrank::Feature>::quiet_NaN();
+
+  // a single block of trees, several blocks, and blocked pointer traversal
+  QuickScorer scorer(ensemble);
+  QuickScorer blocked_scorer(ensemble, 7);
+  REQUIRE( blocked_scorer.num_blocks() == 8 );
+  std::vector<quickrank::Score> scores(ndocs), blocked_scores(ndocs),
+      ensemble_scores(ndocs);
+  scorer.score(docs.data(), ndocs, nfeatures, scores.data());
+  blocked_scorer.score(docs.data(), ndocs, nfeatures, blocked_scores.data());
+  ensemble.score(docs.data(), ndocs, nfeatures, ensemble_scores.data());
+  for (size_t i = 0; i < ndocs; ++i) {
+    const quickrank::Score score =
+        ensemble.score_instance(&docs[i * nfeatures]);
+    REQUIRE( scores[i] == score );
+    REQUIRE( blocked_scores[i] == score );
+    REQUIRE( ensemble_scores[i] == score );
+  }
+
+  // trees larger than a bitvector are not supported
+  Ensemble large;
+  large.set_capacity(1);
+  large.push(random_tree_with_leaves(QuickScorer::MAX_LEAVES + 1, nfeatures),
+             1.0, 0.0f);
+  REQUIRE( !QuickScorer::is_supported(large) );
+}
+
+TEST_CASE( "Benchmarking QuickScorer", "[.][benchmark][quickscorer]" ) {
+  srand(3);
+  const size_t nfeatures = 136;
+  const size_t ntrees = 1000;
+  const size_t ndocs = 10000;
+  Ensemble ensemble;
+  ensemble.set_capacity(ntrees);
+  for (size_t t = 0; t < ntrees; ++t)
+    ensemble.push(random_tree_with_leaves(QuickScorer::MAX_LEAVES, nfeatures),
+                  0.1, 0.0f);
+
+  std::vector<quickrank::Feature> docs;
+  random_documents(ndocs, nfeatures, docs);
+  std::vector<quickrank::Score> scores(ndocs);
+
+  auto begin = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < ndocs; ++i)
+    scores[i] = ensemble.score_instance(&docs[i * nfeatures]);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> pointers = end - begin;
+
+  QuickScorer scorer(ensemble);
+  std::vector<uint64_t> leafidx(scorer.num_trees());
+  begin = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < ndocs; ++i)
+    REQUIRE( scores[i] == scorer.score_instance(&docs[i * nfeatures],
+                                                nfeatures, leafidx.data()) );
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> quickscorer = end - begin;
+
+  // blocks of documents against blocks of trees
+  std::vector<quickrank::Score> blocked_scores(ndocs);
+  begin = std::chrono::high_resolution_clock::now();
+  ensemble.score(docs.data(), ndocs, nfeatures, blocked_scores.data());
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> blocked_pointers = end - begin;
+
+  QuickScorer blocked_scorer(ensemble);
+  begin = std::chrono::high_resolution_clock::now();
+  blocked_scorer.score(docs.data(), ndocs, nfeatures, blocked_scores.data());
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> blocked_quickscorer = end - begin;
+  REQUIRE( blocked_scores == scores );
+
+  std::cout << "# " << ndocs << " documents, " << ntrees << " trees of "
+            << QuickScorer::MAX_LEAVES << " leaves" << std::endl
+            << "# pointer traversal: " << pointers.count() / ndocs * 1e6
+            << " us/doc" << std::endl
+            << "# QuickScorer: " << quickscorer.count() / ndocs * 1e6
+            << " us/doc (speed-up " << pointers.count() / quickscorer.count()
+            << "x)" << std::endl
+            << "# blocked traversal: "
+            << blocked_pointers.count() / ndocs * 1e6 << " us/doc"
+            << std::endl
+            << "# blocked QuickScorer, " << blocked_scorer.num_blocks()
+            << " blocks: " << blocked_quickscorer.count() / ndocs * 1e6
+            << " us/doc" << std::endl;
+}
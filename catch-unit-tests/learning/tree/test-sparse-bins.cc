@@ -0,0 +1,226 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "data/dataset.h"
+#include "data/vertical_dataset.h"
+#include "learning/forests/mart.h"
+#include "learning/tree/rt.h"
+#include "learning/tree/rtnode_histogram.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+
+const size_t nvalues = 25;
+
+/// Returns a value in [-2, 4], zero with probability 1 - \a density.
+/// Labels and values are multiples of 0.25, so that any sum of them is
+/// exact and sparse histograms must match dense ones bit by bit.
+quickrank::Feature random_value(double density) {
+  if ((double) rand() / RAND_MAX >= density)
+    return 0.0f;
+  return (rand() % nvalues) * 0.25f - 2.0f;
+}
+
+std::shared_ptr<quickrank::data::Dataset> random_dataset(size_t ndocs,
+                                                         size_t nfeatures) {
+  auto dataset = std::make_shared<quickrank::data::Dataset>(ndocs, nfeatures);
+  for (size_t i = 0; i < ndocs; ++i) {
+    std::vector<quickrank::Feature> features(nfeatures);
+    // the density changes across features, and the first one is dense
+    for (size_t f = 0; f < nfeatures; ++f)
+      features[f] = random_value(f ? 0.02 + 0.2 * f / nfeatures : 1.0);
+    dataset->addInstance(i / 20, rand() % 5, features);
+  }
+  return dataset;
+}
+
+/// One threshold per value, as Mart::init does without --num-thresholds.
+struct Thresholds {
+  std::vector<std::vector<float>> values;
+  std::vector<float *> ptrs;
+  std::vector<size_t> sizes;
+
+  Thresholds(size_t nfeatures) : values(nfeatures) {
+    for (size_t f = 0; f < nfeatures; ++f) {
+      for (size_t v = 0; v < nvalues; ++v)
+        values[f].push_back(v * 0.25f - 2.0f);
+      values[f].push_back(FLT_MAX);
+      ptrs.push_back(values[f].data());
+      sizes.push_back(values[f].size());
+    }
+  }
+};
+
+/// Exposes the thresholds computed by Mart::init.
+class ThresholdsMart: public quickrank::learning::forests::Mart {
+ public:
+  ThresholdsMart(size_t nthresholds)
+      : Mart(1, 0.1, nthresholds, 8, 1, 1.0f, 1.0f, 0, 0.0f) {
+  }
+
+  void init(std::shared_ptr<quickrank::data::VerticalDataset> dataset) {
+    Mart::init(dataset);
+  }
+
+  std::vector<float> thresholds(size_t f) const {
+    return std::vector<float>(thresholds_[f],
+                              thresholds_[f] + thresholds_size_[f]);
+  }
+};
+
+void require_same_histograms(RTNodeHistogram const *dense,
+                             RTNodeHistogram const *sparse) {
+  REQUIRE( dense->squares_sum_ == sparse->squares_sum_ );
+  for (size_t f = 0; f < dense->nfeatures; ++f)
+    for (size_t t = 0; t < dense->thresholds_size[f]; ++t) {
+      REQUIRE( dense->count[f][t] == sparse->count[f][t] );
+      REQUIRE( dense->sumlbl[f][t] == sparse->sumlbl[f][t] );
+    }
+}
+
+void require_same_trees(RTNode const *dense, RTNode const *sparse) {
+  REQUIRE( dense->is_leaf() == sparse->is_leaf() );
+  REQUIRE( dense->sample_begin == sparse->sample_begin );
+  REQUIRE( dense->sample_end == sparse->sample_end );
+  REQUIRE( dense->avglabel == sparse->avglabel );
+  if (!dense->is_leaf()) {
+    REQUIRE( dense->get_feature_idx() == sparse->get_feature_idx() );
+    REQUIRE( dense->threshold == sparse->threshold );
+    require_same_trees(dense->left, sparse->left);
+    require_same_trees(dense->right, sparse->right);
+  }
+}
+
+}  // namespace
+
+TEST_CASE( "Testing sparse vertical dataset", "[data][sparse]" ) {
+  srand(3);
+  const size_t ndocs = 500;
+  const size_t nfeatures = 20;
+  auto dataset = random_dataset(ndocs, nfeatures);
+  quickrank::data::VerticalDataset dense(dataset);
+  quickrank::data::VerticalDataset sparse(dataset, true);
+  REQUIRE( !dense.is_sparse() );
+  REQUIRE( sparse.is_sparse() );
+  REQUIRE( sparse.num_instances() == ndocs );
+  REQUIRE( sparse.num_queries() == dense.num_queries() );
+
+  for (size_t f = 0; f < nfeatures; ++f) {
+    std::vector<uint32_t> documents;
+    std::vector<quickrank::Feature> values;
+    for (size_t i = 0; i < ndocs; ++i)
+      if (*dense.at(i, f) != 0.0f) {
+        documents.push_back(i);
+        values.push_back(*dense.at(i, f));
+      }
+    REQUIRE( sparse.num_nonzeros(f) == documents.size() );
+    REQUIRE( std::equal(documents.begin(), documents.end(),
+                        sparse.nonzero_documents(f)) );
+    REQUIRE( std::equal(values.begin(), values.end(),
+                        sparse.nonzero_values(f)) );
+  }
+
+  // the thresholds only depend on the distinct values
+  for (size_t nthresholds : {0, 8}) {
+    ThresholdsMart dense_mart(nthresholds), sparse_mart(nthresholds);
+    dense_mart.init(std::make_shared<quickrank::data::VerticalDataset>(
+        dataset));
+    sparse_mart.init(std::make_shared<quickrank::data::VerticalDataset>(
+        dataset, true));
+    for (size_t f = 0; f < nfeatures; ++f)
+      REQUIRE( dense_mart.thresholds(f) == sparse_mart.thresholds(f) );
+  }
+}
+
+TEST_CASE( "Testing sparse bins", "[learning][tree][sparse]" ) {
+  srand(7);
+  const size_t ndocs = 3000;
+  const size_t nfeatures = 30;
+  auto dataset = random_dataset(ndocs, nfeatures);
+  quickrank::data::VerticalDataset dense_data(dataset);
+  quickrank::data::VerticalDataset sparse_data(dataset, true);
+  Thresholds thresholds(nfeatures);
+
+  RTRootHistogram dense(&dense_data, thresholds.ptrs.data(),
+                        thresholds.sizes.data());
+  RTRootHistogram sparse(&sparse_data, thresholds.ptrs.data(),
+                         thresholds.sizes.data());
+  REQUIRE( !dense.bins->is_sparse() );
+  REQUIRE( sparse.bins->is_sparse() );
+  REQUIRE( sparse.bins->memory_usage() < dense.bins->memory_usage() );
+  for (size_t f = 0; f < nfeatures; ++f) {
+    REQUIRE( sparse.bins->num_entries(f) <= sparse_data.num_nonzeros(f) );
+    for (size_t i = 0; i < ndocs; ++i)
+      REQUIRE( dense.bins->get(f, i) == sparse.bins->get(f, i) );
+  }
+
+  std::vector<double> labels(ndocs);
+  for (size_t i = 0; i < ndocs; ++i)
+    labels[i] = (rand() % 17) * 0.25 - 2.0 + *dense_data.at(i, 0);
+
+  // a subsample in random order
+  std::vector<size_t> sampleids(ndocs);
+  for (size_t i = 0; i < ndocs; ++i)
+    sampleids[i] = i;
+  std::random_shuffle(sampleids.begin(), sampleids.end());
+  const size_t nsamples = ndocs * 3 / 4;
+  dense.update(labels.data(), nsamples, sampleids.data());
+  sparse.update(labels.data(), nsamples, sampleids.data());
+  require_same_histograms(&dense, &sparse);
+
+  // children of several nodes at once
+  std::vector<RTNodeHistogram const *> dense_parents = {&dense, &dense};
+  std::vector<RTNodeHistogram const *> sparse_parents = {&sparse, &sparse};
+  std::vector<size_t const *> children = {sampleids.data(),
+                                          sampleids.data() + 100};
+  std::vector<size_t> nchildren = {100, nsamples - 100};
+  std::vector<RTNodeHistogram *> dense_children = RTNodeHistogram::build(
+      dense_parents, children, nchildren, labels.data());
+  std::vector<RTNodeHistogram *> sparse_children = RTNodeHistogram::build(
+      sparse_parents, children, nchildren, labels.data());
+  for (size_t n = 0; n < children.size(); ++n) {
+    require_same_histograms(dense_children[n], sparse_children[n]);
+    delete dense_children[n];
+    delete sparse_children[n];
+  }
+
+  // sparse bins do not change the trees
+  for (auto policy : {RegressionTree::GrowthPolicy::BEST_FIRST,
+                      RegressionTree::GrowthPolicy::LEVEL_WISE}) {
+    RegressionTree dense_tree(12, &dense_data, labels.data(), 5, 0.0f,
+                              policy, 5);
+    RegressionTree sparse_tree(12, &sparse_data, labels.data(), 5, 0.0f,
+                               policy, 5);
+    dense_tree.fit(&dense, sampleids.data(), 1.0f);
+    sparse_tree.fit(&sparse, sampleids.data(), 1.0f);
+    dense_tree.update_output(labels.data());
+    sparse_tree.update_output(labels.data());
+    REQUIRE( !dense_tree.get_proot()->is_leaf() );
+    require_same_trees(dense_tree.get_proot(), sparse_tree.get_proot());
+  }
+}
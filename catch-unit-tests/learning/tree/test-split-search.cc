@@ -0,0 +1,136 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "learning/tree/split_search.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+/// Builds the cumulative histogram of a random feature. Few distinct labels
+/// and empty bins produce many ties among the split scores.
+void random_histogram(size_t nthresholds, std::vector<double> &sumlbl,
+                      std::vector<size_t> &count) {
+  sumlbl.assign(nthresholds, 0.0);
+  count.assign(nthresholds, 0);
+  double s = 0.0;
+  size_t c = 0;
+  for (size_t t = 0; t < nthresholds; ++t) {
+    const size_t n = rand() % 4 == 0 ? 0 : rand() % 20;
+    c += n;
+    s += n * (double) (rand() % 3);
+    sumlbl[t] = s;
+    count[t] = c;
+  }
+}
+
+}  // namespace
+
+TEST_CASE( "Testing split search kernels", "[learning][tree][split]" ) {
+  srand(3);
+  std::vector<double> sumlbl;
+  std::vector<size_t> count;
+  // kernels supported by the compilation target, plus the dispatched one
+  std::vector<split_search::Kernel> kernels = {split_search::best_kernel()};
+#ifdef __AVX2__
+  kernels.push_back(split_search::best_split_avx2);
+#endif
+#ifdef __AVX512F__
+  kernels.push_back(split_search::best_split_avx512);
+#endif
+
+  for (size_t nthresholds = 1; nthresholds < 300; nthresholds += 7) {
+    for (size_t minls = 1; minls <= 64; minls *= 4) {
+      random_histogram(nthresholds, sumlbl, count);
+      for (double initial: {-1.0, 0.0, 1e10}) {
+        double scalar_score = initial;
+        const size_t scalar_t = split_search::best_split_scalar(
+            sumlbl.data(), count.data(), nthresholds, minls, scalar_score);
+        for (split_search::Kernel kernel: kernels) {
+          double kernel_score = initial;
+          const size_t kernel_t = kernel(
+              sumlbl.data(), count.data(), nthresholds, minls, kernel_score);
+          REQUIRE( scalar_t == kernel_t );
+          REQUIRE( scalar_score == kernel_score );
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE( "Testing per-thread best splits", "[learning][tree][split]" ) {
+  split_search::ThreadBestSplits thread_best;
+  split_search::ThreadBestSplit *entries = thread_best.reset(4, -1.0);
+  // every thread updates its own cache line
+  REQUIRE( sizeof(split_search::ThreadBestSplit) == 64 );
+  REQUIRE( (uintptr_t) entries % 64 == 0 );
+  for (size_t i = 0; i < 4; ++i) {
+    REQUIRE( entries[i].score == -1.0 );
+    REQUIRE( entries[i].featureidx == (size_t) -1 );
+    REQUIRE( entries[i].thresholdid == (size_t) -1 );
+    entries[i].score = 1.0;
+  }
+  // fewer threads reuse the same entries, reset
+  REQUIRE( thread_best.reset(2, -1.0) == entries );
+  REQUIRE( entries[1].score == -1.0 );
+  REQUIRE( (uintptr_t) thread_best.reset(8, -1.0) % 64 == 0 );
+}
+
+TEST_CASE( "Benchmarking split search kernels", "[.][benchmark][split]" ) {
+  srand(3);
+  const size_t nfeatures = 136;
+  const size_t nrounds = 200;
+  std::vector<std::vector<double>> sumlbl(nfeatures);
+  std::vector<std::vector<size_t>> count(nfeatures);
+  for (size_t f = 0; f < nfeatures; ++f)
+    random_histogram(1024, sumlbl[f], count[f]);
+
+  auto run = [&](split_search::Kernel kernel) {
+    size_t checksum = 0;
+    auto begin = std::chrono::high_resolution_clock::now();
+    for (size_t r = 0; r < nrounds; ++r) {
+      double best_score = -1.0;
+      for (size_t f = 0; f < nfeatures; ++f)
+        checksum += kernel(sumlbl[f].data(), count[f].data(),
+                           sumlbl[f].size(), 1, best_score);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed = end - begin;
+    return std::make_pair(elapsed.count(), checksum);
+  };
+
+  auto scalar = run(split_search::best_split_scalar);
+  auto vectorized = run(split_search::best_kernel());
+  REQUIRE( scalar.second == vectorized.second );
+
+  std::cout << "# split search on " << nfeatures << " x 1024 thresholds, "
+            << nrounds << " rounds" << std::endl
+            << "# scalar: " << scalar.first << " s" << std::endl
+            << "# " << split_search::best_kernel_name() << ": "
+            << vectorized.first << " s (speed-up "
+            << scalar.first / vectorized.first << "x)" << std::endl;
+}
@@ -0,0 +1,77 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "learning/tree/ensemble.h"
+#include "random_trees.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace random_trees;
+
+TEST_CASE( "Testing Ensemble top-k scoring", "[learning][tree][top-k]" ) {
+  srand(11);
+  const size_t nfeatures = 8;
+  const size_t ntrees = 40;
+  Ensemble ensemble;
+  ensemble.set_capacity(ntrees);
+  // a few strong trees first, then many weak ones with small bounds
+  for (size_t t = 0; t < ntrees; ++t)
+    ensemble.push(random_tree_with_depth(4, nfeatures, 0, -5.0),
+                  t < 5 ? 1.0 : 0.01, 0.0f);
+
+  const size_t ndocs = 500;
+  std::vector<quickrank::Feature> docs(ndocs * nfeatures);
+  for (auto &x: docs)
+    x = (float) (rand() % 17) / 4.0f;
+
+  std::vector<quickrank::Score> exact(ndocs);
+  for (size_t i = 0; i < ndocs; ++i)
+    exact[i] = ensemble.score_instance(&docs[i * nfeatures]);
+  std::vector<quickrank::Score> sorted(exact);
+  std::sort(sorted.begin(), sorted.end(), std::greater<quickrank::Score>());
+
+  const size_t k = 10;
+  std::vector<quickrank::Score> scores(ndocs);
+  size_t npruned = 0;
+  const size_t evaluations = ensemble.score_top_k(
+      docs.data(), ndocs, nfeatures, k, 5, 1.0, scores.data(), npruned);
+
+  // exact bounds: something is pruned and the top k is untouched
+  REQUIRE( npruned > 0 );
+  REQUIRE( evaluations < ndocs * ntrees );
+  for (size_t i = 0; i < ndocs; ++i) {
+    if (exact[i] >= sorted[k - 1])
+      REQUIRE( scores[i] == exact[i] );
+    else
+      REQUIRE( scores[i] <= sorted[k - 1] );
+  }
+
+  // without a k every document is fully scored
+  ensemble.score_top_k(docs.data(), ndocs, nfeatures, 0, 5, 1.0,
+                       scores.data(), npruned);
+  REQUIRE( npruned == 0 );
+  for (size_t i = 0; i < ndocs; ++i)
+    REQUIRE( scores[i] == exact[i] );
+}
@@ -0,0 +1,106 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include "learning/tree/ensemble.h"
+#include "learning/tree/vpred.h"
+#include "random_trees.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace random_trees;
+
+TEST_CASE( "Testing VPred", "[learning][tree][vpred]" ) {
+  srand(5);
+  const size_t nfeatures = 10;
+  const size_t ntrees = 60;
+  Ensemble ensemble;
+  ensemble.set_capacity(ntrees);
+  for (size_t t = 0; t < ntrees; ++t)
+    ensemble.push(random_tree_with_depth(t % 12, nfeatures, 4),
+                  0.1 + t % 3, 0.0f);
+  REQUIRE( VPred::is_supported(ensemble) );
+
+  // the number of documents is not a multiple of the lockstep
+  std::vector<quickrank::Feature> docs;
+  const size_t ndocs = 1003;
+  random_documents(ndocs, nfeatures, docs);
+  // NaN values fail every test and go right, as in the trees
+  for (size_t i = 0; i < ndocs; i += 7)
+    docs[i * nfeatures + i % nfeatures] =
+        std::numeric_limits<quickrank::Feature>::quiet_NaN();
+
+  VPred vpred(ensemble);
+  REQUIRE( vpred.num_trees() == ntrees );
+  std::vector<quickrank::Score> scores(ndocs);
+  vpred.score(docs.data(), ndocs, nfeatures, scores.data());
+  for (size_t i = 0; i < ndocs; ++i)
+    REQUIRE( scores[i] == ensemble.score_instance(&docs[i * nfeatures]) );
+
+  // trees deeper than MAX_DEPTH are not supported
+  RTNode *deep = new RTNode(1.0);
+  for (size_t l = 0; l <= VPred::MAX_DEPTH; ++l)
+    deep = new RTNode(1.0f, 0, 1, deep, new RTNode(2.0));
+  Ensemble large;
+  large.set_capacity(1);
+  large.push(deep, 1.0, 0.0f);
+  REQUIRE( !VPred::is_supported(large) );
+}
+
+TEST_CASE( "Benchmarking VPred", "[.][benchmark][vpred]" ) {
+  srand(5);
+  const size_t nfeatures = 136;
+  const size_t ntrees = 1000;
+  const size_t ndocs = 10000;
+  Ensemble ensemble;
+  ensemble.set_capacity(ntrees);
+  for (size_t t = 0; t < ntrees; ++t)
+    ensemble.push(random_tree_with_depth(6, nfeatures, 4), 0.1, 0.0f);
+
+  std::vector<quickrank::Feature> docs;
+  random_documents(ndocs, nfeatures, docs);
+  std::vector<quickrank::Score> scores(ndocs), vpred_scores(ndocs);
+
+  auto begin = std::chrono::high_resolution_clock::now();
+  ensemble.score(docs.data(), ndocs, nfeatures, scores.data());
+  auto end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> pointers = end - begin;
+
+  VPred vpred(ensemble);
+  begin = std::chrono::high_resolution_clock::now();
+  vpred.score(docs.data(), ndocs, nfeatures, vpred_scores.data());
+  end = std::chrono::high_resolution_clock::now();
+  std::chrono::duration<double> vectorized = end - begin;
+  REQUIRE( vpred_scores == scores );
+
+  std::cout << "# " << ndocs << " documents, " << ntrees
+            << " trees of depth at most 6" << std::endl
+            << "# blocked pointer traversal: "
+            << pointers.count() / ndocs * 1e6 << " us/doc" << std::endl
+            << "# VPred (" << VPred::kernel_name() << "): "
+            << vectorized.count() / ndocs * 1e6 << " us/doc (speed-up "
+            << pointers.count() / vectorized.count() << "x)" << std::endl;
+}
@@ -0,0 +1,77 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+
+#include "catch/include/catch.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "metric/ir/incremental_evaluator.h"
+#include "metric/ir/dcg.h"
+#include "metric/ir/ndcg.h"
+#include "metric/ir/rmse.h"
+#include "data/dataset.h"
+
+TEST_CASE( "Testing incremental evaluation", "[metric][incremental]" ) {
+
+  std::mt19937 gen(17);
+  std::uniform_int_distribution<int> label_dist(0, 4);
+  std::uniform_int_distribution<size_t> size_dist(0, 40);
+  std::normal_distribution<double> step_dist(0.0, 0.1);
+
+  std::vector<size_t> offsets = { 0 };
+  for (size_t q = 0; q < 150; ++q)
+    offsets.push_back(offsets.back() + size_dist(gen));
+  const size_t n = offsets.back();
+  std::vector<quickrank::Label> labels(n);
+  for (auto &l: labels)
+    l = label_dist(gen);
+  std::vector<quickrank::Feature> features(n, 0.0f);
+  auto dataset = std::make_shared<quickrank::data::Dataset>(
+      n, 1, features.data(), labels.data(), offsets, std::make_shared<int>(0));
+
+  std::vector<std::shared_ptr<quickrank::metric::ir::Metric>> metrics = {
+      std::make_shared<quickrank::metric::ir::Ndcg>(10),
+      std::make_shared<quickrank::metric::ir::Dcg>(5),
+      std::make_shared<quickrank::metric::ir::Rmse>() };
+
+  for (auto metric: metrics) {
+    quickrank::metric::ir::IncrementalEvaluator evaluator(metric, dataset);
+
+    // scores start all tied, then change a little at a time as in boosting
+    std::vector<quickrank::Score> scores(n, 0.0);
+    for (size_t round = 0; round < 10; ++round) {
+      REQUIRE( evaluator.evaluate(scores.data()) ==
+                   metric->evaluate_dataset(dataset, scores.data()) );
+      for (size_t i = 0; i < n; ++i)
+        scores[i] += (round % 3 == 2) ? 0.0 : step_dist(gen);
+    }
+
+    // unchanged scores do not re-rank any list
+    evaluator.evaluate(scores.data());
+    REQUIRE( evaluator.evaluate(scores.data()) ==
+                 metric->evaluate_dataset(dataset, scores.data()) );
+    if (metric->name() != "RMSE")
+      REQUIRE( evaluator.num_reranked() == 0 );
+  }
+}
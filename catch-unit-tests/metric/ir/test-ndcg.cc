@@ -24,6 +24,7 @@
 
 #include <cmath>
 #include <iomanip>
+#include <vector>
 
 #include "metric/ir/ndcg.h"
 #include "data/dataset.h"
@@ -105,3 +106,50 @@ TEST_CASE( "Testing NDCG", "[metric][ndcg]" ) {
   REQUIRE( Approx(delta_ndcg) == ( pow(2, labels[2])  - pow(2, labels[0]) )/idcg );
 
 }
+
+TEST_CASE( "Testing NDCG swap tables", "[metric][ndcg]" ) {
+
+  quickrank::Label labels[] = { 1, 0, 3, 2, 0, 4, 1, 0 };
+  quickrank::Score scores[] = { 8, 7, 6, 5, 4, 3, 2, 1 };
+  const size_t n = 8;
+  auto results = std::shared_ptr<quickrank::data::QueryResults>(
+      new quickrank::data::QueryResults(n, &labels[0], NULL) );
+  auto ranked = std::shared_ptr<quickrank::data::RankedResults>(
+      new quickrank::data::RankedResults(results, scores));
+
+  // the tables give the same entries of the Jacobian, within the cutoff
+  for (size_t cutoff: {3, 8}) {
+    quickrank::metric::ir::Ndcg ndcg_metric(cutoff);
+    auto jacobian = ndcg_metric.jacobian(ranked);
+    std::vector<double> discounts(n), gains(n);
+    double normalization;
+    const quickrank::metric::ir::DcgTables tables(4, n);
+    REQUIRE( ndcg_metric.swap_tables(*ranked, tables, discounts.data(),
+                                     gains.data(), normalization) );
+    for (size_t i = 0; i < std::min<size_t>(cutoff, n); ++i)
+      for (size_t j = i + 1; j < n; ++j)
+        REQUIRE( (discounts[j] - discounts[i]) * (gains[i] - gains[j])
+                     / normalization == jacobian->at(i, j) );
+  }
+}
+
+TEST_CASE( "Testing NDCG on a dataset", "[metric][ndcg]" ) {
+
+  quickrank::Label labels[] = { 1, 0, 3, 2, 0, 4, 1, 0, 0.5f, 2, 0, 1 };
+  quickrank::Score scores[] = { 8, 7, 6, 5, 4, 3, 2, 1, 1, 1, 2, 0 };
+  std::vector<quickrank::Feature> features(12, 0.0f);
+  std::vector<size_t> offsets = { 0, 8, 8, 12 };
+  auto dataset = std::make_shared<quickrank::data::Dataset>(
+      12, 1, features.data(), labels, offsets, std::make_shared<int>(0));
+
+  // the list kernel matches the average of the lists, bit by bit
+  for (size_t cutoff: {2, 5, 0}) {
+    quickrank::metric::ir::Ndcg ndcg_metric(cutoff);
+    quickrank::MetricScore avg = 0.0;
+    for (size_t q = 0; q < dataset->num_queries(); ++q)
+      avg += ndcg_metric.evaluate_result_list(
+          dataset->getQueryResults(q).get(), scores + offsets[q]);
+    avg /= dataset->num_queries();
+    REQUIRE( ndcg_metric.evaluate_dataset(dataset, scores) == avg );
+  }
+}
@@ -105,3 +105,34 @@ TEST_CASE( "Testing TNDCG", "[metric][tndcg]" ) {
   REQUIRE( Approx(delta_tndcg) == ( pow(2, labels[2])  - pow(2, labels[0]) )/idcg );
 
 }
+
+TEST_CASE( "Testing TNDCG Jacobian in a scratch arena", "[metric][tndcg]" ) {
+  quickrank::Label labels[] = { 1, 0, 3, 2, 0, 4, 1, 0 };
+  quickrank::Score scores[] = { 8, 7, 7, 5, 4, 4, 4, 1 };
+  const size_t n = 8;
+  auto results = std::shared_ptr<quickrank::data::QueryResults>(
+      new quickrank::data::QueryResults(n, &labels[0], NULL) );
+  auto ranked = std::shared_ptr<quickrank::data::RankedResults>(
+      new quickrank::data::RankedResults(results, scores));
+  const quickrank::metric::ir::DcgTables tables(4, n);
+
+  for (size_t cutoff: {3, 8}) {
+    quickrank::metric::ir::Tndcg tndcg_metric(cutoff);
+    auto expected = tndcg_metric.jacobian(ranked);
+    ScratchArena arena;
+    size_t nallocations = 0;
+    for (size_t round = 0; round < 3; ++round) {
+      arena.reset();
+      quickrank::Jacobian jacobian(n, arena.allocate<double>(
+          quickrank::Jacobian::num_elements(n)));
+      tndcg_metric.jacobian(*ranked, tables, arena, jacobian);
+      for (size_t i = 0; i < n; ++i)
+        for (size_t j = i + 1; j < n; ++j)
+          REQUIRE( jacobian.at(i, j) == expected->at(i, j) );
+      // the arena is sized by the first round, and reused by the next ones
+      if (round <= 1)
+        nallocations = arena.num_allocations();
+      REQUIRE( arena.num_allocations() == nallocations );
+    }
+  }
+}
@@ -0,0 +1,61 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "catch/include/catch.hpp"
+
+#include <cstdint>
+
+#include "utils/scratch_arena.h"
+
+TEST_CASE( "Testing ScratchArena", "[utils][scratch]" ) {
+  ScratchArena arena;
+  arena.reserve(1000);
+  REQUIRE( arena.num_allocations() == 1 );
+
+  // arrays are aligned, disjoint, and fit the reserved block
+  double *a = arena.allocate<double>(10);
+  char *b = arena.allocate<char>(3);
+  size_t *c = arena.allocate<size_t>(10);
+  REQUIRE( reinterpret_cast<uintptr_t>(a) % 64 == 0 );
+  REQUIRE( reinterpret_cast<uintptr_t>(b) % 64 == 0 );
+  REQUIRE( reinterpret_cast<uintptr_t>(c) % 64 == 0 );
+  REQUIRE( (char *) (a + 10) <= b );
+  REQUIRE( b + 3 <= (char *) c );
+  REQUIRE( arena.num_allocations() == 1 );
+
+  // exhausted blocks are kept until the next reset, which replaces them
+  // with a single block fitting the peak usage
+  for (size_t i = 0; i < 100; ++i)
+    arena.allocate<double>(100)[99] = 1.0;
+  const size_t allocations = arena.num_allocations();
+  REQUIRE( allocations > 1 );
+  arena.reset();
+  REQUIRE( arena.num_allocations() == allocations + 1 );
+  for (size_t round = 0; round < 10; ++round) {
+    arena.reset();
+    arena.allocate<double>(10);
+    arena.allocate<char>(3);
+    arena.allocate<size_t>(10);
+    for (size_t i = 0; i < 100; ++i)
+      arena.allocate<double>(100)[99] = 1.0;
+  }
+  REQUIRE( arena.num_allocations() == allocations + 1 );
+}
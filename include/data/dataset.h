@@ -50,6 +50,22 @@ class Dataset {
   /// \param n_instances The number of training instances (lines) in the dataset.
   /// \param n_features The number of features.
   Dataset(size_t n_instances, size_t n_features);
+
+  /// Wraps a complete dataset stored in externally owned memory, e.g., a
+  /// memory mapped binary file. No data is copied: \a storage is kept alive
+  /// as long as the dataset (or any \a VerticalDataset sharing it) exists.
+  ///
+  /// \param n_instances The number of training instances in the dataset.
+  /// \param n_features The number of features.
+  /// \param data The row-major feature matrix.
+  /// \param labels The relevance labels.
+  /// \param offsets The offsets of the query results lists (num queries + 1).
+  /// \param storage The owner of the memory pointed by the other arguments.
+  /// \param vertical_data The optional column-major copy of the feature matrix.
+  Dataset(size_t n_instances, size_t n_features,
+          quickrank::Feature *data, quickrank::Label *labels,
+          std::vector<size_t> offsets, std::shared_ptr<void> storage,
+          quickrank::Feature *vertical_data = NULL);
   virtual ~Dataset();
 
   /// Avoid inefficient copy constructor
@@ -71,6 +87,24 @@ class Dataset {
     return labels_[document_id];
   }
 
+  /// Sets the value of the i-th relevance label.
+  ///
+  /// This is meant for readers filling the dataset in place through \a at(),
+  /// which must later call \a setQueryIds() to finalize the dataset.
+  void setLabel(size_t document_id, Label label) {
+    labels_[document_id] = label;
+  }
+
+  /// Returns the labels of the i-th query results list.
+  Label *query_labels(size_t i) const {
+    return labels_ + offsets_[i];
+  }
+
+  /// Returns the offsets of all the query results lists (num queries + 1).
+  const size_t *offsets() const {
+    return offsets_.data();
+  }
+
   /// Returns the offset in the internal data structure of the i-th query
   /// results list.
   ///
@@ -96,6 +130,25 @@ class Dataset {
   void addInstance(QueryID q_id, Label i_label,
                    std::vector<Feature> i_features);
 
+  /// Finalizes a dataset whose instances have been directly written
+  /// through \a at() and \a setLabel(), by rebuilding the query offsets.
+  ///
+  /// \param q_ids The query ID of each instance.
+  /// \param n_instances The number of instances written in the dataset.
+  void setQueryIds(const QueryID *q_ids, size_t n_instances);
+
+  /// Returns the column-major (features x documents) copy of the data
+  /// if it was provided together with the dataset, NULL otherwise.
+  quickrank::Feature *vertical_data() const {
+    return vertical_data_;
+  }
+
+  /// Returns the owner of the external memory wrapped by the dataset,
+  /// or an empty pointer if the dataset allocated its own storage.
+  std::shared_ptr<void> storage() const {
+    return storage_;
+  }
+
   /// Returns the number of features used to represent a document.
   size_t num_features() const {
     return num_features_;
@@ -123,6 +176,9 @@ class Dataset {
   quickrank::Label *labels_ = NULL;
   std::vector<size_t> offsets_;
 
+  quickrank::Feature *vertical_data_ = NULL;
+  std::shared_ptr<void> storage_;
+
   size_t last_instance_id_;
   size_t max_instances_;
 
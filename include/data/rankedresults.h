@@ -25,6 +25,7 @@
 
 #include "types.h"
 #include "queryresults.h"
+#include "utils/scratch_arena.h"
 
 namespace quickrank {
 namespace data {
@@ -47,6 +48,11 @@ class RankedResults {
   /// \param n_instances The number of training instances (lines) in the dataset.
   /// \param n_features The number of features.
   RankedResults(std::shared_ptr<QueryResults> results, Score *scores);
+
+  /// Generates a Ranked Results list whose copies are stored in \a arena,
+  /// and are valid until the arena is reset.
+  RankedResults(const QueryResults &results, const Score *scores,
+                ScratchArena &arena);
   virtual ~RankedResults();
 
   // provide some kinf od unmap function ?
@@ -72,6 +78,7 @@ class RankedResults {
   Score *scores_ = NULL;
   size_t num_results_;
   size_t *unmap_ = NULL;
+  bool owner_ = true;  // of labels_, scores_ and unmap_
 };
 
 }  // namespace data
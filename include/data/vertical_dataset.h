@@ -21,6 +21,7 @@
  */
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <vector>
@@ -42,14 +43,21 @@ namespace data {
  * access the internal representation through the function \a at()
  * to support fast access and custom high performance implementations.
  * Representation is vertical, i.e., a matrix features x documents.
+ *
+ * A sparse dataset stores instead only the non-zero values of every feature,
+ * together with their documents (CSC format): missing values are 0, and
+ * \a at() is not available.
  */
 class VerticalDataset {
  public:
 
   /// Allocates a vertical dataset by copying and transposing an horizontal one.
+  /// If \a h_dataset already carries a column-major copy of its data, this is
+  /// shared without any copy.
   ///
   /// \param h_dataset The horizontal dataset.
-  VerticalDataset(std::shared_ptr<Dataset> h_dataset);
+  /// \param sparse Whether to store only the non-zero values.
+  VerticalDataset(std::shared_ptr<Dataset> h_dataset, bool sparse = false);
   virtual ~VerticalDataset();
 
   /// Avoid inefficient copy constructor
@@ -66,11 +74,44 @@ class VerticalDataset {
     return data_ + document_id + feature_id * num_instances_;
   }
 
+  /// Returns true if only the non-zero values are stored.
+  bool is_sparse() const {
+    return sparse_;
+  }
+
+  /// Returns the number of non-zero values of the f-th feature of a sparse
+  /// dataset.
+  size_t num_nonzeros(size_t f) const {
+    return nonzero_offsets_[f + 1] - nonzero_offsets_[f];
+  }
+
+  /// Returns the (sorted) documents with a non-zero f-th feature in a sparse
+  /// dataset.
+  const uint32_t *nonzero_documents(size_t f) const {
+    return nonzero_documents_.data() + nonzero_offsets_[f];
+  }
+
+  /// Returns the non-zero values of the f-th feature of a sparse dataset,
+  /// in the order of \a nonzero_documents(f).
+  const quickrank::Feature *nonzero_values(size_t f) const {
+    return nonzero_values_.data() + nonzero_offsets_[f];
+  }
+
   /// Returns the value of the i-th relevance label.
   Label getLabel(size_t document_id) {
     return labels_[document_id];
   }
 
+  /// Returns the labels of the i-th query results list.
+  Label *query_labels(size_t i) const {
+    return labels_ + offsets_[i];
+  }
+
+  /// Returns the offsets of all the query results lists (num queries + 1).
+  const size_t *offsets() const {
+    return offsets_.data();
+  }
+
   /// Returns the offset in the internal data strcutures of the i-th query results list.
   ///
   /// \param i The i-th query results list of interest.
@@ -109,6 +150,14 @@ class VerticalDataset {
   quickrank::Label *labels_ = NULL;
   std::vector<size_t> offsets_;
 
+  /// owner of \a data_ when shared with the horizontal dataset
+  std::shared_ptr<void> storage_;
+
+  bool sparse_ = false;
+  std::vector<size_t> nonzero_offsets_;  // [num features + 1]
+  std::vector<uint32_t> nonzero_documents_;
+  std::vector<quickrank::Feature> nonzero_values_;
+
   /// The output stream operator.
   /// Prints the data reading time stats
   friend std::ostream &operator<<(std::ostream &os, const VerticalDataset &me) {
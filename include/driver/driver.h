@@ -110,12 +110,28 @@ class Driver {
   /// If set save the scores computed for the test set.
   /// \param verbose If True saves an SVML-like file with the score of each ranker in the ensemble.
   /// NB. Works only for ensembles.
+  /// \param top_k If not 0, only the top \a top_k results of each query
+  /// are scored exactly (see LTR_Algorithm::score_top_k).
+  /// \param top_k_bound Scale factor of the bounds used to prune documents.
   static void testing_phase(
       std::shared_ptr<learning::LTR_Algorithm> algo,
       std::shared_ptr<metric::ir::Metric> test_metric,
       std::shared_ptr<quickrank::data::Dataset> test_dataset,
       const std::string scores_filename,
-      const bool detailed_testing);
+      const bool detailed_testing,
+      const size_t top_k = 0,
+      const double top_k_bound = 1.0);
+
+  /// Compares the scores of \a algo on \a dataset with full precision
+  /// leaves and with \a leaf_precision ones, and prints the largest score
+  /// deviation, the number of queries ranked differently and \a metric for
+  /// both. Leaves \a leaf_precision selected.
+  static void leaf_precision_report(
+      std::shared_ptr<learning::LTR_Algorithm> algo,
+      std::shared_ptr<metric::ir::Metric> metric,
+      std::shared_ptr<quickrank::data::Dataset> dataset,
+      const std::string dataset_label,
+      const std::string leaf_precision);
 
   static std::shared_ptr<quickrank::data::Dataset> load_dataset(
       const std::string dataset_filename,
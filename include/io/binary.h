@@ -0,0 +1,101 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "data/dataset.h"
+
+namespace quickrank {
+namespace io {
+
+/**
+ * This class implements IO on QuickRank binary dataset files.
+ *
+ * A binary file stores a dataset ready to be used, so that loading it only
+ * requires to memory map the file: there is no parsing and, if the vertical
+ * layout is present, no transposition is needed by the learners.
+ * The file is organized as follows, with every section aligned to 64 bytes:
+ * \verbatim
+ <header>     .=. magic, version, byte order, sizes and section offsets
+ <labels>     .=. num_instances x Label
+ <offsets>    .=. (num_queries + 1) x uint64 query results list offsets
+ <horizontal> .=. num_instances x num_features Feature (row-major)
+ <vertical>   .=. num_features x num_instances Feature (column-major, optional)
+ \endverbatim
+ * Files are not portable across architectures with a different byte order.
+ */
+class Binary {
+ public:
+  /// Current version of the binary format.
+  static const uint32_t VERSION = 1;
+
+  Binary() {
+  }
+
+  virtual ~Binary() {
+  }
+
+  /// Checks whether the given file is a QuickRank binary dataset.
+  ///
+  /// \param file the input filename.
+  /// \return True if the file starts with the binary format magic string.
+  static bool is_binary(const std::string &file);
+
+  /// Maps the input dataset in memory and returns it in horizontal format.
+  ///
+  /// The returned dataset wraps the mapped file, which is private to the
+  /// process: changes made to the data are never written back to the file.
+  /// \param file the input filename.
+  /// \return The dataset in horizontal format, sharing its vertical layout
+  /// with \a data::VerticalDataset if available in the file.
+  virtual std::unique_ptr<data::Dataset> read_horizontal(
+      const std::string &file);
+
+  /// Write the dataset to an output file.
+  /// \param dataset the dataset to be written.
+  /// \param file the output filename.
+  /// \param with_vertical also store the column-major layout of the data.
+  virtual void write(
+      std::shared_ptr<data::Dataset> dataset,
+      const std::string &file,
+      bool with_vertical = true);
+
+ private:
+  double reading_time_ = 0.0;
+  long file_size_ = 0;
+  bool has_vertical_ = false;
+
+  /// The output stream operator.
+  /// Prints the data reading time stats.
+  friend std::ostream &operator<<(std::ostream &os, const Binary &me) {
+    return me.put(os);
+  }
+
+  /// Prints the data reading time stats
+  virtual std::ostream &put(std::ostream &os) const;
+
+};
+
+}  // namespace io
+}  // namespace quickrank
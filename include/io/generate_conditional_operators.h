@@ -48,9 +48,19 @@ class GenOpCond {
   GenOpCond() {}
   ~GenOpCond() {}
 
+  /// Maximum number of nodes of the trees in a generated function.
+  static const unsigned int MAX_FUNCTION_NODES = 4096;
+
+  /// Number of documents scored together by the batched scoring function.
+  static const unsigned int BATCH_SIZE = 64;
+
   /// Generates the C++ implementation of the model scoring function.
   /// This applies to tree forests and generates a cascade of conditional operators.
   ///
+  /// Trees are split into functions of at most MAX_FUNCTION_NODES nodes,
+  /// called in turn by \a ranker(v) on a single document, and by
+  /// \a ranker_batch(docs, n, stride, out) on blocks of documents.
+  ///
   /// \param model_filename Previously saved xml ranker model.
   /// \param code_filename Output source code file name.
   void
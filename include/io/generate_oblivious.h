@@ -49,6 +49,11 @@ class GenOblivious {
   /// Generates the C++ implementation of the model scoring function.
   /// This applies to forests of oblivious trees.
   ///
+  /// Besides \a ranker(v), scoring a single document, the batched
+  /// \a ranker_batch(docs, n, stride, out) computes the leaves of several
+  /// documents at once, with SIMD instructions when compiled for AVX2 or
+  /// AVX-512.
+  ///
   /// \param model_filename Previously saved XML ranker model.
   /// \param code_filename Output source code file name.
   void generate_oblivious_code(const std::string, const std::string);
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "data/dataset.h"
 
@@ -55,6 +56,11 @@ class Svml {
   }
 
   /// Reads the input dataset and returns in horizontal format.
+  ///
+  /// The file is memory mapped and split into line-aligned chunks, one per
+  /// thread. A first parallel pass counts the instances and finds the number
+  /// of features, a second one parses the chunks straight into the
+  /// final \a data::Dataset storage.
   /// \param file the input filename.
   /// \return The svml dataset in horizontal format.
   virtual std::unique_ptr<data::Dataset> read_horizontal(
@@ -71,6 +77,9 @@ class Svml {
   double reading_time_ = 0.0;
   double processing_time_ = 0.0;
   long file_size_ = 0;
+  /// bytes and parsing time of every chunk, one per thread
+  std::vector<size_t> chunk_bytes_;
+  std::vector<double> chunk_time_;
 
   /// The output stream operator.
   /// Prints the data reading time stats.
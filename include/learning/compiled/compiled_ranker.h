@@ -0,0 +1,128 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "data/dataset.h"
+#include "metric/ir/metric.h"
+#include "learning/ltr_algorithm.h"
+
+namespace quickrank {
+namespace learning {
+
+/**
+ * This class scores documents with the C++ code generated from a tree
+ * ensemble model, compiled at run time into a shared object.
+ *
+ * The code of the XML model is generated with one of the generators of
+ * quicklearn ("condop" or "oblivious"), compiled by the system compiler and
+ * loaded with dlopen. Shared objects are cached in a directory, keyed by a
+ * hash of the generated code and the compiler command, so that a model is
+ * compiled only the first time it is used.
+ *
+ * The compiler is given by the environment variable QUICKRANK_JIT_CXX, or
+ * CXX, or is c++ by default. The cache is the directory given to the
+ * constructor, or the one in QUICKRANK_JIT_CACHE, or quickrank-jit in
+ * XDG_CACHE_HOME or in ~/.cache. It must belong to the current user and must
+ * not be writable by others.
+ */
+class CompiledRanker: public LTR_Algorithm {
+
+ public:
+  /// Generates and compiles the code of the XML model in \a model_filename
+  /// by means of \a generator, unless already in the cache, and loads it.
+  CompiledRanker(const std::string &model_filename,
+                 const std::string &generator = "condop",
+                 const std::string &cache_dir = "");
+
+  virtual ~CompiledRanker();
+
+  /// Returns the name of the ranker.
+  virtual std::string name() const {
+    return NAME_;
+  }
+
+  static const std::string NAME_;
+
+  /// Compiled models cannot be trained.
+  virtual void learn(std::shared_ptr<data::Dataset> training_dataset,
+                     std::shared_ptr<data::Dataset> validation_dataset,
+                     std::shared_ptr<metric::ir::Metric> metric,
+                     size_t partial_save,
+                     const std::string model_filename);
+
+  /// Scores the documents of \a dataset by calling the batched ranker on
+  /// a block of documents per thread.
+  virtual void score_dataset(std::shared_ptr<data::Dataset> dataset,
+                             Score *scores) const;
+
+  /// Returns the score of a given document.
+  virtual Score score_document(const Feature *d) const {
+    return ranker_(const_cast<Feature *>(d));
+  }
+
+  /// Scores the \a n documents stored by row in \a d, whose features are
+  /// \a nfeatures apart, with the batched ranker in the calling thread.
+  void score_batch(const Feature *d, const size_t n, const size_t nfeatures,
+                   Score *scores) const {
+    ranker_batch_(d, n, nfeatures, scores);
+  }
+
+  /// Return the xml model the ranker was compiled from.
+  virtual pugi::xml_document *get_xml_model() const;
+
+  /// Returns the path of the loaded shared object.
+  const std::string &library() const {
+    return library_;
+  }
+
+  /// Returns true if the shared object was compiled by this instance,
+  /// false if it was found in the cache.
+  bool compiled() const {
+    return compiled_;
+  }
+
+ private:
+  typedef double (*Ranker)(float *);
+  typedef void (*BatchRanker)(const float *, size_t, size_t, double *);
+
+  pugi::xml_document model_;
+  std::string generator_;
+  std::string library_;
+  bool compiled_ = false;
+  void *handle_ = nullptr;
+  Ranker ranker_ = nullptr;
+  BatchRanker ranker_batch_ = nullptr;
+
+  /// The output stream operator.
+  friend std::ostream &operator<<(std::ostream &os, const CompiledRanker &a) {
+    return a.put(os);
+  }
+
+  /// Prints the description of Algorithm, including its parameters
+  virtual std::ostream &put(std::ostream &os) const;
+};
+
+}  // namespace learning
+}  // namespace quickrank
@@ -25,6 +25,10 @@
 #include "learning/forests/mart.h"
 #include "learning/tree/rt.h"
 #include "learning/tree/ensemble.h"
+#include "metric/ir/dcg_tables.h"
+#include "utils/scratch_arena.h"
+
+#include <vector>
 
 namespace quickrank {
 namespace learning {
@@ -43,9 +47,13 @@ class LambdaMart: public Mart {
   /// on the validation set.
   LambdaMart(size_t ntrees, double shrinkage, size_t nthresholds,
              size_t ntreeleaves, size_t minleafsupport, float subsample,
-             float max_features, size_t esr, float collapse_leaves_factor)
+             float max_features, size_t esr, float collapse_leaves_factor,
+             RegressionTree::GrowthPolicy growth_policy =
+                 RegressionTree::GrowthPolicy::BEST_FIRST,
+             size_t max_depth = 0, bool sparse = false)
       : Mart(ntrees, shrinkage, nthresholds, ntreeleaves, minleafsupport,
-             subsample, max_features, esr, collapse_leaves_factor) {
+             subsample, max_features, esr, collapse_leaves_factor,
+             growth_policy, max_depth, sparse) {
   }
 
   /// Generates a LTR_Algorithm instance from a previously saved XML model.
@@ -89,6 +97,12 @@ class LambdaMart: public Mart {
  protected:
   double *instance_weights_ = NULL;  //corresponds to datapoint.cache
 
+  // scratch memory of the pseudo responses of a query, one per thread
+  std::vector<ScratchArena> scratch_;
+
+  // gains of the training labels and discounts of the longest query
+  std::unique_ptr<metric::ir::DcgTables> dcg_tables_;
+
 };
 
 }  // namespace forests
@@ -37,6 +37,40 @@ class Mart: public LTR_Algorithm {
   friend class quickrank::learning::meta::MetaCleaver;
 
  public:
+  /// Engine used to score datasets.
+  ///
+  /// AUTO uses ObliviousScorer when every tree is oblivious, QuickScorer
+  /// when every tree has at most 64 leaves, and POINTER otherwise. POINTER
+  /// traverses the flattened trees one by one, QUICKSCORER, VPRED and
+  /// OBLIVIOUS are the engines of the same name.
+  enum class ScoringEngine {
+    AUTO, POINTER, QUICKSCORER, VPRED, OBLIVIOUS
+  };
+
+  static const std::vector<std::string> scoringEngineNames;
+
+  static ScoringEngine get_scoring_engine(std::string name);
+
+  static std::string get_scoring_engine(ScoringEngine scoring_engine) {
+    return scoringEngineNames[static_cast<int>(scoring_engine)];
+  }
+
+  /// Precision of the leaves of the model used to score datasets.
+  ///
+  /// DOUBLE scores with the trees as learnt, FLOAT32 and INT16 with a
+  /// QuantizedEnsemble whose leaves have the given type.
+  enum class LeafPrecision {
+    DOUBLE, FLOAT32, INT16
+  };
+
+  static const std::vector<std::string> leafPrecisionNames;
+
+  static LeafPrecision get_leaf_precision(std::string name);
+
+  static std::string get_leaf_precision(LeafPrecision leaf_precision) {
+    return leafPrecisionNames[static_cast<int>(leaf_precision)];
+  }
+
   /// Initializes a new Mart instance with the given learning parameters.
   ///
   /// \param ntrees Maximum number of trees.
@@ -46,10 +80,17 @@ class Mart: public LTR_Algorithm {
   /// \param minleafsupport Minimum number of instances in each leaf.
   /// \param valid_iterations Early stopping if no improvement after \esr iterations
   /// on the validation set.
+  /// \param growth_policy Order in which the nodes of each tree are split.
+  /// \param max_depth Maximum depth of LEVEL_WISE trees (0 means unlimited).
+  /// \param sparse Whether to keep only the non-zero training values, and
+  /// sparse bins.
   Mart(size_t ntrees, double shrinkage, size_t nthresholds,
        size_t ntreeleaves, size_t minleafsupport,
        float subsample, float max_features,
-       size_t valid_iterations, float collapse_leaves_factor)
+       size_t valid_iterations, float collapse_leaves_factor,
+       RegressionTree::GrowthPolicy growth_policy =
+           RegressionTree::GrowthPolicy::BEST_FIRST,
+       size_t max_depth = 0, bool sparse = false)
       : ntrees_(ntrees),
         shrinkage_(shrinkage),
         nthresholds_(nthresholds),
@@ -58,7 +99,10 @@ class Mart: public LTR_Algorithm {
         subsample_(subsample),
         max_features_(max_features),
         valid_iterations_(valid_iterations),
-        collapse_leaves_factor_(collapse_leaves_factor) {
+        collapse_leaves_factor_(collapse_leaves_factor),
+        growth_policy_(growth_policy),
+        max_depth_(max_depth),
+        sparse_(sparse) {
   }
 
   /// Generates a LTR_Algorithm instance from a previously saved XML model.
@@ -73,6 +117,14 @@ class Mart: public LTR_Algorithm {
                      size_t partial_save,
                      const std::string output_basename);
 
+  /// Scores every instance of \a dataset with the selected engine. Every
+  /// engine scores blocks of documents against blocks of trees.
+  ///
+  /// \param dataset The dataset to be scored.
+  /// \param scores The vector where scores are stored.
+  virtual void score_dataset(std::shared_ptr<data::Dataset> dataset,
+                             Score *scores) const;
+
   /// Returns the score by the current ranker
   ///
   /// \param d Document to be scored.
@@ -106,6 +158,28 @@ class Mart: public LTR_Algorithm {
 
   virtual bool update_weights(std::vector<double>& weights);
 
+  /// Scores the results of a query in stages of trees, dropping the
+  /// documents that cannot enter the top \a k (see Ensemble::score_top_k).
+  /// The leaves are always read in double precision.
+  virtual TopKStats score_top_k(const data::QueryResults &results,
+                                const size_t nfeatures,
+                                const size_t k,
+                                Score *scores,
+                                const double bound_factor = 1.0,
+                                const size_t stage_trees = 50) const;
+
+  virtual bool set_scoring_engine(const std::string &engine) {
+    scoring_engine_ = get_scoring_engine(engine);
+    return true;
+  }
+
+  /// Makes \a score_dataset use a QuantizedEnsemble, regardless of the
+  /// scoring engine, unless \a precision is "double".
+  virtual bool set_leaf_precision(const std::string &precision) {
+    leaf_precision_ = get_leaf_precision(precision);
+    return true;
+  }
+
   virtual std::vector<double> get_weights() const {
     return ensemble_model_.get_weights();
   }
@@ -182,9 +256,19 @@ class Mart: public LTR_Algorithm {
   // equals than the fraction of the maximum possible number of nodes in the
   // tree given its depth.
 
-  size_t **sortedsid_ = NULL;
-  size_t sortedsize_ = 0;
+  RegressionTree::GrowthPolicy growth_policy_ =
+      RegressionTree::GrowthPolicy::BEST_FIRST;
+  size_t max_depth_ = 0;  // of LEVEL_WISE trees, 0 for unlimited depth
+  bool sparse_ = false;  // training data in sparse format
+
+  ScoringEngine scoring_engine_ = ScoringEngine::AUTO;
+  LeafPrecision leaf_precision_ = LeafPrecision::DOUBLE;
+
   RTRootHistogram *hist_ = NULL;
+  // memory of the node histograms, recycled across nodes and trees
+  std::shared_ptr<HistogramPool> histogram_pool_;
+  // per-thread best splits, reused across the splits of all the trees
+  std::shared_ptr<split_search::ThreadBestSplits> thread_best_splits_;
 
  private:
   /// The output stream operator.
@@ -24,12 +24,30 @@
 #include <memory>
 
 #include "data/dataset.h"
+#include "data/queryresults.h"
 #include "metric/ir/metric.h"
 #include "pugixml/src/pugixml.hpp"
 
 namespace quickrank {
 namespace learning {
 
+/// Counters of the scoring of a query by \a LTR_Algorithm::score_top_k.
+struct TopKStats {
+  /// Number of evaluated trees (or base rankers), over all documents.
+  size_t evaluations = 0;
+  /// Number of evaluations avoided by dropping documents early.
+  size_t saved_evaluations = 0;
+  /// Number of documents dropped before being completely scored.
+  size_t pruned_documents = 0;
+
+  TopKStats &operator+=(const TopKStats &other) {
+    evaluations += other.evaluations;
+    saved_evaluations += other.saved_evaluations;
+    pruned_documents += other.pruned_documents;
+    return *this;
+  }
+};
+
 class LTR_Algorithm {
 
  public:
@@ -73,6 +91,46 @@ class LTR_Algorithm {
   virtual void score_dataset(std::shared_ptr<data::Dataset> dataset,
                              Score *scores) const;
 
+  /// Scores the results of a query of which only the \a k top scored ones
+  /// are of interest, e.g., at serving time.
+  ///
+  /// Ensembles evaluate the trees in stages of \a stage_trees, dropping
+  /// after each stage the documents whose score cannot reach the top k
+  /// (see Ensemble::score_top_k). The top k documents get their exact
+  /// score, the other ones a lower score than the k-th. A \a bound_factor
+  /// smaller than 1 drops documents heuristically, at the risk of losing
+  /// some of the top k. Default implementation scores every document.
+  ///
+  /// \param results The results of the query.
+  /// \param nfeatures The number of features of each result.
+  /// \param scores The vector where scores are stored.
+  /// \return The number of evaluations performed and saved.
+  virtual TopKStats score_top_k(const data::QueryResults &results,
+                                const size_t nfeatures,
+                                const size_t k,
+                                Score *scores,
+                                const double bound_factor = 1.0,
+                                const size_t stage_trees = 50) const;
+
+  /// Selects the engine used by \a score_dataset, given its name.
+  ///
+  /// Default implementation will do nothing (default for non ensemble
+  /// models).
+  /// \return bool indicating if the engine has been selected
+  virtual bool set_scoring_engine(const std::string &engine) {
+    return false;
+  }
+
+  /// Selects the precision of the leaves of the model used by
+  /// \a score_dataset, given its name, i.e., "double", "float32" or "int16".
+  ///
+  /// Default implementation will do nothing (default for non ensemble
+  /// models).
+  /// \return bool indicating if the precision has been selected
+  virtual bool set_leaf_precision(const std::string &precision) {
+    return false;
+  }
+
   /// Returns the score of a given document.
   /// \param d is a pointer to the document to be evaluated
   /// \note   Each algorithm has a different implementation.
@@ -74,6 +74,12 @@ class MetaCleaver: public LTR_Algorithm {
                      size_t partial_save,
                      const std::string output_basename);
 
+  /// Scores \a dataset with the optimized ranker.
+  virtual void score_dataset(std::shared_ptr<data::Dataset> dataset,
+                             Score *scores) const {
+    ltr_algo_->score_dataset(dataset, scores);
+  }
+
   /// Returns the score by the current ranker
   ///
   /// \param d Document to be scored.
@@ -109,6 +115,24 @@ class MetaCleaver: public LTR_Algorithm {
     return ltr_algo_->get_weights();
   }
 
+  virtual bool set_scoring_engine(const std::string &engine) {
+    return ltr_algo_->set_scoring_engine(engine);
+  }
+
+  virtual bool set_leaf_precision(const std::string &precision) {
+    return ltr_algo_->set_leaf_precision(precision);
+  }
+
+  virtual TopKStats score_top_k(const data::QueryResults &results,
+                                const size_t nfeatures,
+                                const size_t k,
+                                Score *scores,
+                                const double bound_factor = 1.0,
+                                const size_t stage_trees = 50) const {
+    return ltr_algo_->score_top_k(results, nfeatures, k, scores,
+                                  bound_factor, stage_trees);
+  }
+
   virtual bool import_model_state(LTR_Algorithm &other);
 
   static const std::string NAME_;
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "learning/tree/rt.h"
+#include "learning/tree/flat_tree.h"
 #include "types.h"
 #include "pugixml/src/pugixml.hpp"
 
@@ -53,6 +54,37 @@ class Ensemble {
   virtual quickrank::Score score_instance(const quickrank::Feature *d,
                                           const size_t offset = 1) const;
 
+  /// Scores the \a ninstances documents stored by row in \a d, in parallel.
+  /// Documents are scored in blocks, each one against a block of trees at
+  /// a time (see scoring_blocks).
+  virtual void score(const quickrank::Feature *d,
+                     const size_t ninstances,
+                     const size_t nfeatures,
+                     quickrank::Score *scores) const;
+
+  /// Scores the \a ninstances documents stored by row in \a d, of which
+  /// only the \a k top scored ones are of interest.
+  ///
+  /// Trees are evaluated in stages of \a stage_trees. After every stage, the
+  /// outputs of the remaining trees are bounded by the sums of their
+  /// smallest and largest leaves, and the documents whose upper bound is
+  /// below the k-th largest lower bound are dropped. The top k documents
+  /// get their exact score, the dropped ones their upper bound, which is
+  /// lower than the score of the k-th document. A \a bound_factor smaller
+  /// than 1 shrinks the bounds, dropping more documents at the risk of
+  /// losing some of the top k.
+  ///
+  /// \param npruned Set to the number of dropped documents.
+  /// \return The number of tree evaluations.
+  size_t score_top_k(const quickrank::Feature *d,
+                     const size_t ninstances,
+                     const size_t nfeatures,
+                     const size_t k,
+                     const size_t stage_trees,
+                     const double bound_factor,
+                     quickrank::Score *scores,
+                     size_t &npruned) const;
+
   virtual std::shared_ptr<std::vector<quickrank::Score>>
       partial_scores_instance(const quickrank::Feature *d,
                               bool ignore_weights = false,
@@ -73,6 +105,11 @@ class Ensemble {
     return arr[index].root;
   }
 
+  /// Returns the scoring representation of the tree at \a index.
+  inline const FlatTree* getFlatTree(int index) const {
+    return arr[index].flat;
+  }
+
   inline double getWeight(int index) const {
     return arr[index].weight;
   }
@@ -83,6 +120,7 @@ class Ensemble {
 
     weighted_tree(RTNode *root, double weight, float maxlabel)
         : root(root),
+          flat(new FlatTree(root)),
           weight(weight),
           maxlabel(maxlabel) { }
 
@@ -90,9 +128,12 @@ class Ensemble {
       weight = source.weight;
       maxlabel = source.maxlabel;
       root = new RTNode(*(source.root));
+      flat = new FlatTree(*(source.flat));
     }
 
     RTNode* root = nullptr;
+    // built when the tree is added to the ensemble, and used for scoring
+    FlatTree* flat = nullptr;
     double weight = 0.0;
     float maxlabel = 0.0f;
   };
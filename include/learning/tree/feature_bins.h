@@ -0,0 +1,194 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * This class stores the quantized training data used by tree learners.
+ *
+ * For each feature and document it stores the index of the threshold bin
+ * the document falls in, i.e., the smallest t such that the feature value
+ * is not greater than the t-th threshold. Bins use the smallest unsigned
+ * type able to index all the thresholds of a feature: uint8_t up to 256
+ * thresholds, uint16_t up to 65536, and uint32_t otherwise.
+ * Data is vertical: the bins of a feature are contiguous.
+ *
+ * Bins can also be sparse: every feature has a default bin, the one of the
+ * missing values, and only the documents falling in another bin are stored,
+ * sorted by document, together with their bin (CSC format).
+ */
+class FeatureBins {
+ public:
+  /// Allocates the bins of \a nfeatures features for \a ninstances documents.
+  ///
+  /// \param thresholds_size The number of thresholds of each feature.
+  FeatureBins(size_t nfeatures, size_t ninstances,
+              const size_t *thresholds_size);
+
+  /// Allocates the sparse bins of \a nfeatures features for \a ninstances
+  /// documents.
+  ///
+  /// \param thresholds_size The number of thresholds of each feature.
+  /// \param default_bins The default bin of each feature.
+  /// \param nentries The number of stored documents of each feature.
+  FeatureBins(size_t nfeatures, size_t ninstances,
+              const size_t *thresholds_size, const size_t *default_bins,
+              const size_t *nentries);
+
+  /// Slot of the documents not belonging to any node in \a sample_slots().
+  static const uint32_t NO_SLOT = UINT32_MAX;
+
+  bool is_sparse() const {
+    return !default_bins_.empty();
+  }
+
+  /// Returns the default bin of the f-th feature of sparse bins.
+  size_t default_bin(size_t f) const {
+    return default_bins_[f];
+  }
+
+  /// Returns the number of documents stored for the f-th feature, i.e.,
+  /// all of them unless bins are sparse.
+  size_t num_entries(size_t f) const {
+    return is_sparse() ? doc_offsets_[f + 1] - doc_offsets_[f] : ninstances_;
+  }
+
+  /// Returns the (sorted) documents stored for the f-th feature of sparse
+  /// bins, whose bins are in \a column(f).
+  const uint32_t *documents(size_t f) const {
+    return docs_.data() + doc_offsets_[f];
+  }
+
+  /// Returns a scratch array mapping every document to a slot, initially
+  /// \a NO_SLOT, used to accumulate the histograms of sparse bins. Callers
+  /// must restore the slots they set before returning.
+  uint32_t *sample_slots() const {
+    return sample_slots_.data();
+  }
+
+  /// Returns the size in bytes of a bin of the f-th feature.
+  size_t bin_size(size_t f) const {
+    return bin_size_[f];
+  }
+
+  /// Returns the bins of the f-th feature.
+  ///
+  /// \warning \a BinT must match \a bin_size(f).
+  template<typename BinT>
+  BinT *column(size_t f) {
+    return reinterpret_cast<BinT *>(data_.data() + offsets_[f]);
+  }
+
+  template<typename BinT>
+  const BinT *column(size_t f) const {
+    return reinterpret_cast<const BinT *>(data_.data() + offsets_[f]);
+  }
+
+  /// Invokes \a fun on the bins of the f-th feature, with their actual type.
+  template<typename Fun>
+  void apply(size_t f, Fun &fun) const {
+    switch (bin_size_[f]) {
+      case 1:
+        fun(column<uint8_t>(f));
+        break;
+      case 2:
+        fun(column<uint16_t>(f));
+        break;
+      default:
+        fun(column<uint32_t>(f));
+    }
+  }
+
+  /// Returns the bin of the i-th document for the f-th feature. Sparse bins
+  /// look the document up, and return the default bin if it is not stored.
+  size_t get(size_t f, size_t i) const {
+    if (is_sparse()) {
+      const uint32_t *begin = documents(f);
+      const uint32_t *end = begin + num_entries(f);
+      const uint32_t *it = std::lower_bound(begin, end, (uint32_t) i);
+      if (it == end || *it != i)
+        return default_bins_[f];
+      i = it - begin;
+    }
+    switch (bin_size_[f]) {
+      case 1:
+        return column<uint8_t>(f)[i];
+      case 2:
+        return column<uint16_t>(f)[i];
+      default:
+        return column<uint32_t>(f)[i];
+    }
+  }
+
+  /// Sets the bin of the i-th document for the f-th feature.
+  void set(size_t f, size_t i, size_t bin) {
+    switch (bin_size_[f]) {
+      case 1:
+        column<uint8_t>(f)[i] = (uint8_t) bin;
+        break;
+      case 2:
+        column<uint16_t>(f)[i] = (uint16_t) bin;
+        break;
+      default:
+        column<uint32_t>(f)[i] = (uint32_t) bin;
+    }
+  }
+
+  /// Stores the k-th document of the f-th feature of sparse bins.
+  /// Documents must be stored in increasing order.
+  void set_entry(size_t f, size_t k, size_t i, size_t bin) {
+    docs_[doc_offsets_[f] + k] = (uint32_t) i;
+    set(f, k, bin);
+  }
+
+  size_t num_features() const {
+    return bin_size_.size();
+  }
+
+  size_t num_instances() const {
+    return ninstances_;
+  }
+
+  /// Returns the size in bytes of the stored bins.
+  size_t memory_usage() const {
+    return data_.size() + docs_.size() * sizeof(uint32_t);
+  }
+
+ private:
+  size_t ninstances_;
+  std::vector<uint8_t> bin_size_;
+  std::vector<size_t> offsets_;
+  std::vector<uint8_t> data_;
+
+  // sparse bins only
+  std::vector<size_t> default_bins_;
+  std::vector<size_t> doc_offsets_;
+  std::vector<uint32_t> docs_;
+  mutable std::vector<uint32_t> sample_slots_;
+
+  /// Sets the size of the bins of every feature and allocates them.
+  void allocate(const size_t *thresholds_size, const size_t *nentries);
+};
@@ -0,0 +1,101 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "learning/tree/rtnode.h"
+#include "types.h"
+
+/**
+ * This class is the compact, immutable representation of a regression tree
+ * used for scoring.
+ *
+ * Internal nodes are stored in pre-order in a contiguous array, so that the
+ * left child of a node usually follows it, and leaf outputs are stored in a
+ * separate array. A child is referenced by its index among the internal
+ * nodes or, if it is a leaf, by the bitwise complement of its index among
+ * the leaves.
+ */
+class FlatTree {
+ public:
+  /// Flattens the tree rooted in \a root.
+  explicit FlatTree(RTNode const *root);
+
+  size_t num_nodes() const {
+    return nodes_.size();
+  }
+
+  size_t num_leaves() const {
+    return leaves_.size();
+  }
+
+  /// Returns the smallest output of a leaf.
+  double min_leaf() const {
+    return min_leaf_;
+  }
+
+  /// Returns the largest output of a leaf.
+  double max_leaf() const {
+    return max_leaf_;
+  }
+
+  /// Returns the bytes of the nodes and of the leaves.
+  size_t num_bytes() const {
+    return nodes_.size() * sizeof(Node) + leaves_.size() * sizeof(double);
+  }
+
+  /// Returns the output of the leaf reached by document \a d, whose
+  /// features are \a next_fx_offset positions apart.
+  quickrank::Score score_instance(const quickrank::Feature *d,
+                                  const size_t next_fx_offset) const {
+    int32_t n = root_;
+    while (n >= 0) {
+      const Node &node = nodes_[n];
+      n = d[node.featureidx * next_fx_offset] <= node.threshold ?
+          node.left : node.right;
+#ifdef QUICKRANK_PERF_STATS
+      RTNode::_internal_nodes_traversed.fetch_add(1,
+                                                  std::memory_order_relaxed);
+#endif
+    }
+    return leaves_[~n];
+  }
+
+ private:
+  struct Node {
+    uint32_t featureidx;
+    float threshold;
+    int32_t left;
+    int32_t right;
+  };
+
+  std::vector<Node> nodes_;
+  std::vector<double> leaves_;
+  int32_t root_ = -1;
+  double min_leaf_ = 0.0;
+  double max_leaf_ = 0.0;
+
+  /// Appends the subtree of \a node and returns its reference.
+  int32_t add_subtree(RTNode const *node);
+};
@@ -0,0 +1,90 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/// The memory of a node histogram: the cumulative label sums of all the
+/// features followed by their cumulative counts. The bins of each feature
+/// start on a cache line, and \a sumlbl and \a count point to them.
+struct HistogramBlock {
+  double *sumlbl_data = NULL;   // [nbins]
+  size_t *count_data = NULL;    // [nbins]
+  double **sumlbl = NULL;       // [nfeatures]
+  size_t **count = NULL;        // [nfeatures]
+};
+
+/**
+ * This class recycles the memory of the histograms of a tree learner.
+ *
+ * All the histograms of a learner have the same shape, so each of them is
+ * stored in a single block. Blocks released by a node are reused by the
+ * next ones, both within a tree and across the trees of an ensemble.
+ * Blocks are acquired and released in mutual exclusion, so that histograms
+ * can be created and deleted from within parallel regions.
+ */
+class HistogramPool {
+ public:
+  /// Prepares the blocks for the histograms of \a nfeatures features.
+  ///
+  /// \param thresholds_size The number of thresholds of each feature.
+  HistogramPool(size_t nfeatures, const size_t *thresholds_size);
+
+  ~HistogramPool();
+
+  /// Returns a block with undefined bins. Padding bins are always zero.
+  HistogramBlock *acquire();
+
+  /// Gives \a block back to the pool.
+  void release(HistogramBlock *block);
+
+  /// Sets to zero all the label sums of \a block.
+  void clear_sumlbl(HistogramBlock *block) const;
+
+  /// Sets to zero all the label sums and counts of \a block.
+  void clear(HistogramBlock *block) const;
+
+  size_t num_features() const {
+    return offsets_.size() - 1;
+  }
+
+  /// Returns the number of bins of a block, including padding.
+  size_t num_bins() const {
+    return offsets_.back();
+  }
+
+  /// Returns the position of the first bin of the f-th feature in a block.
+  size_t offset(size_t f) const {
+    return offsets_[f];
+  }
+
+  /// Returns the number of blocks allocated so far.
+  size_t num_blocks() const {
+    return nblocks_;
+  }
+
+ private:
+  std::vector<size_t> offsets_;
+  std::vector<HistogramBlock *> free_;
+  size_t nblocks_ = 0;
+};
@@ -0,0 +1,130 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "learning/tree/ensemble.h"
+#include "types.h"
+
+/**
+ * This class scores documents with an ensemble of oblivious trees, i.e.,
+ * complete trees whose nodes at the same level share the same feature and
+ * threshold, as learnt by ObliviousMart and ObliviousLambdaMart.
+ *
+ * A tree of depth k is stored as its k (feature, threshold) pairs, one per
+ * level, plus a table of its 2^k leaves from left to right. The exit leaf
+ * of a document is the k-bits number whose i-th most significant bit is
+ * the outcome of the test of the i-th level, so that no node is ever
+ * visited. \a LOCKSTEP documents are tested together against each level,
+ * with a single SIMD comparison per level with AVX-512 and two with AVX2.
+ *
+ * Scores are the same of Ensemble::score_instance, as trees are accumulated
+ * in the same order.
+ */
+class ObliviousScorer {
+ public:
+  /// Maximum depth of a tree.
+  static const size_t MAX_DEPTH = 16;
+  /// Number of documents scored together.
+  static const size_t LOCKSTEP = 16;
+
+  /// Returns true if every tree of \a ensemble is oblivious and at most
+  /// \a MAX_DEPTH deep.
+  static bool is_supported(const Ensemble &ensemble);
+
+  /// Lays out the trees of \a ensemble, which must be supported.
+  ObliviousScorer(const Ensemble &ensemble);
+
+  size_t num_trees() const {
+    return ntrees_;
+  }
+
+  /// Returns the number of features used by the model.
+  size_t num_features() const {
+    return nmodel_features_;
+  }
+
+  /// Scores the \a ninstances documents stored by row in \a d, in parallel.
+  /// Documents must have at least num_features() features.
+  void score(const quickrank::Feature *d,
+             const size_t ninstances,
+             const size_t nfeatures,
+             quickrank::Score *scores) const;
+
+  /// Returns the name of the kernel used on the running CPU.
+  static const char *kernel_name();
+
+ private:
+  size_t ntrees_ = 0;
+  size_t nmodel_features_ = 0;
+  std::vector<size_t> depths_;
+  // levels and leaves of tree t start at level_offsets_[t] and
+  // leaf_offsets_[t]
+  std::vector<size_t> level_offsets_;
+  std::vector<size_t> leaf_offsets_;
+  std::vector<int32_t> features_;
+  std::vector<float> thresholds_;
+  std::vector<double> leaves_;
+  std::vector<double> weights_;
+
+  /// Adds to \a scores the outputs of trees [\a tree_begin, \a tree_end) on
+  /// the LOCKSTEP documents starting at \a d.
+  typedef void (ObliviousScorer::*Kernel)(const quickrank::Feature *d,
+                                          const size_t nfeatures,
+                                          const size_t tree_begin,
+                                          const size_t tree_end,
+                                          quickrank::Score *scores) const;
+
+  void score_lockstep_scalar(const quickrank::Feature *d,
+                             const size_t nfeatures,
+                             const size_t tree_begin, const size_t tree_end,
+                             quickrank::Score *scores) const;
+
+  void score_lockstep_avx2(const quickrank::Feature *d,
+                           const size_t nfeatures,
+                           const size_t tree_begin, const size_t tree_end,
+                           quickrank::Score *scores) const;
+
+  void score_lockstep_avx512(const quickrank::Feature *d,
+                             const size_t nfeatures,
+                             const size_t tree_begin, const size_t tree_end,
+                             quickrank::Score *scores) const;
+
+  /// Adds to \a score the outputs of trees [\a tree_begin, \a tree_end) on
+  /// document \a d.
+  void score_instance(const quickrank::Feature *d,
+                      const size_t tree_begin, const size_t tree_end,
+                      quickrank::Score &score) const;
+
+  /// Adds to \a scores the leaves \a leafidx of tree \a t.
+  void add_leaves(const size_t t, const int32_t *leafidx,
+                  quickrank::Score *scores) const {
+    const double *leaves = &leaves_[leaf_offsets_[t]];
+    for (size_t v = 0; v < LOCKSTEP; ++v)
+      scores[v] += leaves[leafidx[v]] * weights_[t];
+  }
+
+  static Kernel best_kernel();
+};
@@ -0,0 +1,137 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "learning/tree/ensemble.h"
+#include "types.h"
+
+/**
+ * This class is a compact copy of an ensemble of regression trees, meant
+ * for scoring only.
+ *
+ * The weight of every tree is folded into its leaves, which are stored as
+ * float32 values or as int16 values with a per-tree scale. The thresholds of
+ * every feature are replaced by their uint16 index among the distinct
+ * thresholds of that feature in the model, and documents are binned once,
+ * feature by feature, before being scored: the bin of a value is the
+ * number of thresholds smaller than it, so that a value is not larger than
+ * a threshold if and only if its bin is not larger than the index of the
+ * threshold. Nodes are thus 12 bytes instead of 16 and leaves 4 or 2 bytes
+ * instead of 8, and the traversal only compares small integers.
+ *
+ * Scores may differ from the ones of Ensemble::score_instance because of
+ * the rounding of the leaves.
+ */
+class QuantizedEnsemble {
+ public:
+  /// Representation of the leaves.
+  enum class LeafType {
+    FLOAT32, INT16
+  };
+
+  /// Maximum number of distinct thresholds of a feature.
+  static const size_t MAX_THRESHOLDS = 65535;
+  /// Maximum number of distinct features used by the model.
+  static const size_t MAX_FEATURES = 65536;
+
+  /// Returns true if \a ensemble uses at most \a MAX_FEATURES features, each
+  /// one with at most \a MAX_THRESHOLDS distinct thresholds.
+  static bool is_supported(const Ensemble &ensemble);
+
+  /// Compacts the trees of \a ensemble, which must be supported.
+  QuantizedEnsemble(const Ensemble &ensemble, const LeafType leaf_type);
+
+  size_t num_trees() const {
+    return roots_.size();
+  }
+
+  /// Returns the number of distinct features used by the model.
+  size_t num_features() const {
+    return features_.size();
+  }
+
+  /// Returns the bytes of the nodes, of the leaves and of the scales.
+  size_t num_bytes() const {
+    return nodes_.size() * sizeof(Node) + leaves32_.size() * sizeof(float)
+        + leaves16_.size() * sizeof(int16_t) + scales_.size() * sizeof(float);
+  }
+
+  /// Bins the \a ninstances documents stored by row in \a d. The bins of
+  /// document i are stored in \a bins from position i * num_features(), in
+  /// the order of the features used by the model.
+  void bin_documents(const quickrank::Feature *d,
+                     const size_t ninstances,
+                     const size_t nfeatures,
+                     uint16_t *bins) const;
+
+  /// Scores the \a ninstances documents stored by row in \a d, in parallel.
+  void score(const quickrank::Feature *d,
+             const size_t ninstances,
+             const size_t nfeatures,
+             quickrank::Score *scores) const;
+
+ private:
+  struct Node {
+    uint16_t feature;  // position among the features used by the model
+    uint16_t bin;      // index of the threshold among the ones of feature
+    int32_t left;
+    int32_t right;
+  };
+
+  LeafType leaf_type_;
+  // features used by the model, and the sorted distinct thresholds of each
+  std::vector<size_t> features_;
+  std::vector<std::vector<float>> thresholds_;
+  // children are the index of a node or the complement of the index of a
+  // leaf, in the arrays shared by all the trees
+  std::vector<Node> nodes_;
+  std::vector<int32_t> roots_;
+  std::vector<size_t> tree_bytes_;
+  std::vector<float> leaves32_;
+  std::vector<int16_t> leaves16_;
+  std::vector<float> scales_;
+
+  /// Exits with an error if documents of \a nfeatures features miss some
+  /// of the features used by the model.
+  void check_num_features(const size_t nfeatures) const;
+
+  /// Appends the subtree of \a node of tree \a t and returns its reference.
+  int32_t add_subtree(RTNode const *node, const size_t t,
+                      std::vector<double> &leaves,
+                      std::vector<size_t> const &feature_position);
+
+  /// Returns the output of tree \a t on the document binned in \a bins.
+  quickrank::Score score_tree(const size_t t, const uint16_t *bins) const {
+    int32_t n = roots_[t];
+    while (n >= 0) {
+      const Node &node = nodes_[n];
+      n = bins[node.feature] <= node.bin ? node.left : node.right;
+    }
+    if (leaf_type_ == LeafType::FLOAT32)
+      return leaves32_[~n];
+    return leaves16_[~n] * (double) scales_[t];
+  }
+};
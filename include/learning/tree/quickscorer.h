@@ -0,0 +1,116 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "learning/tree/ensemble.h"
+#include "types.h"
+
+/**
+ * This class scores documents with a tree ensemble by means of the
+ * QuickScorer algorithm (Lucchese et al., SIGIR 2015).
+ *
+ * The internal nodes of all the trees are grouped by feature and sorted by
+ * threshold, and the leaves of each tree are numbered from left to right.
+ * Every node stores a bitvector with the leaves of its left subtree unset.
+ * A document is scored by visiting, for each feature, the nodes whose test
+ * is false, i.e., whose threshold is below the feature value, and by and-ing
+ * their bitvectors into the one of their tree. The exit leaf of a tree is
+ * then the leftmost leaf whose bit is still set.
+ *
+ * Large ensembles are split in blocks of trees whose nodes fit the L2
+ * cache (see scoring_blocks), and every block has its own nodes grouped by
+ * feature. Documents are scored in blocks as well, each one against every
+ * block of trees in turn.
+ *
+ * Trees must have at most \a MAX_LEAVES leaves. Scores are the same of
+ * Ensemble::score_instance, as trees are accumulated in the same order.
+ */
+class QuickScorer {
+ public:
+  /// Maximum number of leaves of a tree.
+  static const size_t MAX_LEAVES = 64;
+
+  /// Returns true if every tree of \a ensemble can be scored by QuickScorer.
+  static bool is_supported(const Ensemble &ensemble);
+
+  /// Lays out the trees of \a ensemble, which must be supported.
+  ///
+  /// \param trees_per_block The number of trees of a block, or 0 to fit
+  /// the blocks to the L2 cache.
+  QuickScorer(const Ensemble &ensemble, size_t trees_per_block = 0);
+
+  size_t num_trees() const {
+    return ntrees_;
+  }
+
+  size_t num_blocks() const {
+    return block_trees_.size() - 1;
+  }
+
+  /// Returns the score of document \a d with \a nfeatures features.
+  /// Features not in the document take the value 0.
+  ///
+  /// \param leafidx A buffer of num_trees() bitvectors used by the scorer.
+  quickrank::Score score_instance(const quickrank::Feature *d,
+                                  const size_t nfeatures,
+                                  uint64_t *leafidx) const;
+
+  /// Scores the \a ninstances documents stored by row in \a d, in parallel
+  /// blocks of documents.
+  void score(const quickrank::Feature *d,
+             const size_t ninstances,
+             const size_t nfeatures,
+             quickrank::Score *scores) const;
+
+ private:
+  size_t ntrees_ = 0;
+  size_t nmodel_features_ = 0;
+  // trees of block b are in [block_trees_[b], block_trees_[b+1])
+  std::vector<size_t> block_trees_;
+  // nodes of feature f in block b are in [offsets[f], offsets[f+1]), where
+  // offsets starts at feature_offsets_[b * (nmodel_features_ + 1)]; trees
+  // of a node are numbered from the first tree of its block
+  std::vector<size_t> feature_offsets_;
+  std::vector<float> thresholds_;
+  std::vector<uint32_t> tree_ids_;
+  std::vector<uint64_t> bitvectors_;
+  // leaves of tree t start at leaf_offsets_[t]
+  std::vector<size_t> leaf_offsets_;
+  std::vector<double> leaf_values_;
+  std::vector<double> weights_;
+
+  /// Numbers the leaves of the subtree in \a node from \a nleaves on, and
+  /// appends its internal nodes to \a nodes. Returns the number of leaves.
+  struct Node;
+  size_t add_subtree(RTNode const *node, const uint32_t tree_id,
+                     size_t nleaves, std::vector<Node> &nodes);
+
+  /// Adds to \a score the outputs of the trees of block \a b on document
+  /// \a d.
+  void score_block(const size_t b, const quickrank::Feature *d,
+                   const size_t nfeatures, uint64_t *leafidx,
+                   quickrank::Score &score) const;
+};
@@ -24,11 +24,14 @@
 #include <cfloat>
 #include <cmath>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #include "utils/maxheap.h"
 #include "data/vertical_dataset.h"
 #include "learning/tree/rtnode.h"
 #include "learning/tree/rtnode_histogram.h"
+#include "learning/tree/split_search.h"
 
 class RTNodeEnriched {
  public:
@@ -44,6 +47,25 @@ typedef MaxHeap<RTNode *> rt_maxheap;
 typedef MaxHeap<RTNodeEnriched *> rt_maxheap_enriched;
 
 class RegressionTree {
+ public:
+  /// Order in which the nodes of a tree are split.
+  ///
+  /// BEST_FIRST splits one node at a time, always the leaf with the largest
+  /// deviance. LEVEL_WISE splits all the leaves of a depth at once, with a
+  /// single pass over the data to build their histograms and a single
+  /// parallel sweep to find their splits.
+  enum class GrowthPolicy {
+    BEST_FIRST, LEVEL_WISE
+  };
+
+  static const std::vector<std::string> growthPolicyNames;
+
+  static GrowthPolicy get_growth_policy(std::string name);
+
+  static std::string get_growth_policy(GrowthPolicy growth_policy) {
+    return growthPolicyNames[static_cast<int>(growth_policy)];
+  }
+
  protected:
   // 0 for unlimited number of nodes (the size of the tree will then be
   // controlled only by minls)
@@ -57,15 +79,35 @@ class RegressionTree {
   RTNode *root = NULL;
   // see collapse_leaves_ in mart
   float collapse_leaves_factor;
+  GrowthPolicy growth_policy;
+  // maximum depth of LEVEL_WISE trees (0 for unlimited depth)
+  size_t max_depth;
+
+  // per-thread best splits, shared by the trees of a learner or owned by
+  // the tree when the learner does not provide them
+  split_search::ThreadBestSplits *thread_best_;
+  split_search::ThreadBestSplits own_thread_best_;
+
+  // samples of the tree: every node owns the range [sample_begin, sample_end)
+  // and a split partitions the range of the node in place
+  size_t *sampleids_ = NULL;
+  // scratch space of the partitioning, as large as sampleids_
+  size_t *partition_buffer_ = NULL;
 
  public:
   RegressionTree(size_t nrequiredleaves, quickrank::data::VerticalDataset *dps,
-                 double *labels, size_t minls, float collapse_leaves_factor)
+                 double *labels, size_t minls, float collapse_leaves_factor,
+                 GrowthPolicy growth_policy = GrowthPolicy::BEST_FIRST,
+                 size_t max_depth = 0,
+                 split_search::ThreadBestSplits *thread_best = NULL)
       : nrequiredleaves(nrequiredleaves),
         minls(minls),
         training_dataset(dps),
         training_labels(labels),
-        collapse_leaves_factor(collapse_leaves_factor) {
+        collapse_leaves_factor(collapse_leaves_factor),
+        growth_policy(growth_policy),
+        max_depth(max_depth),
+        thread_best_(thread_best ? thread_best : &own_thread_best_) {
   }
   ~RegressionTree();
 
@@ -82,7 +124,32 @@ class RegressionTree {
     return root;
   }
 
+ protected:
+  /// Copies the \a nsampleids samples of the root in the index buffer of
+  /// the tree, which is partitioned in place while the tree grows.
+  void init_samples(size_t const *sampleids, const size_t nsampleids);
+
+  /// Stably partitions the samples in [\a begin, \a end) so that the ones
+  /// whose bin of feature \a featureidx is not after \a thresholdid come
+  /// first. Returns the end of the left part.
+  ///
+  /// Large ranges are split in blocks partitioned in parallel, and the
+  /// partitioned blocks are then moved at their final offset.
+  size_t partition(const size_t begin, const size_t end,
+                   FeatureBins const *bins, const size_t featureidx,
+                   const size_t thresholdid);
+
  private:
+  /// Grows the tree level by level, up to max_depth and nrequiredleaves.
+  /// Collapsing leaves is not applied to level-wise trees.
+  void fit_levelwise(RTNodeHistogram *hist,
+                     size_t *sampleids,
+                     float max_features);
+
+  /// Returns a random subset of the features to be used for a split, or
+  /// NULL if all the features have to be used.
+  size_t *sample_features(const float max_features, size_t &nfeaturesamples);
+
   //if require_devianceltparent is true the node is split if minvar is lt the current node deviance (require_devianceltparent=false in RankLib)
   bool split(RTNode *node, const float max_features,
              const bool require_devianceltparent);
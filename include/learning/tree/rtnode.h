@@ -36,9 +36,12 @@ static const size_t uint_max = (size_t) -1;
 
 class RTNode {
 
+  friend class FlatTree;
+
  public:
-  size_t *sampleids = NULL;
-  size_t nsampleids = 0;
+  // samples of the node in the index buffer of the tree
+  size_t sample_begin = 0;
+  size_t sample_end = 0;
   float threshold = 0.0f;
   double deviance = 0.0;
   double avglabel = 0.0;
@@ -62,8 +65,6 @@ class RTNode {
     /*
      featureidx  = uint_max;
      featureid  = uint_max;
-     sampleids = NULL;
-     nsampleids = 0;
      deviance = -1;
      hist = NULL;
      left = NULL;
@@ -71,9 +72,9 @@ class RTNode {
      */
   }
 
-  RTNode(size_t *new_sampleids, size_t new_nsampleids, double prediction) {
-    sampleids = new_sampleids;
-    nsampleids = new_nsampleids;
+  RTNode(size_t new_sample_begin, size_t new_sample_end, double prediction) {
+    sample_begin = new_sample_begin;
+    sample_end = new_sample_end;
     avglabel = prediction;
   }
 
@@ -86,21 +87,20 @@ class RTNode {
     left = new_left;
     right = new_right;
     /*
-     sampleids = NULL;
-     nsampleids = 0;
      deviance = -1;
      hist = NULL;
      avglabel = 0.0;
      */
   }
 
-  RTNode(size_t *sampleids, RTNodeHistogram *hist) {
+  RTNode(size_t sample_begin, size_t sample_end, RTNodeHistogram *hist) {
 
     size_t last_threshold = hist->thresholds_size[0] - 1;
 
     this->hist = hist;
-    this->sampleids = sampleids;
-    nsampleids = hist->count[0][last_threshold];
+    this->sample_begin = sample_begin;
+    this->sample_end = sample_end;
+    const size_t nsampleids = hist->count[0][last_threshold];
     double sumlabel = hist->sumlbl[0][last_threshold];
     avglabel = nsampleids ? sumlabel / (double) nsampleids : 0.0;
     deviance = hist->squares_sum_ - pow(sumlabel, 2) / nsampleids;
@@ -111,16 +111,19 @@ class RTNode {
       delete left;
     if (right)
       delete right;
-//    if (sampleids != NULL)
-//      delete[] sampleids;
   }
+
+  size_t nsamples() const {
+    return sample_end - sample_begin;
+  }
+
   void set_feature(size_t fidx, size_t fid) {
     featureidx = fidx, featureid = fid;
   }
-  size_t get_feature_id() {
+  size_t get_feature_id() const {
     return featureid;
   }
-  size_t get_feature_idx() {
+  size_t get_feature_idx() const {
     return featureidx;
   }
 
@@ -21,29 +21,41 @@
  */
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "data/vertical_dataset.h"
+#include "learning/tree/feature_bins.h"
+#include "learning/tree/histogram_pool.h"
 
 class RTNodeHistogram {
  public:
   float **thresholds = NULL;      // [nfeatures] x [thresholds_size[i]]
   size_t *thresholds_size = NULL; // [nfeatures]
-  size_t **stmap = NULL;          // [nfeatures] x [nthresholds]
+  FeatureBins *bins = NULL;       // [nfeatures] x [ninstances], or sparse
   const size_t nfeatures = 0;
   double **sumlbl = NULL;         // [nfeatures] x [nthresholds]
   size_t **count = NULL;          // [nfeatures] x [nthresholds]
   double squares_sum_ = 0.0;
+  std::shared_ptr<HistogramPool> pool; // shared by the whole node hierarchy
+  HistogramBlock *block = NULL;   // memory of sumlbl and count
 
+  /// Creates an empty histogram whose memory comes from \a pool. If \a pool
+  /// is not given, a new pool is created for this histogram and its children.
   RTNodeHistogram(float **thresholds,
                   size_t *thresholds_size,
-                  size_t nfeatures);
+                  size_t nfeatures,
+                  std::shared_ptr<HistogramPool> pool = nullptr);
 
   RTNodeHistogram(RTNodeHistogram const *parent,
                   size_t const *sampleids,
                   const size_t nsampleids,
                   double const *labels);
 
+  /// Builds the histogram of a child by subtracting the histogram of its
+  /// \a sibling from the one of their \a parent.
   RTNodeHistogram(RTNodeHistogram const *parent,
-                  RTNodeHistogram const *left);
+                  RTNodeHistogram const *sibling);
 
   RTNodeHistogram(const RTNodeHistogram& source);
 
@@ -56,18 +68,55 @@ class RTNodeHistogram {
               const size_t nlabels,
               const size_t *sampleids);
 
-  void transform_intorightchild(RTNodeHistogram const *left);
+  /// Turns the histogram of a parent into the one of a child by subtracting
+  /// the histogram of the other child, i.e., its \a sibling.
+  void transform_intochild(RTNodeHistogram const *sibling);
 
   void quick_dump(size_t f, size_t num_t);
+
+  /// Builds the histograms of several nodes at once, with a single parallel
+  /// pass over the bins of every feature. The i-th histogram is built from
+  /// the \a nsampleids[i] samples in \a sampleids[i], and shares thresholds,
+  /// bins and memory pool with \a parents[i].
+  static std::vector<RTNodeHistogram *> build(
+      std::vector<RTNodeHistogram const *> const &parents,
+      std::vector<size_t const *> const &sampleids,
+      std::vector<size_t> const &nsampleids,
+      double const *labels);
+
+ protected:
+  /// Fills the (zeroed) histogram with the labels and the counts of the given
+  /// samples, and makes both of them cumulative.
+  ///
+  /// Large nodes with few features are split in blocks of samples, each one
+  /// accumulated by a thread in a private histogram, and the partial
+  /// histograms are merged by a feature-parallel reduction. Otherwise every
+  /// thread accumulates a subset of the features.
+  void accumulate(size_t const *sampleids, const size_t nsampleids,
+                  double const *labels);
+
+  /// Fills the (zeroed) histograms of several nodes from sparse bins, with a
+  /// single scan of the stored documents of every feature. The default bin
+  /// of a feature gets the samples of a node not found in the other bins.
+  static void accumulate_sparse(
+      std::vector<RTNodeHistogram *> const &hists,
+      std::vector<size_t const *> const &sampleids,
+      std::vector<size_t> const &nsampleids,
+      double const *labels);
 };
 
 class RTRootHistogram: public RTNodeHistogram {
  public:
+  /// Builds the root histogram and the bins of every training document.
+  /// The bins of a sparse dataset are sparse as well.
   RTRootHistogram(quickrank::data::VerticalDataset *dataset,
-                  size_t **sortedidx,
-                  size_t sortedidxsize,
                   float **thresholds,
-                  size_t *thresholds_size);
+                  size_t *thresholds_size,
+                  std::shared_ptr<HistogramPool> pool = nullptr);
 
   ~RTRootHistogram();
+
+ private:
+  /// Builds the sparse bins and the counts of a sparse dataset.
+  void build_sparse_bins(quickrank::data::VerticalDataset *dataset);
 };
@@ -0,0 +1,54 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Layout of the blocked scoring of tree ensembles.
+ *
+ * Large ensembles are scored one block of trees at a time, and each block
+ * of trees is applied to a block of documents before moving to the next
+ * one. Trees of a block should fit half of the L2 cache, so that they stay
+ * there while the documents of a block flow through them, and the
+ * documents of all the threads should fit the L3 cache, so that they are
+ * read from memory only once.
+ */
+namespace scoring_blocks {
+
+/// Returns the size in bytes of the data or unified cache of the given
+/// \a level, or a conservative default if it cannot be detected.
+size_t cache_size(unsigned int level);
+
+/// Splits trees in blocks of consecutive trees, given the bytes used by
+/// the scoring structures of each tree. Returns the first tree of each
+/// block followed by the number of trees.
+std::vector<size_t> tree_blocks(std::vector<size_t> const &tree_bytes);
+
+/// Returns the number of documents of a block when \a ninstances documents
+/// of \a nfeatures features are scored against \a ntree_blocks blocks of
+/// trees. A single block of trees does not need documents to be blocked.
+size_t documents_per_block(size_t ninstances, size_t nfeatures,
+                           size_t ntree_blocks);
+
+}  // namespace scoring_blocks
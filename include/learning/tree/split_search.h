@@ -0,0 +1,97 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Kernels searching the best split threshold of a feature histogram.
+ *
+ * Given the cumulative label sums and counts of a feature, a kernel looks
+ * for the threshold maximizing lsum^2/lcount + rsum^2/rcount, among the ones
+ * leaving at least \a minls samples on both sides. Ties are broken in favour
+ * of the first threshold, so all the kernels return the same split.
+ */
+namespace split_search {
+
+/// Returns the first threshold whose score is greater than \a best_score,
+/// and updates \a best_score with its score. Returns (size_t) -1 and leaves
+/// \a best_score unchanged if there is no such threshold.
+typedef size_t (*Kernel)(double const *sumlbl, size_t const *count,
+                         size_t nthresholds, size_t minls,
+                         double &best_score);
+
+/// Evaluates one threshold at a time.
+size_t best_split_scalar(double const *sumlbl, size_t const *count,
+                         size_t nthresholds, size_t minls,
+                         double &best_score);
+
+/// Evaluates 4 thresholds at a time. Requires AVX2.
+size_t best_split_avx2(double const *sumlbl, size_t const *count,
+                       size_t nthresholds, size_t minls,
+                       double &best_score);
+
+/// Evaluates 8 thresholds at a time. Requires AVX-512F.
+size_t best_split_avx512(double const *sumlbl, size_t const *count,
+                         size_t nthresholds, size_t minls,
+                         double &best_score);
+
+/// Returns the fastest kernel supported by the running CPU.
+Kernel best_kernel();
+
+/// Returns the name of the kernel returned by best_kernel().
+const char *best_kernel_name();
+
+/// Best split found by a thread. Every entry fills a cache line, so that
+/// threads updating their own entry do not share one.
+struct alignas(64) ThreadBestSplit {
+  double score;
+  size_t featureidx;
+  size_t thresholdid;
+};
+
+/**
+ * The best splits found by every thread during the search of a split.
+ *
+ * A learner keeps a single instance for all the splits of all its trees, so
+ * the entries are allocated once. They are aligned to 64 bytes, which a
+ * std::vector does not guarantee before C++17.
+ */
+class ThreadBestSplits {
+ public:
+  ThreadBestSplits() {}
+
+  ~ThreadBestSplits();
+
+  ThreadBestSplits(const ThreadBestSplits &) = delete;
+  ThreadBestSplits &operator=(const ThreadBestSplits &) = delete;
+
+  /// Returns \a nthreads entries with the given \a score and no split. The
+  /// entries are reallocated only when they are fewer than \a nthreads.
+  ThreadBestSplit *reset(size_t nthreads, double score);
+
+ private:
+  ThreadBestSplit *entries_ = NULL;
+  size_t size_ = 0;
+};
+
+}  // namespace split_search
@@ -0,0 +1,123 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "learning/tree/ensemble.h"
+#include "types.h"
+
+/**
+ * This class scores documents with a tree ensemble by means of the VPred
+ * algorithm (Asadi et al., IEEE TKDE 2014).
+ *
+ * Every tree is padded to a complete binary tree of its depth and stored in
+ * breadth-first order, so that the children of node i are 2i+1 and 2i+2.
+ * A leaf above the last level becomes a node always sending documents to
+ * the left, towards a copy of the leaf. A document then exits a tree after
+ * exactly depth steps of index arithmetic, without branches, and
+ * \a LOCKSTEP documents are moved through a tree together to hide the
+ * latency of their loads. With AVX2 each step of the lockstep documents is
+ * made of three gathers.
+ *
+ * Trees must be at most \a MAX_DEPTH deep, and each of them takes space
+ * exponential in its depth. Scores are the same of Ensemble::score_instance,
+ * as trees are accumulated in the same order.
+ */
+class VPred {
+ public:
+  /// Maximum depth of a tree.
+  static const size_t MAX_DEPTH = 16;
+  /// Number of documents moved together through a tree.
+  static const size_t LOCKSTEP = 8;
+
+  /// Returns true if every tree of \a ensemble can be scored by VPred.
+  static bool is_supported(const Ensemble &ensemble);
+
+  /// Lays out the trees of \a ensemble, which must be supported.
+  VPred(const Ensemble &ensemble);
+
+  size_t num_trees() const {
+    return ntrees_;
+  }
+
+  /// Returns the number of features used by the model.
+  size_t num_features() const {
+    return nmodel_features_;
+  }
+
+  /// Scores the \a ninstances documents stored by row in \a d, in parallel.
+  /// Documents must have at least num_features() features.
+  void score(const quickrank::Feature *d,
+             const size_t ninstances,
+             const size_t nfeatures,
+             quickrank::Score *scores) const;
+
+  /// Returns the name of the kernel used on the running CPU.
+  static const char *kernel_name();
+
+ private:
+  size_t ntrees_ = 0;
+  size_t nmodel_features_ = 0;
+  std::vector<size_t> depths_;
+  // nodes and leaves of tree t start at node_offsets_[t] and
+  // leaf_offsets_[t]
+  std::vector<size_t> node_offsets_;
+  std::vector<size_t> leaf_offsets_;
+  std::vector<int32_t> features_;
+  std::vector<float> thresholds_;
+  std::vector<double> leaves_;
+  std::vector<double> weights_;
+
+  /// Stores the subtree of \a node at position \a pos and depth \a level
+  /// of tree \a t, padding its leaves down to the last level of the tree.
+  void add_subtree(RTNode const *node, const size_t t, const size_t pos,
+                   const size_t level);
+
+  /// Adds to \a scores the outputs of trees [\a tree_begin, \a tree_end) on
+  /// the LOCKSTEP documents starting at \a d.
+  typedef void (VPred::*Kernel)(const quickrank::Feature *d,
+                                const size_t nfeatures,
+                                const size_t tree_begin,
+                                const size_t tree_end,
+                                quickrank::Score *scores) const;
+
+  void score_lockstep_scalar(const quickrank::Feature *d,
+                             const size_t nfeatures,
+                             const size_t tree_begin, const size_t tree_end,
+                             quickrank::Score *scores) const;
+
+  void score_lockstep_avx2(const quickrank::Feature *d,
+                           const size_t nfeatures,
+                           const size_t tree_begin, const size_t tree_end,
+                           quickrank::Score *scores) const;
+
+  /// Adds to \a score the outputs of trees [\a tree_begin, \a tree_end) on
+  /// document \a d.
+  void score_instance(const quickrank::Feature *d,
+                      const size_t tree_begin, const size_t tree_end,
+                      quickrank::Score &score) const;
+
+  static Kernel best_kernel();
+};
@@ -21,8 +21,11 @@
  */
 #pragma once
 
+#include <vector>
+
 #include "types.h"
 #include "metric.h"
+#include "metric/ir/dcg_tables.h"
 
 namespace quickrank {
 namespace metric {
@@ -52,8 +55,54 @@ class Dcg: public Metric {
   virtual MetricScore evaluate_result_list(
       const quickrank::data::QueryResults *rl, const Score *scores) const;
 
-  virtual std::unique_ptr<Jacobian> jacobian(
-      std::shared_ptr<data::RankedResults> ranked) const;
+  virtual bool evaluate_ranking(const quickrank::data::QueryResults *rl,
+                                const size_t *ranking,
+                                MetricScore &score) const;
+
+  /// The tables and the memory used by the list kernel of DCG and NDCG.
+  struct Workspace {
+    Workspace(const Dcg &metric, Label max_label, size_t max_results)
+        : tables(max_label, std::min(metric.cutoff(), max_results)),
+          ranking(max_results), labels(max_results) {
+    }
+    DcgTables tables;
+    std::vector<size_t> ranking;
+    std::vector<Label> labels;
+  };
+
+  /// Measures the DCG of a results list without virtual calls, nor
+  /// allocations. This is the list kernel of evaluate_lists.
+  MetricScore evaluate_list(const Label *labels, const Score *scores,
+                            const size_t nresults,
+                            Workspace &workspace) const;
+
+  virtual MetricScore evaluate_dataset(
+      const std::shared_ptr<data::Dataset> dataset, const Score *scores) const {
+    return evaluate_lists(*this, dataset->query_labels(0), scores,
+                          dataset->offsets(), dataset->num_queries());
+  }
+
+  virtual MetricScore evaluate_dataset(
+      const std::shared_ptr<data::VerticalDataset> dataset,
+      const Score *scores) const {
+    return evaluate_lists(*this, dataset->query_labels(0), scores,
+                          dataset->offsets(), dataset->num_queries());
+  }
+
+  using Metric::jacobian;
+
+  virtual void jacobian(data::RankedResults &ranked,
+                        const DcgTables &tables,
+                        ScratchArena &arena,
+                        Jacobian &jacobian) const;
+
+  /// Discounts are 1/log2(i+2) for the ranks in the cutoff and 0 beyond it,
+  /// gains are 2^l, where l is the label at every rank.
+  virtual bool swap_tables(const data::RankedResults &ranked,
+                           const DcgTables &tables,
+                           double *discounts,
+                           double *gains,
+                           double &normalization) const;
 
  protected:
   /// Computes the DCG\@K of a given array of labels.
@@ -61,6 +110,20 @@ class Dcg: public Metric {
   /// \return DCG\@K for computed on the given labels.
   MetricScore compute_dcg(const Label *labels, size_t len) const;
 
+  /// Computes the DCG\@K of a given array of labels by using \a tables.
+  MetricScore compute_dcg(const Label *labels, size_t len,
+                          const DcgTables &tables) const;
+
+  /// Fills the Jacobian of a ranked list with the gains and discounts of
+  /// \a tables, dividing its changes by \a normalization.
+  void fill_jacobian(const data::RankedResults &ranked,
+                     const DcgTables &tables, const double normalization,
+                     Jacobian &jacobian) const;
+
+  /// Fills the \a nresults \a discounts of the ranks of a list.
+  void fill_discounts(const size_t nresults, const DcgTables &tables,
+                      double *discounts) const;
+
  private:
   friend std::ostream &operator<<(std::ostream &os, const Dcg &ndcg) {
     return ndcg.put(os);
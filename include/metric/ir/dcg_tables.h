@@ -0,0 +1,81 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#include "types.h"
+
+namespace quickrank {
+namespace metric {
+namespace ir {
+
+/**
+ * Lookup tables of the gains and of the discounts used by DCG-like metrics,
+ * which avoid calling pow and log2 for every document of a results list.
+ *
+ * The tables are sized to the largest label and to the number of ranks
+ * measured, and hold exactly the values of the original expressions, so that
+ * metrics are not affected by their use.
+ */
+class DcgTables {
+ public:
+  /// Builds the gains of the integer labels from 0 to \a max_label and the
+  /// discounts of the first \a max_ranks ranks.
+  DcgTables(Label max_label, size_t max_ranks);
+
+  /// Returns the gain 2^l of a label, which is looked up if \a l is an
+  /// integer label in the table.
+  double gain(Label l) const {
+    if (l >= 0.0f && l < (Label) gains_.size()) {
+      const size_t i = (size_t) l;
+      if ((Label) i == l)
+        return gains_[i];
+    }
+    return pow(2.0, (double) l);
+  }
+
+  /// Returns the denominator log2(i+2) of the DCG term of rank \a i.
+  double log2_rank(size_t i) const {
+    return log2_ranks_[i];
+  }
+
+  /// Returns the discount 1/log2(i+2) of rank \a i used by the Jacobian.
+  double discount(size_t i) const {
+    return discounts_[i];
+  }
+
+  /// Returns the number of ranks in the tables.
+  size_t num_ranks() const {
+    return discounts_.size();
+  }
+
+ private:
+  std::vector<double> gains_;
+  std::vector<double> log2_ranks_;
+  std::vector<double> discounts_;
+};
+
+}  // namespace ir
+}  // namespace metric
+}  // namespace quickrank
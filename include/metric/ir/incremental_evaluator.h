@@ -0,0 +1,99 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+#include "data/dataset.h"
+#include "data/vertical_dataset.h"
+#include "metric/ir/metric.h"
+
+namespace quickrank {
+namespace metric {
+namespace ir {
+
+/**
+ * This class measures a dataset whose scores change a little at a time, as
+ * after each tree added by a boosting algorithm.
+ *
+ * The ranking of every results list is kept across calls, and it is repaired
+ * by insertion sort when the scores are updated. Lists whose ranking did not
+ * change within the metric cutoff keep the measure cached at the previous
+ * call, while the others are measured by Metric::evaluate_ranking. Lists with
+ * tied scores within the cutoff, and metrics not depending on the ranking
+ * alone, are measured from scratch, so that the result is always the one of
+ * Metric::evaluate_dataset.
+ */
+class IncrementalEvaluator {
+ public:
+  /// Creates the evaluator of the given \a metric on a \a dataset.
+  IncrementalEvaluator(std::shared_ptr<Metric> metric,
+                       std::shared_ptr<data::Dataset> dataset);
+
+  /// Creates the evaluator of the given \a metric on a vertical \a dataset.
+  IncrementalEvaluator(std::shared_ptr<Metric> metric,
+                       std::shared_ptr<data::VerticalDataset> dataset);
+
+  /// Measures the average quality of the results lists of the dataset.
+  ///
+  /// \param scores The current scores of the results of the dataset.
+  /// \return The same value of Metric::evaluate_dataset.
+  MetricScore evaluate(const Score *scores);
+
+  /// Returns the number of lists whose ranking changed at the last call.
+  size_t num_reranked() const {
+    return num_reranked_;
+  }
+
+ private:
+  /// Repairs the ranking of a list by insertion sort. Lists moving too many
+  /// results are sorted from scratch.
+  ///
+  /// \return The first rank whose result changed, or the number of results
+  /// if the ranking did not change.
+  static size_t rerank(const data::QueryResults &results, const Score *scores,
+                     size_t *ranking);
+
+  /// Initializes the state for the lists of a dataset.
+  void init(Label *labels, const size_t *offsets, size_t nqueries);
+
+  std::shared_ptr<Metric> metric_;
+  std::function<MetricScore(const Score *)> evaluate_dataset_;
+
+  Label *labels_ = NULL;
+  std::vector<size_t> offsets_;
+  std::vector<size_t> ranking_;
+  std::vector<MetricScore> query_scores_;
+  /// Non zero if the cached measure of a list is the one of its ranking.
+  std::vector<char> cached_;
+  /// True once the rankings have been built by a first call.
+  bool ranked_ = false;
+  bool rank_based_ = true;
+  size_t num_reranked_ = 0;
+};
+
+}  // namespace ir
+}  // namespace metric
+}  // namespace quickrank
@@ -51,8 +51,12 @@ class Map: public Metric {
   virtual MetricScore evaluate_result_list(
       const quickrank::data::QueryResults *rl, const Score *scores) const;
 
-  virtual std::unique_ptr<Jacobian> jacobian(
-      std::shared_ptr<data::RankedResults> ranked) const;
+  using Metric::jacobian;
+
+  virtual void jacobian(data::RankedResults &ranked,
+                        const DcgTables &tables,
+                        ScratchArena &arena,
+                        Jacobian &jacobian) const;
 
  protected:
 
@@ -22,8 +22,10 @@
 #pragma once
 
 #include <iostream>
+#include <algorithm>
 #include <climits>
 #include <memory>
+#include <vector>
 
 #include <stdint.h>
 
@@ -31,7 +33,9 @@
 #include "data/rankedresults.h"
 #include "data/dataset.h"
 #include "data/vertical_dataset.h"
+#include "metric/ir/dcg_tables.h"
 #include "types.h"
+#include "utils/scratch_arena.h"
 
 namespace quickrank {
 namespace metric {
@@ -74,18 +78,33 @@ class Metric {
   virtual MetricScore evaluate_result_list(
       const quickrank::data::QueryResults *rl, const Score *scores) const = 0;
 
+  /// Measures the quality of a results list given its \a ranking, i.e., the
+  /// indices of its results by decreasing score, where no scores are tied.
+  /// The quality must depend only on the results ranked within the cutoff.
+  ///
+  /// \param rl A results list.
+  /// \param ranking The indices of the results by decreasing score.
+  /// \param score Set to the quality of the results list.
+  /// \return false if the metric does not depend on the ranking alone, and
+  /// the list must be measured by evaluate_result_list instead.
+  virtual bool evaluate_ranking(const quickrank::data::QueryResults *rl,
+                                const size_t *ranking,
+                                MetricScore &score) const {
+    return false;
+  }
+
+  /// Measures the average quality of the results lists of a dataset.
+  ///
+  /// Lists are measured in parallel, and their measures are summed in the
+  /// order of the lists, so that the result does not depend on the number
+  /// of threads.
   virtual MetricScore evaluate_dataset(
       const std::shared_ptr<data::Dataset> dataset, const Score *scores) const {
     if (dataset->num_queries() == 0)
       return 0.0;
-    MetricScore avg_score = 0.0;
-
-//    #pragma omp parallel for reduction(+:avg_score)
-    for (size_t q = 0; q < dataset->num_queries(); q++) {
-      std::shared_ptr<data::QueryResults> r = dataset->getQueryResults(q);
-      avg_score += evaluate_result_list(r.get(), scores);
-      scores += r->num_results();
-    }
+    MetricScore avg_score = sum_result_lists(dataset->query_labels(0), scores,
+                                             dataset->offsets(),
+                                             dataset->num_queries());
     avg_score /= (MetricScore) dataset->num_queries();
     return avg_score;
   }
@@ -95,12 +114,9 @@ class Metric {
       const Score *scores) const {
     if (dataset->num_queries() == 0)
       return 0.0;
-    MetricScore avg_score = 0.0;
-    for (unsigned int q = 0; q < dataset->num_queries(); q++) {
-      std::shared_ptr<data::QueryResults> r = dataset->getQueryResults(q);
-      avg_score += evaluate_result_list(r.get(), scores);
-      scores += r->num_results();
-    }
+    MetricScore avg_score = sum_result_lists(dataset->query_labels(0), scores,
+                                             dataset->offsets(),
+                                             dataset->num_queries());
     avg_score /= (MetricScore) dataset->num_queries();
     return avg_score;
   }
@@ -108,32 +124,98 @@ class Metric {
   /// Computes the Jacobian matrix.
   /// This is a symmetric matrix storing the metric "decrease" when two documents scores
   /// are swapped.
+  /// It is filled by the arena-backed jacobian, with tables of the list.
   /// \param rl A results list.
   /// \return A smart-pointer to the Jacobian Matrix.
-  /// \todo TODO: provide def implementation
-  virtual std::unique_ptr<Jacobian> jacobian(
+  std::unique_ptr<Jacobian> jacobian(
       std::shared_ptr<data::RankedResults> ranked) const {
-    auto jacobian = std::unique_ptr<Jacobian>(
-        new Jacobian(ranked->num_results()));
-    auto results = std::shared_ptr<data::QueryResults>(
-        new data::QueryResults(ranked->num_results(), ranked->sorted_labels(),
-                               NULL));
-
-    MetricScore orig_score = evaluate_result_list(results.get(),
-                                                  ranked->sorted_scores());
-    const size_t size = std::min(cutoff(), results->num_results());
+    const size_t nresults = ranked->num_results();
+    const Label *labels = ranked->sorted_labels();
+    const DcgTables tables(nresults ? *std::max_element(labels,
+                                                        labels + nresults)
+                                    : 0.0f, nresults);
+    ScratchArena arena;
+    auto jacobian = std::unique_ptr<Jacobian>(new Jacobian(nresults));
+    this->jacobian(*ranked, tables, arena, *jacobian);
+    return jacobian;
+  }
+
+  /// Fills the Jacobian matrix of a ranked list without heap allocations:
+  /// temporary arrays are taken from \a arena, and gains and discounts from
+  /// \a tables. The default implementation measures every swap with
+  /// evaluate_result_list.
+  ///
+  /// \param ranked A ranked results list. Its scores are restored on exit.
+  /// \param tables The gains and discounts shared by all the lists of the
+  /// dataset, with at least the ranks of \a ranked.
+  /// \param arena The scratch memory of the calling thread.
+  /// \param jacobian The zero matrix to be filled, of the size of \a ranked.
+  virtual void jacobian(data::RankedResults &ranked,
+                        const DcgTables &tables,
+                        ScratchArena &arena,
+                        Jacobian &jacobian) const {
+    data::QueryResults results(ranked.num_results(), ranked.sorted_labels(),
+                               NULL);
+
+    MetricScore orig_score = evaluate_result_list(&results,
+                                                  ranked.sorted_scores());
+    const size_t size = std::min(cutoff(), results.num_results());
     for (size_t i = 0; i < size; ++i) {
-      double *p_jacobian = jacobian->vectat(i, i + 1);
-      for (size_t j = i + 1; j < results->num_results(); ++j) {
-        std::swap(ranked->sorted_scores()[i], ranked->sorted_scores()[j]);
-        MetricScore new_score = evaluate_result_list(results.get(),
-                                                     ranked->sorted_scores());
+      double *p_jacobian = jacobian.vectat(i, i + 1);
+      for (size_t j = i + 1; j < results.num_results(); ++j) {
+        std::swap(ranked.sorted_scores()[i], ranked.sorted_scores()[j]);
+        MetricScore new_score = evaluate_result_list(&results,
+                                                     ranked.sorted_scores());
         *p_jacobian++ = new_score - orig_score;
-        std::swap(ranked->sorted_scores()[i], ranked->sorted_scores()[j]);
+        std::swap(ranked.sorted_scores()[i], ranked.sorted_scores()[j]);
       }
     }
+  }
 
-    return jacobian;
+  /// Computes the tables giving the entries of the Jacobian on demand, so
+  /// that the Jacobian matrix does not need to be stored. The change of the
+  /// metric when the documents at ranks i and j are swapped is
+  /// (discounts[j] - discounts[i]) * (gains[i] - gains[j]) / normalization.
+  ///
+  /// \param ranked A ranked results list.
+  /// \param tables The gains and discounts shared by all the lists of the
+  /// dataset, with at least the ranks within the cutoff of \a ranked.
+  /// \param discounts Filled with the discount of every rank.
+  /// \param gains Filled with the gain of the document at every rank.
+  /// \param normalization Set to the normalization factor of the list.
+  /// \return false if the metric has no such tables, and the Jacobian
+  /// must be used instead.
+  virtual bool swap_tables(const data::RankedResults &ranked,
+                           const DcgTables &tables,
+                           double *discounts,
+                           double *gains,
+                           double &normalization) const {
+    return false;
+  }
+
+ protected:
+  /// Measures the \a nqueries results lists of a dataset in parallel with
+  /// evaluate_result_list, and returns the sum of their measures taken in
+  /// the order of the lists.
+  ///
+  /// \param labels The labels of all the results of the dataset.
+  /// \param scores The scores of all the results of the dataset.
+  /// \param offsets The offsets of the results lists (\a nqueries + 1).
+  /// \param nqueries The number of results lists.
+  MetricScore sum_result_lists(Label *labels, const Score *scores,
+                               const size_t *offsets,
+                               const size_t nqueries) const {
+    std::vector<MetricScore> query_scores(nqueries);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t q = 0; q < nqueries; ++q) {
+      const data::QueryResults results(offsets[q + 1] - offsets[q],
+                                       labels + offsets[q], NULL);
+      query_scores[q] = evaluate_result_list(&results, scores + offsets[q]);
+    }
+    MetricScore sum = 0.0;
+    for (size_t q = 0; q < nqueries; ++q)
+      sum += query_scores[q];
+    return sum;
   }
 
  private:
@@ -150,6 +232,58 @@ class Metric {
 
 };
 
+/// Measures the average quality of the \a nqueries results lists of a
+/// dataset with the list kernel of \a M, which is called without a virtual
+/// dispatch and without building a QueryResults object for every list.
+///
+/// \a M provides a Workspace, built from the metric, the largest label and
+/// the length of the longest list, and a non-virtual
+/// evaluate_list(labels, scores, nresults, workspace).
+///
+/// Lists are measured in parallel, each thread with its own workspace, and
+/// their measures are summed in the order of the lists, so that the result
+/// does not depend on the number of threads.
+///
+/// \param metric The metric.
+/// \param labels The labels of all the results of the dataset.
+/// \param scores The scores of all the results of the dataset.
+/// \param offsets The offsets of the results lists (\a nqueries + 1).
+/// \param nqueries The number of results lists.
+/// \return The average quality of the results lists.
+template<class M>
+MetricScore evaluate_lists(const M &metric, const Label *labels,
+                           const Score *scores, const size_t *offsets,
+                           const size_t nqueries) {
+  if (nqueries == 0)
+    return 0.0;
+
+  Label max_label = 0.0f;
+  #pragma omp parallel for reduction(max:max_label)
+  for (size_t i = offsets[0]; i < offsets[nqueries]; ++i)
+    max_label = std::max(max_label, labels[i]);
+  size_t max_results = 0;
+  for (size_t q = 0; q < nqueries; ++q)
+    max_results = std::max(max_results, offsets[q + 1] - offsets[q]);
+
+  std::vector<MetricScore> query_scores(nqueries);
+  #pragma omp parallel
+  {
+    typename M::Workspace workspace(metric, max_label, max_results);
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t q = 0; q < nqueries; ++q)
+      query_scores[q] = metric.M::evaluate_list(labels + offsets[q],
+                                                scores + offsets[q],
+                                                offsets[q + 1] - offsets[q],
+                                                workspace);
+  }
+
+  MetricScore avg_score = 0.0;
+  for (size_t q = 0; q < nqueries; ++q)
+    avg_score += query_scores[q];
+  avg_score /= (MetricScore) nqueries;
+  return avg_score;
+}
+
 }  // namespace ir
 }  // namespace metric
 }  // namespace quickrank
\ No newline at end of file
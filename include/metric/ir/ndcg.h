@@ -58,8 +58,42 @@ class Ndcg: public Dcg {
   virtual MetricScore evaluate_result_list(
       const quickrank::data::QueryResults *rl, const Score *scores) const;
 
-  virtual std::unique_ptr<Jacobian> jacobian(
-      std::shared_ptr<data::RankedResults> ranked) const;
+  virtual bool evaluate_ranking(const quickrank::data::QueryResults *rl,
+                                const size_t *ranking,
+                                MetricScore &score) const;
+
+  /// Measures the NDCG of a results list without virtual calls, nor
+  /// allocations. This is the list kernel of evaluate_lists.
+  MetricScore evaluate_list(const Label *labels, const Score *scores,
+                            const size_t nresults,
+                            Workspace &workspace) const;
+
+  virtual MetricScore evaluate_dataset(
+      const std::shared_ptr<data::Dataset> dataset, const Score *scores) const {
+    return evaluate_lists(*this, dataset->query_labels(0), scores,
+                          dataset->offsets(), dataset->num_queries());
+  }
+
+  virtual MetricScore evaluate_dataset(
+      const std::shared_ptr<data::VerticalDataset> dataset,
+      const Score *scores) const {
+    return evaluate_lists(*this, dataset->query_labels(0), scores,
+                          dataset->offsets(), dataset->num_queries());
+  }
+
+  using Metric::jacobian;
+
+  virtual void jacobian(data::RankedResults &ranked,
+                        const DcgTables &tables,
+                        ScratchArena &arena,
+                        Jacobian &jacobian) const;
+
+  /// The tables of DCG, normalized by the IDCG of the list.
+  virtual bool swap_tables(const data::RankedResults &ranked,
+                           const DcgTables &tables,
+                           double *discounts,
+                           double *gains,
+                           double &normalization) const;
 
  protected:
   /// Computes the IDCG\@K of a given list of labels.
@@ -67,6 +101,16 @@ class Ndcg: public Dcg {
   /// \return IDCG\@K for computed on the given labels.
   MetricScore compute_idcg(const quickrank::data::QueryResults *rl) const;
 
+  /// Computes the IDCG\@K of a given array of labels, by sorting a copy of
+  /// them in the \a workspace.
+  MetricScore compute_idcg(const Label *labels, const size_t nresults,
+                           Workspace &workspace) const;
+
+  /// Computes the IDCG\@K of a given array of labels with \a tables, by
+  /// sorting a copy of them in \a arena.
+  MetricScore compute_idcg(const Label *labels, const size_t nresults,
+                           const DcgTables &tables, ScratchArena &arena) const;
+
  private:
   friend std::ostream &operator<<(std::ostream &os, const Ndcg &ndcg) {
     return ndcg.put(os);
@@ -57,8 +57,44 @@ class Tndcg: public Ndcg {
   virtual MetricScore evaluate_result_list(
       const quickrank::data::QueryResults *rl, const Score *scores) const;
 
-  virtual std::unique_ptr<Jacobian> jacobian(
-      std::shared_ptr<data::RankedResults> ranked) const;
+  /// Ties make TNDCG depend on the scores, not only on the ranking of a
+  /// list, hence it cannot be measured from \a ranking alone.
+  /// \return Always false.
+  virtual bool evaluate_ranking(const quickrank::data::QueryResults *rl,
+                                const size_t *ranking,
+                                MetricScore &score) const {
+    return false;
+  }
+
+  /// Measures every list with evaluate_result_list, instead of the list
+  /// kernel of Ndcg, which breaks ties by position.
+  virtual MetricScore evaluate_dataset(
+      const std::shared_ptr<data::Dataset> dataset, const Score *scores) const {
+    return Metric::evaluate_dataset(dataset, scores);
+  }
+
+  virtual MetricScore evaluate_dataset(
+      const std::shared_ptr<data::VerticalDataset> dataset,
+      const Score *scores) const {
+    return Metric::evaluate_dataset(dataset, scores);
+  }
+
+  using Metric::jacobian;
+
+  virtual void jacobian(data::RankedResults &ranked,
+                        const DcgTables &tables,
+                        ScratchArena &arena,
+                        Jacobian &jacobian) const;
+
+  /// Ties make the changes of TNDCG depend on the scores, hence there are
+  /// no tables.
+  virtual bool swap_tables(const data::RankedResults &ranked,
+                           const DcgTables &tables,
+                           double *discounts,
+                           double *gains,
+                           double &normalization) const {
+    return false;
+  }
 
  protected:
   /// Computes the TNDCG\@K of a given list of labels.
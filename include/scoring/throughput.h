@@ -0,0 +1,106 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "data/dataset.h"
+#include "types.h"
+
+namespace quickrank {
+namespace scoring {
+
+/**
+ * This class measures the throughput and the latency of a scoring function
+ * serving the queries of a dataset on several cores.
+ *
+ * Queries are the unit of work: each thread takes the next query to be
+ * scored, and scores its documents in batches of at most \a batch_size
+ * documents. The latency of a query is the time spent by the thread on its
+ * batches. Threads can be pinned to distinct CPUs, among the ones the
+ * process is allowed to run on.
+ */
+class ThroughputBenchmark {
+ public:
+  /// Scores the \a n documents stored by row in \a d, whose features are
+  /// \a nfeatures apart, into \a scores.
+  typedef std::function<void(const Feature *d, size_t n, size_t nfeatures,
+                             Score *scores)> BatchScorer;
+
+  /// Measures of a run with a given number of threads.
+  struct Result {
+    size_t nthreads = 0;
+    double seconds = 0.0;            // of the timed rounds
+    double documents_per_second = 0.0;
+    std::vector<double> latencies;   // of every query in every timed round
+  };
+
+  /// \param batch_size Maximum number of documents scored by a call of
+  /// \a scorer, 0 means a whole query.
+  /// \param warmup_rounds Rounds over the dataset run before timing.
+  /// \param rounds Timed rounds over the dataset.
+  /// \param pin Pins the i-th thread to the i-th allowed CPU.
+  ThroughputBenchmark(std::shared_ptr<data::Dataset> dataset,
+                      BatchScorer scorer,
+                      const size_t batch_size,
+                      const size_t warmup_rounds,
+                      const size_t rounds,
+                      const bool pin);
+
+  /// Scores the dataset with \a nthreads threads, storing the scores of the
+  /// last round in \a scores.
+  Result run(const size_t nthreads, Score *scores) const;
+
+  /// Returns the thread counts of a scaling curve up to \a max_threads,
+  /// i.e., the powers of two smaller than \a max_threads and \a max_threads.
+  static std::vector<size_t> thread_counts(const size_t max_threads);
+
+  /// Returns the \a p quantile of \a values, with the nearest-rank method.
+  static double percentile(std::vector<double> values, const double p);
+
+  /// Prints a line of the scaling curve, given the \a baseline run with a
+  /// single thread.
+  static void print_scaling(std::ostream &os, const Result &result,
+                            const Result &baseline);
+
+  /// Prints the p50 and p99 latencies of the queries of \a result, grouped
+  /// by their number of documents in powers of ten.
+  void print_latencies(std::ostream &os, const Result &result) const;
+
+ private:
+  std::shared_ptr<data::Dataset> dataset_;
+  BatchScorer scorer_;
+  size_t batch_size_;
+  size_t warmup_rounds_;
+  size_t rounds_;
+  bool pin_;
+  std::vector<int> cpus_;  // allowed CPUs, used when pinning
+
+  /// Scores query \a q in batches and returns the elapsed seconds.
+  double score_query(const size_t q, Score *scores) const;
+};
+
+}  // namespace scoring
+}  // namespace quickrank
@@ -23,4 +23,6 @@
 
 const int omp_get_num_procs();
 const int omp_get_thread_num();
+const int omp_get_num_threads();
+const int omp_get_max_threads();
 const double omp_get_wtime();
\ No newline at end of file
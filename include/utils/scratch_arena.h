@@ -0,0 +1,95 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * This class provides the scratch memory of a thread for short-lived
+ * arrays, e.g., the ones needed to process a query.
+ *
+ * Arrays are carved out of a single block and are all released together by
+ * \a reset. When the block is exhausted, a new block is added; at the
+ * next reset, the blocks are replaced by a single one as large as the
+ * peak usage. After the first rounds, e.g., after the longest query has
+ * been seen, arrays are thus provided without any heap allocation.
+ */
+class ScratchArena {
+ public:
+  ScratchArena() {}
+
+  /// Makes room for \a bytes of arrays without further heap allocations.
+  /// Must be called when no array is in use.
+  void reserve(size_t bytes);
+
+  /// Returns an uninitialized array of \a n elements, valid until the next
+  /// call of \a reset.
+  template<typename T>
+  T *allocate(size_t n) {
+    const size_t bytes = array_bytes<T>(n);
+    if (used_ + bytes > capacity_)
+      grow(bytes);
+    T *array = reinterpret_cast<T *>(block_.get() + offset_ + used_);
+    used_ += bytes;
+    requested_ += bytes;
+    return array;
+  }
+
+  /// Returns the bytes taken in the arena by an array of \a n elements.
+  template<typename T>
+  static size_t array_bytes(size_t n) {
+    return (n * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  }
+
+  /// Releases every array.
+  void reset();
+
+  /// Returns the bytes available without heap allocations.
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  /// Returns the number of heap allocations done so far.
+  size_t num_allocations() const {
+    return nallocations_;
+  }
+
+ private:
+  static const size_t ALIGNMENT = 64;
+
+  std::unique_ptr<char[]> block_;
+  // exhausted blocks, still in use until the next reset
+  std::vector<std::unique_ptr<char[]>> full_blocks_;
+  size_t offset_ = 0;     // of the first aligned byte of block_
+  size_t capacity_ = 0;
+  size_t used_ = 0;
+  size_t requested_ = 0;  // since the last reset, in all the blocks
+  size_t nallocations_ = 0;
+
+  /// Replaces the current block with one of at least \a bytes.
+  void grow(size_t bytes);
+
+  /// Allocates a block of \a bytes aligned to ALIGNMENT.
+  void new_block(size_t bytes);
+};
@@ -21,6 +21,7 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <cstdlib>
 
 /*! \def sm2v(i,j,size)
@@ -38,11 +39,25 @@ class SymMatrix {
    * @param size order of the matrix.
    */
   SymMatrix(size_t size)
-      : size(size) {
-    data = size > 0 ? new T[size * (size + 1) / 2]() : NULL;
+      : size(size), owner(true) {
+    data = size > 0 ? new T[num_elements(size)]() : NULL;
+  }
+  /** \brief constructor of a matrix stored in \a storage, which holds num_elements(\a size) elements and is not released by the matrix. The matrix is set to zero.
+   * @param size order of the matrix.
+   * @param storage memory of the matrix.
+   */
+  SymMatrix(size_t size, T *storage)
+      : data(storage), size(size), owner(false) {
+    std::fill(data, data + num_elements(size), T());
   }
   ~SymMatrix() {
-    delete[] data;
+    if (owner)
+      delete[] data;
+  }
+  /** \brief return the number of elements stored by a matrix of order \a size.
+   */
+  static size_t num_elements(const size_t size) {
+    return size * (size + 1) / 2;
   }
   /** \brief return the element at position ( \a i, \a j ) for left-hand operation.
    * @param i row in [0 .. \a size -1]
@@ -85,6 +100,7 @@ class SymMatrix {
  private:
   T *data;
   size_t size;
+  bool owner;
 };
 
 #undef sm2v
\ No newline at end of file
@@ -53,7 +53,26 @@ Dataset::Dataset(size_t n_instances, size_t n_features) {
   offsets_.push_back(0);
 }
 
+Dataset::Dataset(size_t n_instances, size_t n_features,
+                 quickrank::Feature *data, quickrank::Label *labels,
+                 std::vector<size_t> offsets, std::shared_ptr<void> storage,
+                 quickrank::Feature *vertical_data)
+    : offsets_(std::move(offsets)), storage_(storage) {
+  max_instances_ = n_instances;
+  num_features_ = n_features;
+  num_instances_ = n_instances;
+  num_queries_ = offsets_.size() - 1;
+  last_instance_id_ = 0;
+
+  data_ = data;
+  labels_ = labels;
+  vertical_data_ = vertical_data;
+}
+
 Dataset::~Dataset() {
+  // wrapped memory is released by its owner
+  if (storage_)
+    return;
   if (data_)
     free(data_);
   if (labels_)
@@ -85,6 +104,27 @@ void Dataset::addInstance(QueryID q_id, Label i_label,
   offsets_.back() = num_instances_;
 }
 
+void Dataset::setQueryIds(const QueryID *q_ids, size_t n_instances) {
+
+  if (n_instances > max_instances_) {
+    std::cerr << "!!! Impossible to set more instances than the dataset size."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  num_instances_ = n_instances;
+  num_queries_ = 0;
+  offsets_.assign(1, 0);
+  for (size_t i = 0; i < n_instances; ++i) {
+    if (i == 0 || q_ids[i] != q_ids[i - 1]) {
+      num_queries_++;
+      offsets_.push_back(0);
+    }
+    offsets_.back() = i + 1;
+  }
+  last_instance_id_ = n_instances ? q_ids[n_instances - 1] : 0;
+}
+
 std::unique_ptr<QueryResults> Dataset::getQueryResults(size_t i) const {
   size_t num_results = offsets_[i + 1] - offsets_[i];
   quickrank::Feature *start_data = data_ + offsets_[i] * num_features_;
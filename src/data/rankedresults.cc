@@ -39,7 +39,24 @@ RankedResults::RankedResults(std::shared_ptr<QueryResults> results,
   }
 }
 
+RankedResults::RankedResults(const QueryResults &results,
+                             const Score *scores, ScratchArena &arena)
+    : owner_(false) {
+  num_results_ = results.num_results();
+  unmap_ = arena.allocate<size_t>(num_results_);
+  results.indexing_of_sorted_labels(scores, unmap_);
+
+  labels_ = arena.allocate<Label>(num_results_);
+  scores_ = arena.allocate<Score>(num_results_);
+  for (size_t i = 0; i < num_results_; i++) {
+    labels_[i] = results.labels()[unmap_[i]];
+    scores_[i] = scores[unmap_[i]];
+  }
+}
+
 RankedResults::~RankedResults() {
+  if (!owner_)
+    return;
   if (labels_)
     delete[] labels_;
   if (scores_)
@@ -26,26 +26,77 @@
 namespace quickrank {
 namespace data {
 
-VerticalDataset::VerticalDataset(std::shared_ptr<Dataset> h_dataset) {
+VerticalDataset::VerticalDataset(std::shared_ptr<Dataset> h_dataset,
+                                 bool sparse) {
   num_features_ = h_dataset->num_features();
   num_instances_ = h_dataset->num_instances();
   num_queries_ = h_dataset->num_queries();
+  sparse_ = sparse;
 
-  // transpose dataset
-  if (posix_memalign((void **) &data_,
-                     16,
-                     num_instances_ * num_features_ * sizeof(Feature)) != 0) {
-    std::cerr
-        << "!!! Impossible to allocate memory for transposed dataset storage."
-        << std::endl;
-    exit(EXIT_FAILURE);
-  }
+  if (sparse) {
+    if (num_instances_ > UINT32_MAX) {
+      std::cerr << "!!! Sparse datasets support up to " << UINT32_MAX
+                << " documents." << std::endl;
+      exit(EXIT_FAILURE);
+    }
 
-  quickrank::Feature *h_data = h_dataset->at(0, 0);
-  #pragma omp parallel for
-  for (size_t i = 0; i < num_instances_; ++i) {
+    // read the column-major copy if available, the horizontal data otherwise
+    quickrank::Feature const *data = h_dataset->vertical_data();
+    size_t instance_stride = 1, feature_stride = num_instances_;
+    if (!data) {
+      data = h_dataset->at(0, 0);
+      instance_stride = num_features_;
+      feature_stride = 1;
+    }
+
+    nonzero_offsets_.assign(num_features_ + 1, 0);
+    #pragma omp parallel for
+    for (size_t f = 0; f < num_features_; ++f) {
+      quickrank::Feature const *values = data + f * feature_stride;
+      size_t nnz = 0;
+      for (size_t i = 0; i < num_instances_; ++i)
+        nnz += values[i * instance_stride] != 0.0f;
+      nonzero_offsets_[f + 1] = nnz;
+    }
+    for (size_t f = 0; f < num_features_; ++f)
+      nonzero_offsets_[f + 1] += nonzero_offsets_[f];
+
+    nonzero_documents_.resize(nonzero_offsets_[num_features_]);
+    nonzero_values_.resize(nonzero_offsets_[num_features_]);
+    #pragma omp parallel for
     for (size_t f = 0; f < num_features_; ++f) {
-      data_[f * num_instances_ + i] = h_data[i * num_features_ + f];
+      quickrank::Feature const *values = data + f * feature_stride;
+      size_t k = nonzero_offsets_[f];
+      for (size_t i = 0; i < num_instances_; ++i) {
+        const quickrank::Feature value = values[i * instance_stride];
+        if (value != 0.0f) {
+          nonzero_documents_[k] = (uint32_t) i;
+          nonzero_values_[k++] = value;
+        }
+      }
+    }
+  } else if (h_dataset->vertical_data()) {
+    // the column-major copy is already available (e.g., from a binary
+    // dataset file): share it instead of transposing
+    storage_ = h_dataset->storage();
+    data_ = h_dataset->vertical_data();
+  } else {
+    // transpose dataset
+    if (posix_memalign((void **) &data_,
+                       16,
+                       num_instances_ * num_features_ * sizeof(Feature)) != 0) {
+      std::cerr
+          << "!!! Impossible to allocate memory for transposed dataset storage."
+          << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    quickrank::Feature *h_data = h_dataset->at(0, 0);
+    #pragma omp parallel for
+    for (size_t i = 0; i < num_instances_; ++i) {
+      for (size_t f = 0; f < num_features_; ++f) {
+        data_[f * num_instances_ + i] = h_data[i * num_features_ + f];
+      }
     }
   }
 
@@ -70,7 +121,7 @@ VerticalDataset::VerticalDataset(std::shared_ptr<Dataset> h_dataset) {
 }
 
 VerticalDataset::~VerticalDataset() {
-  if (data_)
+  if (data_ && !storage_)
     free(data_);
   if (labels_)
     free(labels_);
@@ -79,7 +130,7 @@ VerticalDataset::~VerticalDataset() {
 
 std::unique_ptr<QueryResults> VerticalDataset::getQueryResults(size_t i) const {
   size_t num_results = offsets_[i + 1] - offsets_[i];
-  quickrank::Feature *start_data = data_ + offsets_[i];
+  quickrank::Feature *start_data = data_ ? data_ + offsets_[i] : NULL;
   quickrank::Label *start_label = labels_ + offsets_[i];
 
   QueryResults *qr = new QueryResults(num_results, start_label, start_data);
@@ -94,6 +145,11 @@ std::ostream &VerticalDataset::put(std::ostream &os) const {
      << " (instances x features)" << std::endl << "#\t Num queries: "
      << num_queries_ << " | Avg. len: " << std::setprecision(3)
      << num_instances_ / (float) num_queries_ << std::endl;
+  if (sparse_)
+    os << "#\t Non-zero values: " << nonzero_values_.size() << " ("
+       << std::setprecision(3)
+       << 100.0 * nonzero_values_.size() / (num_instances_ * num_features_)
+       << "% dense)" << std::endl;
   return os;
 }
 
@@ -19,6 +19,8 @@
  * Contributor:
  *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
  */
+#include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <fstream>
 #include <limits>
@@ -28,6 +30,7 @@
 
 #include "driver/driver.h"
 #include "io/svml.h"
+#include "io/binary.h"
 #include "learning/ltr_algorithm_factory.h"
 #include "optimization/optimization_factory.h"
 #include "metric/metric_factory.h"
@@ -45,11 +48,45 @@ Driver::~Driver() {
 int Driver::run(ParamsMap &pmap) {
 
   if (!pmap.isSet("train") && !pmap.isSet("train-partial") &&
-      !pmap.isSet("test") && !pmap.isSet("model-file")) {
+      !pmap.isSet("test") && !pmap.isSet("model-file") &&
+      !pmap.isSet("convert-in")) {
     std::cout << pmap.help();
     exit(EXIT_FAILURE);
   }
 
+  if (pmap.isSet("convert-in") != pmap.isSet("convert-out")) {
+    std::cerr << "!!! Dataset conversion requires both --convert-in and "
+              << "--convert-out." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Dataset conversion
+  // if the input and output files are set, the dataset is converted before
+  // any other phase, so that it can be directly used by them.
+  if (pmap.isSet("convert-in") && pmap.isSet("convert-out")) {
+    std::string input_filename = pmap.get<std::string>("convert-in");
+    std::string output_filename = pmap.get<std::string>("convert-out");
+    std::string output_format = pmap.get<std::string>("convert-format");
+
+    std::shared_ptr<quickrank::data::Dataset> dataset =
+        load_dataset(input_filename, "input");
+
+    if (output_format == "binary") {
+      quickrank::io::Binary writer;
+      writer.write(dataset, output_filename);
+    } else if (output_format == "svml") {
+      quickrank::io::Svml writer;
+      writer.write(dataset, output_filename);
+    } else {
+      std::cerr << " !! Unknown dataset format: " << output_format
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    std::cout << "# Dataset written to file: " << output_filename
+              << " (" << output_format << " format)" << std::endl
+              << std::endl;
+  }
+
   if (pmap.isSet("train") || pmap.isSet("train-partial") ||
       pmap.isSet("test")) {
 
@@ -62,6 +99,8 @@ int Driver::run(ParamsMap &pmap) {
 
     std::cout << std::endl << *ranking_algorithm << std::endl;
 
+    std::shared_ptr<quickrank::data::Dataset> validation_dataset;
+
     // If there is the training dataset, it means we have to execute
     // the training phase and/or the optimization phase (at least one of them)
     if (pmap.isSet("train") || pmap.isSet("train-partial")) {
@@ -97,7 +136,6 @@ int Driver::run(ParamsMap &pmap) {
         validation_partial_filename = pmap.get<std::string>("valid-partial");
 
       std::shared_ptr<quickrank::data::Dataset> training_dataset;
-      std::shared_ptr<quickrank::data::Dataset> validation_dataset;
 
       if (!training_filename.empty())
         training_dataset = load_dataset(training_filename, "training");
@@ -184,13 +222,57 @@ int Driver::run(ParamsMap &pmap) {
         exit(EXIT_FAILURE);
       }
 
+      // documents dropped by top-k scoring keep an upper bound of their score,
+      // which is only safe to evaluate when they all rank past the cutoff
+      const size_t top_k = pmap.get<size_t>("top-k");
+      if (top_k && top_k < testing_metric->cutoff()) {
+        std::cerr << "!!! Top-k scoring requires --top-k at least as large as "
+                  << "the test metric cutoff." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+
       std::cout << "# test scorer: " << *testing_metric << std::endl << "#" <<
                 std::endl;
+
+      std::string scoring_engine = pmap.get<std::string>("scoring-engine");
+      if (!ranking_algorithm->set_scoring_engine(scoring_engine)
+          && scoring_engine != "auto") {
+        std::cerr << "!!! Scoring engine " << scoring_engine
+                  << " applies only to ensemble models." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+
+      std::string leaf_precision = pmap.get<std::string>("leaf-precision");
+      if (leaf_precision != "double") {
+        if (top_k) {
+          std::cerr << "!!! Top-k scoring supports only the double leaf "
+                    << "precision." << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        if (!ranking_algorithm->set_leaf_precision(leaf_precision)) {
+          std::cerr << "!!! Leaf precision " << leaf_precision
+                    << " applies only to ensemble models." << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        if (!validation_dataset && pmap.isSet("valid"))
+          validation_dataset = load_dataset(pmap.get<std::string>("valid"),
+                                            "validation");
+        if (validation_dataset)
+          leaf_precision_report(ranking_algorithm, testing_metric,
+                                validation_dataset, "validation",
+                                leaf_precision);
+        else if (test_dataset)
+          leaf_precision_report(ranking_algorithm, testing_metric,
+                                test_dataset, "test", leaf_precision);
+      }
+
       testing_phase(ranking_algorithm,
                     testing_metric,
                     test_dataset,
                     scores_filename,
-                    detailed_testing);
+                    detailed_testing,
+                    top_k,
+                    pmap.get<double>("top-k-bound"));
     }
   }
 
@@ -275,7 +357,8 @@ void Driver::optimization_phase(
       validation_partial_dataset = load_dataset(validation_partial_filename,
                                                 "validation (partial)");
 
-    quickrank::io::Svml svml;
+    // partial scores are cached in binary format for fast reloading
+    quickrank::io::Binary writer;
     if (!training_partial_dataset && training_dataset) {
 
       training_partial_dataset = Driver::extract_partial_scores(
@@ -284,7 +367,8 @@ void Driver::optimization_phase(
           true);
 
       if (!training_partial_filename.empty())
-        svml.write(training_partial_dataset, training_partial_filename);
+        writer.write(training_partial_dataset, training_partial_filename,
+                     false);
     }
 
     if (!validation_partial_dataset && validation_dataset) {
@@ -295,7 +379,8 @@ void Driver::optimization_phase(
           true);
 
       if (!validation_partial_filename.empty())
-        svml.write(validation_partial_dataset, validation_partial_filename);
+        writer.write(validation_partial_dataset, validation_partial_filename,
+                     false);
     }
   }
 
@@ -328,7 +413,9 @@ void Driver::testing_phase(
     std::shared_ptr<quickrank::metric::ir::Metric> test_metric,
     std::shared_ptr<quickrank::data::Dataset> test_dataset,
     const std::string scores_filename,
-    const bool detailed_testing) {
+    const bool detailed_testing,
+    const size_t top_k,
+    const double top_k_bound) {
 
   if (test_metric and test_dataset) {
 
@@ -360,7 +447,28 @@ void Driver::testing_phase(
                 << std::endl;
 
     } else {
-      algo->score_dataset(test_dataset, &scores[0]);
+      if (top_k) {
+        std::vector<learning::TopKStats> query_stats(
+            test_dataset->num_queries());
+        #pragma omp parallel for schedule(dynamic)
+        for (size_t q = 0; q < test_dataset->num_queries(); ++q) {
+          auto results = test_dataset->getQueryResults(q);
+          query_stats[q] = algo->score_top_k(
+              *results, test_dataset->num_features(), top_k,
+              &scores[test_dataset->offset(q)], top_k_bound);
+        }
+        learning::TopKStats stats;
+        for (auto &s: query_stats)
+          stats += s;
+        const size_t total = stats.evaluations + stats.saved_evaluations;
+        std::cout << "# Top-" << top_k << " scoring: saved "
+                  << stats.saved_evaluations << " of " << total
+                  << " evaluations (" << std::setprecision(2)
+                  << 100.0 * stats.saved_evaluations / std::max<size_t>(total, 1)
+                  << "%), dropped " << stats.pruned_documents
+                  << " documents." << std::endl;
+      } else
+        algo->score_dataset(test_dataset, &scores[0]);
       quickrank::MetricScore test_score = test_metric->evaluate_dataset(
           test_dataset, &scores[0]);
 
@@ -384,19 +492,76 @@ void Driver::testing_phase(
   algo->print_additional_stats();
 }
 
+void Driver::leaf_precision_report(
+    std::shared_ptr<learning::LTR_Algorithm> algo,
+    std::shared_ptr<metric::ir::Metric> metric,
+    std::shared_ptr<data::Dataset> dataset,
+    const std::string dataset_label,
+    const std::string leaf_precision) {
+
+  const size_t ninstances = dataset->num_instances();
+  std::vector<Score> full(ninstances), quantized(ninstances);
+  algo->set_leaf_precision("double");
+  algo->score_dataset(dataset, &full[0]);
+  algo->set_leaf_precision(leaf_precision);
+  algo->score_dataset(dataset, &quantized[0]);
+
+  double max_deviation = 0.0;
+  for (size_t i = 0; i < ninstances; ++i)
+    max_deviation = std::max(max_deviation,
+                             std::fabs(full[i] - quantized[i]));
+
+  // a query is ranked differently if the sorted documents differ
+  size_t nchanged = 0;
+  #pragma omp parallel for reduction(+:nchanged)
+  for (size_t q = 0; q < dataset->num_queries(); ++q) {
+    const size_t offset = dataset->offset(q);
+    const size_t nresults = dataset->offset(q + 1) - offset;
+    std::vector<size_t> by_full(nresults), by_quantized(nresults);
+    std::iota(by_full.begin(), by_full.end(), offset);
+    std::iota(by_quantized.begin(), by_quantized.end(), offset);
+    std::stable_sort(by_full.begin(), by_full.end(),
+                     [&full](size_t a, size_t b) {
+                       return full[a] > full[b];
+                     });
+    std::stable_sort(by_quantized.begin(), by_quantized.end(),
+                     [&quantized](size_t a, size_t b) {
+                       return quantized[a] > quantized[b];
+                     });
+    if (by_full != by_quantized)
+      ++nchanged;
+  }
+
+  const MetricScore full_score = metric->evaluate_dataset(dataset, &full[0]);
+  const MetricScore quantized_score = metric->evaluate_dataset(dataset,
+                                                               &quantized[0]);
+  std::cout << "# Leaf precision " << leaf_precision << " on "
+            << dataset_label << " data: max score deviation "
+            << std::scientific << std::setprecision(3) << max_deviation
+            << std::fixed << ", " << nchanged << " of "
+            << dataset->num_queries() << " queries ranked differently, "
+            << *metric << " " << std::setprecision(4) << full_score << " -> "
+            << quantized_score << std::endl;
+}
+
 std::shared_ptr<quickrank::data::Dataset> Driver::load_dataset(
     const std::string dataset_filename,
     const std::string dataset_label) {
 
-  // create reader: assume svml as ltr format
-  quickrank::io::Svml reader;
-
   std::shared_ptr<quickrank::data::Dataset> dataset = nullptr;
   if (!dataset_filename.empty()) {
     std::cout << "# Reading " + dataset_label + " dataset: " <<
               dataset_filename << std::endl;
-    dataset = reader.read_horizontal(dataset_filename);
-    std::cout << reader << *dataset << std::endl;
+    // create reader: binary format if detected, otherwise svml
+    if (quickrank::io::Binary::is_binary(dataset_filename)) {
+      quickrank::io::Binary reader;
+      dataset = reader.read_horizontal(dataset_filename);
+      std::cout << reader << *dataset << std::endl;
+    } else {
+      quickrank::io::Svml reader;
+      dataset = reader.read_horizontal(dataset_filename);
+      std::cout << reader << *dataset << std::endl;
+    }
   }
 
   if (!dataset) {
@@ -0,0 +1,259 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "io/binary.h"
+
+namespace quickrank {
+namespace io {
+
+namespace {
+
+const char MAGIC[8] = {'Q', 'R', 'B', 'D', 'A', 'T', 'A', '\0'};
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const size_t SECTION_ALIGNMENT = 64;
+
+/// Layout of the file header. Offsets are in bytes from the file beginning,
+/// a zero offset means the section is missing.
+struct BinaryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t label_size;
+  uint32_t feature_size;
+  uint64_t num_instances;
+  uint64_t num_features;
+  uint64_t num_queries;
+  uint64_t labels_offset;
+  uint64_t offsets_offset;
+  uint64_t horizontal_offset;
+  uint64_t vertical_offset;
+  uint64_t file_size;
+};
+
+size_t align_section(size_t offset) {
+  return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT
+      * SECTION_ALIGNMENT;
+}
+
+void format_error(const std::string &file, const std::string &what) {
+  std::cerr << "!!! Invalid binary dataset " << file << ": " << what
+            << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+void write_padding(std::ofstream &out, size_t bytes) {
+  static const char padding[SECTION_ALIGNMENT] = {0};
+  out.write(padding, align_section(bytes) - bytes);
+}
+
+void write_section(std::ofstream &out, const void *data, size_t bytes) {
+  out.write((const char *) data, bytes);
+  write_padding(out, bytes);
+}
+
+}  // namespace
+
+bool Binary::is_binary(const std::string &file) {
+  char magic[sizeof(MAGIC)];
+  std::ifstream in(file, std::ifstream::in | std::ifstream::binary);
+  return in.read(magic, sizeof(magic))
+      && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+std::unique_ptr<data::Dataset> Binary::read_horizontal(
+    const std::string &file) {
+
+  auto start_reading = std::chrono::high_resolution_clock::now();
+
+  int fd = open(file.c_str(), O_RDONLY);
+  struct stat filestatus;
+  if (fd == -1 || fstat(fd, &filestatus) != 0) {
+    std::cerr << "!!! Impossible to open input file " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  file_size_ = filestatus.st_size;
+  if ((size_t) file_size_ < sizeof(BinaryHeader))
+    format_error(file, "truncated header");
+
+  // private writable mapping: pages are copied only if the data is modified
+  void *map = mmap(NULL, file_size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                   0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    std::cerr << "!!! Impossible to map input file " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t map_size = file_size_;
+  std::shared_ptr<void> storage(map, [map_size](void *p) {
+    munmap(p, map_size);
+  });
+  char *base = (char *) map;
+
+  const BinaryHeader *header = (const BinaryHeader *) base;
+  if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+    format_error(file, "wrong magic string");
+  if (header->version != VERSION)
+    format_error(file, "unsupported version " +
+        std::to_string(header->version));
+  if (header->byte_order != BYTE_ORDER_MARK)
+    format_error(file, "byte order mismatch");
+  if (header->label_size != sizeof(Label)
+      || header->feature_size != sizeof(Feature))
+    format_error(file, "label or feature size mismatch");
+  if (header->file_size != (uint64_t) file_size_)
+    format_error(file, "file size mismatch");
+
+  size_t n_instances = header->num_instances;
+  size_t n_features = header->num_features;
+  size_t n_queries = header->num_queries;
+  size_t matrix_bytes = n_instances * n_features * sizeof(Feature);
+
+  auto check_section = [&](uint64_t offset, size_t bytes,
+                           const std::string &name) {
+    if (offset % SECTION_ALIGNMENT != 0 || offset < sizeof(BinaryHeader)
+        || offset + bytes > (uint64_t) file_size_)
+      format_error(file, "corrupted " + name + " section");
+  };
+  check_section(header->labels_offset, n_instances * sizeof(Label), "labels");
+  check_section(header->offsets_offset, (n_queries + 1) * sizeof(uint64_t),
+                "offsets");
+  check_section(header->horizontal_offset, matrix_bytes, "horizontal");
+  has_vertical_ = header->vertical_offset != 0;
+  if (has_vertical_)
+    check_section(header->vertical_offset, matrix_bytes, "vertical");
+
+  const uint64_t *q_offsets = (const uint64_t *)
+      (base + header->offsets_offset);
+  std::vector<size_t> offsets(q_offsets, q_offsets + n_queries + 1);
+  // offsets must grow from 0 to the number of instances, so that every
+  // query results list lies within the data
+  if (offsets.front() != 0 || offsets.back() != n_instances
+      || !std::is_sorted(offsets.begin(), offsets.end()))
+    format_error(file, "corrupted offsets section");
+
+  data::Dataset *dataset = new data::Dataset(
+      n_instances, n_features,
+      (Feature *) (base + header->horizontal_offset),
+      (Label *) (base + header->labels_offset),
+      std::move(offsets),
+      storage,
+      has_vertical_ ? (Feature *) (base + header->vertical_offset) : NULL);
+
+  auto end_reading = std::chrono::high_resolution_clock::now();
+  reading_time_ = std::chrono::duration_cast<std::chrono::duration<double>>(
+      end_reading - start_reading).count();
+
+  return std::unique_ptr<data::Dataset>(dataset);
+}
+
+void Binary::write(std::shared_ptr<data::Dataset> dataset,
+                   const std::string &file,
+                   bool with_vertical) {
+
+  size_t n_instances = dataset->num_instances();
+  size_t n_features = dataset->num_features();
+  size_t n_queries = dataset->num_queries();
+  size_t matrix_bytes = n_instances * n_features * sizeof(Feature);
+
+  BinaryHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.label_size = sizeof(Label);
+  header.feature_size = sizeof(Feature);
+  header.num_instances = n_instances;
+  header.num_features = n_features;
+  header.num_queries = n_queries;
+  header.labels_offset = align_section(sizeof(header));
+  header.offsets_offset = header.labels_offset
+      + align_section(n_instances * sizeof(Label));
+  header.horizontal_offset = header.offsets_offset
+      + align_section((n_queries + 1) * sizeof(uint64_t));
+  header.file_size = header.horizontal_offset + align_section(matrix_bytes);
+  if (with_vertical) {
+    header.vertical_offset = header.file_size;
+    header.file_size += align_section(matrix_bytes);
+  }
+
+  std::ofstream out(file, std::ofstream::out | std::ofstream::trunc
+      | std::ofstream::binary);
+  if (!out) {
+    std::cerr << "!!! Impossible to open output file " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  write_section(out, &header, sizeof(header));
+
+  std::vector<Label> labels(n_instances);
+  for (size_t i = 0; i < n_instances; ++i)
+    labels[i] = dataset->getLabel(i);
+  write_section(out, labels.data(), n_instances * sizeof(Label));
+
+  std::vector<uint64_t> offsets(n_queries + 1);
+  for (size_t q = 0; q <= n_queries; ++q)
+    offsets[q] = dataset->offset(q);
+  write_section(out, offsets.data(), offsets.size() * sizeof(uint64_t));
+
+  write_section(out, dataset->at(0, 0), matrix_bytes);
+
+  if (with_vertical) {
+    // transpose one feature at a time
+    std::vector<Feature> column(n_instances);
+    const Feature *h_data = dataset->at(0, 0);
+    for (size_t f = 0; f < n_features; ++f) {
+      for (size_t i = 0; i < n_instances; ++i)
+        column[i] = h_data[i * n_features + f];
+      out.write((const char *) column.data(), n_instances * sizeof(Feature));
+    }
+    write_padding(out, matrix_bytes);
+  }
+
+  out.close();
+  if (!out) {
+    std::cerr << "!!! Error while writing output file " << file << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+std::ostream &Binary::put(std::ostream &os) const {
+  os << std::setprecision(2) << "#\t Mapping time: " << reading_time_
+     << " s. (" << file_size_ / 1024 / 1024 << " MB, "
+     << (has_vertical_ ? "horizontal and vertical" : "horizontal")
+     << " layout)" << std::endl;
+  return os;
+}
+
+}  // namespace io
+}  // namespace quickrank
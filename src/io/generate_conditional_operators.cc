@@ -25,8 +25,10 @@
 namespace quickrank {
 namespace io {
 
-void model_node_to_conditional_operators(pugi::xml_node &nodes,
-                                         std::stringstream &os) {
+/// Prints the conditional operators of the subtree of \a nodes, and returns
+/// the number of its internal nodes.
+unsigned int model_node_to_conditional_operators(pugi::xml_node &nodes,
+                                                 std::stringstream &os) {
   unsigned int feature_id = 0;
   std::string threshold;
   std::string prediction;
@@ -61,18 +63,19 @@ void model_node_to_conditional_operators(pugi::xml_node &nodes,
     }
   }
 
-  if (is_leaf)
+  if (is_leaf) {
     os << prediction;
-  else {
-    /// \todo TODO: this should be changed with item mapping
-    os << "( v[" << feature_id - 1 << "] <= ";
-    os << threshold << "f";
-    os << " ? ";
-    model_node_to_conditional_operators(left, os);
-    os << " : ";
-    model_node_to_conditional_operators(right, os);
-    os << " )";
+    return 0;
   }
+  /// \todo TODO: this should be changed with item mapping
+  os << "( v[" << feature_id - 1 << "] <= ";
+  os << threshold << "f";
+  os << " ? ";
+  unsigned int nodes_count = 1 + model_node_to_conditional_operators(left, os);
+  os << " : ";
+  nodes_count += model_node_to_conditional_operators(right, os);
+  os << " )";
+  return nodes_count;
 }
 
 void
@@ -92,21 +95,59 @@ GenOpCond::generate_conditional_operators_code(const std::string model_filename,
   source_code.setf(std::ios::floatfield, std::ios::fixed);
 
   // printing header
-  source_code << "double ranker(float* v) {" << std::endl;
-  source_code << "\treturn 0.0 ";
+  source_code << "#include <cstddef>" << std::endl << std::endl;
 
   // let's navigate the ensemble, for each tree...
+  // trees are accumulated into score by functions of bounded size
+  unsigned int functions = 0;
+  unsigned int function_nodes = 0;
   pugi::xml_node ensemble = xml_document.child("ranker").child("ensemble");
   for (pugi::xml_node &tree : ensemble.children("tree")) {
     float tree_weight = tree.attribute("weight").as_float();
     pugi::xml_node tree_content = tree.child("split");
     if (tree_content) {
-      source_code << std::endl << "\t\t + " << std::setprecision(3)
+      if (functions == 0 || function_nodes >= MAX_FUNCTION_NODES) {
+        if (functions != 0)
+          source_code << "\treturn score;" << std::endl << "}" << std::endl
+                      << std::endl;
+        source_code << "static double trees_" << functions
+                    << "(const float* v, double score) {" << std::endl;
+        functions++;
+        function_nodes = 0;
+      }
+      source_code << "\tscore += " << std::setprecision(3)
                   << tree_weight << "f * ";
-      model_node_to_conditional_operators(tree_content, source_code);
+      function_nodes +=
+          model_node_to_conditional_operators(tree_content, source_code);
+      source_code << ";" << std::endl;
     }
   }
-  source_code << ";" << std::endl << "}" << std::endl;
+  if (functions != 0)
+    source_code << "\treturn score;" << std::endl << "}" << std::endl
+                << std::endl;
+
+  source_code << "double ranker(float* v) {" << std::endl;
+  source_code << "\tdouble score = 0.0;" << std::endl;
+  for (unsigned int f = 0; f < functions; f++)
+    source_code << "\tscore = trees_" << f << "(v, score);" << std::endl;
+  source_code << "\treturn score;" << std::endl << "}" << std::endl
+              << std::endl;
+
+  // blocks of documents go through a function of trees at a time, so that
+  // its code stays in cache
+  source_code << "void ranker_batch(const float* docs, size_t n, "
+              << "size_t stride, double* out) {" << std::endl;
+  source_code << "\tfor (size_t b = 0; b < n; b += " << BATCH_SIZE << ") {"
+              << std::endl;
+  source_code << "\t\tconst size_t e = b + " << BATCH_SIZE << " < n ? b + "
+              << BATCH_SIZE << " : n;" << std::endl;
+  source_code << "\t\tfor (size_t i = b; i < e; ++i)" << std::endl
+              << "\t\t\tout[i] = 0.0;" << std::endl;
+  for (unsigned int f = 0; f < functions; f++)
+    source_code << "\t\tfor (size_t i = b; i < e; ++i)" << std::endl
+                << "\t\t\tout[i] = trees_" << f
+                << "(docs + i * stride, out[i]);" << std::endl;
+  source_code << "\t}" << std::endl << "}" << std::endl;
 
   std::ofstream output;
   output.open(code_filename, std::ofstream::out);
@@ -233,6 +233,8 @@ void GenOblivious::generate_oblivious_code(const std::string model_filename,
   depths_population.push_back(tree_mapping.size() - start_position);
 
   // start printing code to output stream...
+  source_code << "#include <cstddef>" << std::endl << std::endl;
+
   // printing ensemble info
   source_code << "#define N " << actual_model_size << " // no. of trees"
               << std::endl;
@@ -321,7 +323,82 @@ void GenOblivious::generate_oblivious_code(const std::string model_filename,
     source_code << "    i++;" << std::endl;
     source_code << "  }" << std::endl;
   }
-  source_code << "  return score;" << std::endl << "}" << std::endl;
+  source_code << "  return score;" << std::endl << "}" << std::endl
+              << std::endl;
+
+  // the batched ranker computes the leaves of LANES documents at once,
+  // with a gather and a comparison per level when SIMD is available
+  source_code << R"(#if defined(__AVX512F__)
+#include <immintrin.h>
+#define LANES 16
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define LANES 8
+#else
+#define LANES 8
+#endif
+
+void leaf_ids(const float *v, size_t stride, unsigned int const *fids, float const *thresh, const unsigned int m, unsigned int *leafidx) {
+#if defined(__AVX512F__)
+  const __m512i offsets = _mm512_mullo_epi32(
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+      _mm512_set1_epi32((int) stride));
+  __m512i idx = _mm512_setzero_si512();
+  for (unsigned int i=0; i<m; ++i) {
+    const __m512 x = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, offsets, v + fids[i], 4);
+    const __mmask16 gt = _mm512_cmp_ps_mask(x, _mm512_set1_ps(thresh[i]), _CMP_GT_OQ);
+    idx = _mm512_add_epi32(idx, idx);
+    idx = _mm512_mask_add_epi32(idx, gt, idx, _mm512_set1_epi32(1));
+  }
+  _mm512_storeu_si512(leafidx, idx);
+#elif defined(__AVX2__)
+  const __m256i offsets = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+      _mm256_set1_epi32((int) stride));
+  __m256i idx = _mm256_setzero_si256();
+  for (unsigned int i=0; i<m; ++i) {
+    const __m256 x = _mm256_i32gather_ps(v + fids[i], offsets, 4);
+    const __m256i gt = _mm256_castps_si256(_mm256_cmp_ps(x, _mm256_set1_ps(thresh[i]), _CMP_GT_OQ));
+    idx = _mm256_sub_epi32(_mm256_slli_epi32(idx, 1), gt);
+  }
+  _mm256_storeu_si256((__m256i *) leafidx, idx);
+#else
+  for (unsigned int k=0; k<LANES; ++k)
+    leafidx[k] = 0;
+  for (unsigned int i=0; i<m; ++i)
+    for (unsigned int k=0; k<LANES; ++k)
+      leafidx[k] = SHL(leafidx[k], 1) | (v[k*stride+fids[i]]>thresh[i]);
+#endif
+}
+
+void ranker_batch(const float *docs, size_t n, size_t stride, double *out) {
+  size_t d = 0;
+  for (; d + LANES <= n; d += LANES) {
+    const float *v = docs + d*stride;
+    double score[LANES];
+    unsigned int leafidx[LANES];
+    for (unsigned int k=0; k<LANES; ++k)
+      score[k] = 0.0;
+    int i = 0;
+)";
+  for (int d = 0; d < max_depth; d++) {
+    source_code << "    for (int j = 0; j < " << depths_population[d]
+                << "; ++j) {" << std::endl;
+    source_code
+        << "      leaf_ids(v, stride, features_ids[i], thresholds[i], "
+        << d + 1 << ", leafidx);" << std::endl;
+    source_code << "      for (unsigned int k=0; k<LANES; ++k)" << std::endl
+                << "        score[k] += tree_weights[i] * leaf_outputs[i][leafidx[k]];"
+                << std::endl;
+    source_code << "      i++;" << std::endl;
+    source_code << "    }" << std::endl;
+  }
+  source_code << "    for (unsigned int k=0; k<LANES; ++k)" << std::endl
+              << "      out[d+k] = score[k];" << std::endl
+              << "  }" << std::endl
+              << "  for (; d < n; ++d)" << std::endl
+              << "    out[d] = ranker((float *) (docs + d*stride));" << std::endl
+              << "}" << std::endl;
 
   std::ofstream output;
   output.open(code_filename, std::ofstream::out);
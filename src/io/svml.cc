@@ -19,134 +19,328 @@
  * Contributor:
  *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
  */
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <chrono>
 #include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
-#include <list>
 
 #include "io/svml.h"
 #include "utils/strutils.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
 
 namespace quickrank {
 namespace io {
 
-// TODO: save info file or use mmap
-// TODO: re-introduce multithreading
-std::unique_ptr<data::Dataset> Svml::read_horizontal(
-    const std::string &filename) {
+namespace {
+
+// minimum number of bytes assigned to a single parsing thread
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+// powers of ten exactly representable as float
+const float POW10[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                       1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+inline bool is_digit(const char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline bool is_delimiter(const char *p, const char *end) {
+  return p == end || ISSPC(*p) || *p == ':' || *p == '#';
+}
+
+void parse_error(const char *p, const char *end, const std::string &what) {
+  const char *eol = (const char *) memchr(p, '\n', end - p);
+  std::cerr << "!!! Error while parsing " << what << " in SVML line: "
+            << std::string(p, eol ? eol : end) << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+/// Parses an unsigned integer and returns a pointer to the first
+/// character following it, or NULL if no digit is found.
+inline const char *parse_uint(const char *p, const char *end, size_t &value) {
+  if (p == end || !is_digit(*p))
+    return NULL;
+  value = 0;
+  while (p != end && is_digit(*p))
+    value = value * 10 + (*p++ - '0');
+  return p;
+}
+
+/// Parses a float value and returns a pointer to the first character
+/// following it, or NULL if the token is not a valid number.
+///
+/// Values with at most 7 significant digits and a decimal exponent in
+/// [-10,10] are computed with a single correctly rounded float operation;
+/// anything else falls back to strtof, so that results are exactly those of
+/// the previous sscanf based reader.
+inline const char *parse_float(const char *p, const char *end, float &value) {
+  const char *start = p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+
+  uint32_t mantissa = 0;
+  int exponent = 0;
+  int digits = 0;
+  bool fast = true;
+  for (; p != end && is_digit(*p); ++p, ++digits) {
+    if (mantissa < 1000000)
+      mantissa = mantissa * 10 + (*p - '0');
+    else
+      fast = false;
+  }
+  if (p != end && *p == '.') {
+    for (++p; p != end && is_digit(*p); ++p, ++digits) {
+      if (mantissa < 1000000) {
+        mantissa = mantissa * 10 + (*p - '0');
+        --exponent;
+      } else if (*p != '0')
+        fast = false;
+    }
+  }
+  if (digits == 0)
+    fast = false;
+  if (fast && p != end && (*p == 'e' || *p == 'E')) {
+    size_t e = 0;
+    bool e_negative = false;
+    const char *q = p + 1;
+    if (q != end && (*q == '-' || *q == '+'))
+      e_negative = *q++ == '-';
+    if ((p = parse_uint(q, end, e)) == NULL || e > 20)
+      fast = false;
+    else
+      exponent += e_negative ? -(int) e : (int) e;
+  }
 
-  FILE *f = fopen(filename.c_str(), "r");
-  if (!f) {
-    std::cerr << "!!! Error while opening file " << filename << "."
-              << std::endl;
-    exit(EXIT_FAILURE);
+  if (fast && is_delimiter(p, end) && exponent >= -10 && exponent <= 10) {
+    value = exponent < 0 ? (float) mantissa / POW10[-exponent]
+                         : (float) mantissa * POW10[exponent];
+    if (negative)
+      value = -value;
+    return p;
   }
 
-  struct stat filestatus;
-  stat(filename.c_str(), &filestatus);
-  file_size_ = filestatus.st_size;
+  // slow path: let the C library handle any other representation
+  char buffer[128];
+  size_t len = 0;
+  for (p = start; !is_delimiter(p, end) && len < sizeof(buffer) - 1; ++p)
+    buffer[len++] = *p;
+  buffer[len] = '\0';
+  char *buffer_end = NULL;
+  value = strtof(buffer, &buffer_end);
+  if (len == 0 || buffer_end != buffer + len)
+    return NULL;
+  return p;
+}
 
-  std::chrono::high_resolution_clock::time_point start_reading =
-      std::chrono::high_resolution_clock::now();
+inline const char *skip_spaces(const char *p, const char *end) {
+  while (p != end && *p != '\n' && ISSPC(*p))
+    ++p;
+  return p;
+}
+
+inline const char *skip_line(const char *p, const char *end) {
+  const char *eol = (const char *) memchr(p, '\n', end - p);
+  return eol ? eol + 1 : end;
+}
 
+/// Scans the feature values of a line without parsing them, to find the
+/// number of features.
+struct ScanSink {
   size_t maxfid = 0;
 
-  // temporary copy of data
-  std::list<size_t> data_qids;
-  std::list<quickrank::Label> data_labels;
-  std::list<std::vector<quickrank::Feature>> data_instances;
-
-  while (not feof(f)) {
-    //#pragma omp parallel for ordered reduction(max:maxfid) num_threads(4) schedule(static,1)
-    //  for (int file_i=0; file_i<file_size_; file_i++) {
-    //    if(feof(f)) {file_i = file_size_; continue; }
-    ssize_t nread;
-    size_t linelength = 0;
-    char *line = NULL;
-    //lines are read one-at-a-time by threads
-    //#pragma omp ordered
-    {
-      nread = getline(&line, &linelength, f);
+  const char *operator()(size_t fid, const char *p, const char *end) {
+    if (fid > maxfid)
+      maxfid = fid;
+    while (p != end && !ISSPC(*p))
+      ++p;
+    return p;
+  }
+};
+
+/// Parses the feature values of a line into a dense row.
+struct DenseSink {
+  Feature *features;
+
+  const char *operator()(size_t fid, const char *p, const char *end) {
+    return parse_float(p, end, features[fid - 1]);
+  }
+};
+
+/// Parses a single SVML line starting at \a p, passing every feature
+/// to \a sink which returns a pointer to the end of the feature value.
+/// \return A pointer to the beginning of the next line.
+template<typename Sink>
+const char *parse_line(const char *p, const char *end, bool &is_instance,
+                       Label &label, QueryID &qid, Sink &sink) {
+  const char *line = p;
+  p = skip_spaces(p, end);
+  is_instance = p != end && *p != '\n' && *p != '#';
+  if (!is_instance)
+    return skip_line(p, end);
+
+  // read label and qid
+  float relevance;
+  if ((p = parse_float(p, end, relevance)) == NULL)
+    parse_error(line, end, "label");
+  label = relevance;
+
+  p = skip_spaces(p, end);
+  size_t query_id = 0;
+  if (end - p < 4 || strncmp(p, "qid:", 4) != 0
+      || (p = parse_uint(p + 4, end, query_id)) == NULL)
+    parse_error(line, end, "qid");
+  qid = (QueryID) query_id;
+
+  // read a sequence of (fid,fval) pairs, then the ending description
+  for (p = skip_spaces(p, end); p != end && *p != '\n' && *p != '#';
+       p = skip_spaces(p, end)) {
+    size_t fid = 0;
+    if ((p = parse_uint(p, end, fid)) == NULL || fid == 0 || p == end
+        || *p != ':')
+      parse_error(line, end, "feature id");
+    if ((p = sink(fid, p + 1, end)) == NULL)
+      parse_error(line, end, "feature value");
+  }
+
+  return skip_line(p, end);
+}
+
+/// Memory maps a file and splits it into line-aligned chunks, one per
+/// thread, each one of at least \a MIN_CHUNK_SIZE bytes.
+class MappedFile {
+ public:
+  MappedFile(const std::string &filename) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+      std::cerr << "!!! Error while opening file " << filename << "."
+                << std::endl;
+      exit(EXIT_FAILURE);
     }
-    //if something is wrong with getline() or line is empty, skip to the next
-    if (nread <= 0) {
-      free(line);
-      continue;
+
+    struct stat filestatus;
+    fstat(fd, &filestatus);
+    size = filestatus.st_size;
+
+    if (size > 0) {
+      void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) {
+        std::cerr << "!!! Error while mapping file " << filename << "."
+                  << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      madvise(map, size, MADV_SEQUENTIAL | MADV_WILLNEED);
+      begin = (const char *) map;
     }
-    char *token = NULL, *pch = line;
-    //skip initial spaces
-    while (ISSPC(*pch) && *pch != '\0')
-      ++pch;
-    //skip comment line
-    if (*pch == '#') {
-      free(line);
-      continue;
+    close(fd);
+    end = begin + size;
+
+    size_t nchunks = std::max(1, omp_get_max_threads());
+    nchunks = std::max((size_t) 1, std::min(nchunks, size / MIN_CHUNK_SIZE));
+    chunks.assign(nchunks + 1, end);
+    chunks[0] = begin;
+    for (size_t c = 1; c < nchunks; ++c) {
+      const char *p = std::max(chunks[c - 1], begin + c * size / nchunks);
+      chunks[c] = p == begin ? begin : skip_line(p - 1, end);
     }
+  }
 
-    //read label (label is a mandatory field)
-    if (ISEMPTY(token = read_token(pch)))
-      exit(2);
-
-    // read label and qid
-    quickrank::Label relevance = atof(token);
-    size_t qid = atou(read_token(pch), "qid:");
-
-    // allocate feature vector and read instance
-    std::vector<quickrank::Feature> curr_instance(maxfid);
-
-    //read a sequence of features, namely (fid,fval) pairs, then the ending description
-    while (!ISEMPTY(token = read_token(pch, '#'))) {
-      if (*token == '#') {
-//#ifndef SKIP_DPDESCRIPTION
-//        datapoint->set_description(strdup(++token));
-//#endif
-        *pch = '\0';
-      } else {
-        //read a feature (id,val) from token
-        size_t fid = 0;
-        float fval = 0.0f;
-        if (sscanf(token, "%zu:%f", &fid, &fval) != 2)
-          exit(4);
-        //add feature to the current dp
-        if (fid > maxfid) {
-          maxfid = fid;
-          curr_instance.resize(maxfid);
-        }
-        curr_instance[fid - 1] = fval;
-      }
+  ~MappedFile() {
+    if (begin)
+      munmap((void *) begin, size);
+  }
+
+  size_t num_chunks() const {
+    return chunks.size() - 1;
+  }
+
+  size_t size = 0;
+  const char *begin = NULL;
+  const char *end = NULL;
+  std::vector<const char *> chunks;
+};
+
+}  // namespace
+
+std::unique_ptr<data::Dataset> Svml::read_horizontal(
+    const std::string &filename) {
+
+  std::chrono::high_resolution_clock::time_point start_reading =
+      std::chrono::high_resolution_clock::now();
+
+  MappedFile file(filename);
+  file_size_ = file.size;
+  const size_t nchunks = file.num_chunks();
+
+  chunk_bytes_.assign(nchunks, 0);
+  chunk_time_.assign(nchunks, 0.0);
+
+  // first pass: count instances and find the number of features
+  std::vector<size_t> chunk_instances(nchunks, 0);
+  size_t maxfid = 0;
+  #pragma omp parallel for schedule(static, 1) reduction(max:maxfid)
+  for (size_t c = 0; c < nchunks; ++c) {
+    auto start = std::chrono::high_resolution_clock::now();
+    bool is_instance;
+    Label label;
+    QueryID qid;
+    ScanSink scan;
+    for (const char *p = file.chunks[c]; p < file.chunks[c + 1];) {
+      p = parse_line(p, file.end, is_instance, label, qid, scan);
+      chunk_instances[c] += is_instance;
     }
+    maxfid = std::max(maxfid, scan.maxfid);
+    chunk_time_[c] = std::chrono::duration_cast<std::chrono::duration<double>>(
+        std::chrono::high_resolution_clock::now() - start).count();
+  }
+
+  // first instance of each chunk in the final dataset
+  std::vector<size_t> chunk_offsets(nchunks + 1, 0);
+  for (size_t c = 0; c < nchunks; ++c)
+    chunk_offsets[c + 1] = chunk_offsets[c] + chunk_instances[c];
+  const size_t ninstances = chunk_offsets[nchunks];
+
+  data::Dataset *dataset = new data::Dataset(ninstances, maxfid);
+  std::vector<QueryID> qids(ninstances);
 
-    // store partial data
-    //#pragma omp ordered
-    {
-      data_qids.push_back(qid);
-      data_labels.push_back(relevance);
-      data_instances.push_back(std::move(curr_instance));  // move should avoid
-      // copies
+  // second pass: parse every chunk straight into the dataset
+  #pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nchunks; ++c) {
+    auto start = std::chrono::high_resolution_clock::now();
+    bool is_instance;
+    Label label;
+    QueryID qid;
+    size_t i = chunk_offsets[c];
+    for (const char *p = file.chunks[c]; p < file.chunks[c + 1];) {
+      DenseSink row = {dataset->at(i, 0)};
+      p = parse_line(p, file.end, is_instance, label, qid, row);
+      if (is_instance) {
+        qids[i] = qid;
+        dataset->setLabel(i++, label);
+      }
     }
-    //free mem
-    free(line);
+    chunk_time_[c] += std::chrono::duration_cast<std::chrono::duration<double>>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    chunk_bytes_[c] = file.chunks[c + 1] - file.chunks[c];
   }
-  //close input file
-  fclose(f);
 
   std::chrono::high_resolution_clock::time_point start_processing =
       std::chrono::high_resolution_clock::now();
 
-  // put partial data in final data structure
-  data::Dataset *dataset = new data::Dataset(data_qids.size(), maxfid);
-  auto i_q = data_qids.begin();
-  auto i_l = data_labels.begin();
-  auto i_x = data_instances.begin();
-  while (i_q != data_qids.end()) {
-    dataset->addInstance(*i_q, *i_l, std::move(*i_x));
-    i_q++;
-    i_l++;
-    i_x++;
-  }
+  // rebuild query offsets
+  dataset->setQueryIds(qids.data(), ninstances);
 
   std::chrono::high_resolution_clock::time_point end_processing =
       std::chrono::high_resolution_clock::now();
@@ -188,10 +382,15 @@ void Svml::write(std::shared_ptr<data::Dataset> dataset,
 }
 
 std::ostream &Svml::put(std::ostream &os) const {
-  // num threads is not reported here.
   os << std::setprecision(2) << "#\t Reading time: " << reading_time_
      << " s. @ " << file_size_ / 1024 / 1024 / reading_time_ << " MB/s "
      << " (post-proc.: " << processing_time_ << " s.)" << std::endl;
+  if (chunk_bytes_.size() > 1) {
+    os << "#\t Reading threads: " << chunk_bytes_.size() << " @";
+    for (size_t c = 0; c < chunk_bytes_.size(); ++c)
+      os << " " << chunk_bytes_[c] / 1024.0 / 1024.0 / chunk_time_[c];
+    os << " MB/s" << std::endl;
+  }
   return os;
 }
 
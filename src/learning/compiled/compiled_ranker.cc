@@ -0,0 +1,255 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/compiled/compiled_ranker.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "io/generate_conditional_operators.h"
+#include "io/generate_oblivious.h"
+#include "utils/fileutils.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
+
+namespace quickrank {
+namespace learning {
+
+namespace {
+
+/// FNV-1a hash of \a text, which unlike std::hash is the same across
+/// builds, as needed by a persistent cache.
+uint64_t fnv1a(const std::string &text) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c: text) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::string getenv_or(const char *name, const std::string &value) {
+  const char *env = getenv(name);
+  return env && *env ? std::string(env) : value;
+}
+
+/// Returns the default cache directory, i.e., the one in
+/// QUICKRANK_JIT_CACHE, or quickrank-jit in the user cache directory.
+std::string default_cache_dir() {
+  const std::string dir = getenv_or("QUICKRANK_JIT_CACHE", "");
+  if (!dir.empty())
+    return dir;
+  std::string base = getenv_or("XDG_CACHE_HOME", "");
+  if (base.empty()) {
+    const std::string home = getenv_or("HOME", "");
+    if (home.empty()) {
+      std::cerr << "!!! Cannot find a cache directory for compiled rankers, "
+                << "set QUICKRANK_JIT_CACHE." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    base = home + "/.cache";
+  }
+  // only the cache itself is checked by check_cache_dir
+  mkdir(base.c_str(), 0700);
+  return base + "/quickrank-jit";
+}
+
+/// Creates the cache directory \a dir if needed. Since the libraries found
+/// there are loaded and run, the directory must belong to the current user
+/// and must not be writable by anybody else.
+void check_cache_dir(const std::string &dir) {
+  if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) {
+    std::cerr << "!!! Cannot create cache directory " << dir << "."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  struct stat status;
+  if (lstat(dir.c_str(), &status) != 0 || !S_ISDIR(status.st_mode)
+      || status.st_uid != geteuid()
+      || (status.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+    std::cerr << "!!! Cache directory " << dir << " must be a directory "
+              << "owned by the current user and not writable by others."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+}  // namespace
+
+const std::string CompiledRanker::NAME_ = "COMPILED";
+
+CompiledRanker::CompiledRanker(const std::string &model_filename,
+                               const std::string &generator,
+                               const std::string &cache_dir)
+    : generator_(generator) {
+  if (generator != "condop" && generator != "oblivious") {
+    std::cerr << "!!! Code generator " << generator
+              << " cannot be compiled." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::ifstream input(model_filename, std::ifstream::binary);
+  std::stringstream xml;
+  xml << input.rdbuf();
+  if (!input || !model_.load_string(xml.str().c_str())) {
+    std::cerr << "!!! Cannot load model " << model_filename << "."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  const std::string compiler =
+      getenv_or("QUICKRANK_JIT_CXX", getenv_or("CXX", "c++"));
+  // hidden symbols keep the generated ranker from being interposed by the
+  // ranker built into quickscore
+  const std::string flags =
+      "-O3 -march=native -shared -fPIC -fvisibility=hidden";
+  const std::string dir = cache_dir.empty() ? default_cache_dir() : cache_dir;
+  check_cache_dir(dir);
+  // the generated rankers have C++ linkage, thus unmangled entry points
+  std::stringstream entry_points;
+  entry_points << "extern \"C\" __attribute__((visibility(\"default\")))"
+               << std::endl
+               << "double quickrank_ranker(float *v) {" << std::endl
+               << "  return ranker(v);" << std::endl
+               << "}" << std::endl << std::endl
+               << "extern \"C\" __attribute__((visibility(\"default\")))"
+               << std::endl
+               << "void quickrank_ranker_batch(const float *docs, size_t n, "
+               << "size_t stride, double *out) {" << std::endl
+               << "  ranker_batch(docs, n, stride, out);" << std::endl
+               << "}" << std::endl;
+
+  // the code is generated every time, since it is the cache key, in files
+  // private to the process until renamed, so that concurrent processes can
+  // compile the same model
+  const std::string tmp = dir + "/" + generator + "."
+      + std::to_string(getpid());
+  if (generator == "condop")
+    io::GenOpCond().generate_conditional_operators_code(model_filename,
+                                                        tmp + ".cc");
+  else
+    io::GenOblivious().generate_oblivious_code(model_filename, tmp + ".cc");
+  std::ofstream source(tmp + ".cc", std::ofstream::app);
+  source << std::endl << entry_points.str();
+  source.close();
+  std::ifstream generated(tmp + ".cc", std::ifstream::binary);
+  std::stringstream code;
+  code << generated.rdbuf();
+  if (!source || !generated) {
+    std::cerr << "!!! Cannot generate the ranker in " << dir << "."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::stringstream key;
+  key << std::hex << std::setw(16) << std::setfill('0')
+      << fnv1a(compiler + " " + flags + "\n" + code.str());
+  const std::string basename = dir + "/" + generator + "-" + key.str();
+  library_ = basename + ".so";
+
+  if (file_exist(library_)) {
+    std::remove((tmp + ".cc").c_str());
+  } else {
+    const std::string command = compiler + " " + flags + " -o \"" + tmp
+        + ".so\" \"" + tmp + ".cc\"";
+    if (std::system(command.c_str()) != 0) {
+      std::cerr << "!!! Cannot compile the ranker with: " << command
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    if (std::rename((tmp + ".so").c_str(), library_.c_str()) != 0
+        || std::rename((tmp + ".cc").c_str(), (basename + ".cc").c_str())
+            != 0) {
+      std::cerr << "!!! Cannot store the ranker in " << dir << "."
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    compiled_ = true;
+  }
+
+  handle_ = dlopen(library_.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle_) {
+    ranker_ = (Ranker) dlsym(handle_, "quickrank_ranker");
+    ranker_batch_ = (BatchRanker) dlsym(handle_, "quickrank_ranker_batch");
+  }
+  if (!ranker_ || !ranker_batch_) {
+    std::cerr << "!!! Cannot load the ranker: " << dlerror() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+CompiledRanker::~CompiledRanker() {
+  if (handle_)
+    dlclose(handle_);
+}
+
+std::ostream &CompiledRanker::put(std::ostream &os) const {
+  os << "# Ranker: " << name() << std::endl
+     << "# generator = " << generator_ << std::endl
+     << "# library = " << library_ << std::endl;
+  return os;
+}
+
+void CompiledRanker::score_dataset(std::shared_ptr<data::Dataset> dataset,
+                                   Score *scores) const {
+  const Feature *d = dataset->at(0, 0);
+  const size_t ninstances = dataset->num_instances();
+  const size_t nfeatures = dataset->num_features();
+  #pragma omp parallel
+  {
+    const size_t nthreads = omp_get_num_threads();
+    const size_t ithread = omp_get_thread_num();
+    const size_t begin = ninstances * ithread / nthreads;
+    const size_t end = ninstances * (ithread + 1) / nthreads;
+    ranker_batch_(d + begin * nfeatures, end - begin, nfeatures,
+                  scores + begin);
+  }
+}
+
+void CompiledRanker::learn(
+    std::shared_ptr<quickrank::data::Dataset> training_dataset,
+    std::shared_ptr<quickrank::data::Dataset> validation_dataset,
+    std::shared_ptr<quickrank::metric::ir::Metric> scorer,
+    size_t partial_save, const std::string output_basename) {
+  std::cerr << "!!! A compiled ranker cannot be trained." << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+pugi::xml_document *CompiledRanker::get_xml_model() const {
+  pugi::xml_document *doc = new pugi::xml_document();
+  for (pugi::xml_node node: model_.children())
+    doc->append_copy(node);
+  return doc;
+}
+
+}  // namespace learning
+}  // namespace quickrank
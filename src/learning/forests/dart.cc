@@ -644,7 +644,8 @@ void Dart::update_modelscores(std::shared_ptr<data::Dataset> dataset,
     #pragma omp parallel for
     for (size_t i = 0; i < dataset->num_instances(); ++i) {
       scores[i] += sign * ensemble_model_.getWeight(t) *
-          ensemble_model_.getTree(t)->score_instance(d + i * num_features, offset);
+          ensemble_model_.getFlatTree(t)->score_instance(d + i * num_features,
+                                                         offset);
     }
   }
 }
@@ -681,7 +682,7 @@ void Dart::update_modelscores(std::shared_ptr<data::VerticalDataset> dataset,
     #pragma omp parallel for
     for (size_t i = 0; i < dataset->num_instances(); ++i) {
       scores[i] += sign * ensemble_model_.getWeight(t) *
-          ensemble_model_.getTree(t)->score_instance(d + i, offset);
+          ensemble_model_.getFlatTree(t)->score_instance(d + i, offset);
     }
   }
 }
@@ -696,10 +697,10 @@ void Dart::update_contribution_scores(std::shared_ptr<data::Dataset> dataset,
   const size_t num_instances = dataset->num_instances();
 
   double contribution = 0;
-  RTNode* root = tree->get_proot();
+  const FlatTree flat(tree->get_proot());
   #pragma omp parallel for reduction(+:contribution)
   for (size_t i = 0; i < dataset->num_instances(); ++i) {
-    contribution += fabs(root->score_instance(d + i * num_features, offset));
+    contribution += fabs(flat.score_instance(d + i * num_features, offset));
   }
 
   scores_contribution_[new_index] = contribution / num_instances;
@@ -998,10 +999,11 @@ double Dart::get_weight_last_tree(std::shared_ptr<data::Dataset> dataset,
     }
 
     std::vector<Score> score_instance_last_tree(num_instances);
+    const FlatTree flat(tree->get_proot());
     #pragma omp parallel for
     for (size_t i = 0; i < dataset->num_instances(); ++i) {
-      score_instance_last_tree[i] += tree->get_proot()
-          ->score_instance(d + i * num_features, offset);
+      score_instance_last_tree[i] += flat.score_instance(d + i * num_features,
+                                                         offset);
     }
 
 
@@ -21,13 +21,36 @@
  */
 #include "learning/forests/lambdamart.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iomanip>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
 
 namespace quickrank {
 namespace learning {
 namespace forests {
 
+namespace {
+
+/// Returns the bytes of the scratch arrays of a query of \a n results: the
+/// map from the sampled results, the sampled labels and scores, the ranked
+/// labels, scores and positions, the discounts and the gains.
+size_t query_scratch_bytes(size_t n) {
+  return 2 * ScratchArena::array_bytes<size_t>(n)
+      + 2 * ScratchArena::array_bytes<Label>(n)
+      + 2 * ScratchArena::array_bytes<Score>(n)
+      + 2 * ScratchArena::array_bytes<double>(n);
+}
+
+}  // namespace
+
 const std::string LambdaMart::NAME_ = "LAMBDAMART";
 
 
@@ -36,12 +59,30 @@ LambdaMart::init(std::shared_ptr<quickrank::data::VerticalDataset> training_data
   Mart::init(training_dataset);
   const size_t nentries = training_dataset->num_instances();
   instance_weights_ = new double[nentries]();  //0.0f initialized
+
+  // the scratch arrays of every thread fit the longest query
+  size_t longest = 0;
+  for (size_t q = 0; q < training_dataset->num_queries(); ++q)
+    longest = std::max<size_t>(longest, training_dataset->offset(q + 1)
+        - training_dataset->offset(q));
+  scratch_.resize(omp_get_max_threads());
+  for (auto &arena: scratch_)
+    arena.reserve(query_scratch_bytes(longest));
+
+  // the gains and discounts of every query are looked up in shared tables
+  const Label *labels = training_dataset->query_labels(0);
+  const Label max_label = nentries ? *std::max_element(labels,
+                                                       labels + nentries)
+                                   : 0.0f;
+  dcg_tables_.reset(new metric::ir::DcgTables(max_label, longest));
 }
 
 void LambdaMart::clear(size_t num_features) {
   Mart::clear(num_features);
   if (instance_weights_)
     delete[] instance_weights_;
+  scratch_.clear();
+  dcg_tables_.reset();
 }
 
 std::unique_ptr<RegressionTree> LambdaMart::fit_regressor_on_gradient(
@@ -51,7 +92,9 @@ std::unique_ptr<RegressionTree> LambdaMart::fit_regressor_on_gradient(
   /// \todo TODO: memory management of regression tree is wrong!!!
   RegressionTree *tree = new RegressionTree(nleaves_, training_dataset.get(),
                                             pseudoresponses_, minleafsupport_,
-                                            collapse_leaves_factor_);
+                                            collapse_leaves_factor_,
+                                            growth_policy_, max_depth_,
+                                            thread_best_splits_.get());
   tree->fit(hist_, sampleids, max_features_);
   //update the outputs of the tree (with gamma computed using the Newton-Raphson pruning_method)
   tree->update_output(pseudoresponses_, instance_weights_);
@@ -67,87 +110,90 @@ void LambdaMart::compute_pseudoresponses(
   const size_t cutoff = scorer->cutoff();
 
   const size_t nrankedlists = training_dataset->num_queries();
+  if (scratch_.size() < (size_t) omp_get_max_threads())
+    scratch_.resize(omp_get_max_threads());
   #pragma omp parallel for
   for (size_t i = 0; i < nrankedlists; ++i) {
-    std::shared_ptr<data::QueryResults> qr =
-        training_dataset->getQueryResults(i);
+    // the arrays of the previous query of the thread are released
+    ScratchArena &arena = scratch_[omp_get_thread_num()];
+    arena.reset();
 
     const size_t offset = training_dataset->offset(i);
+    data::QueryResults qr(training_dataset->offset(i + 1) - offset,
+                          training_dataset->query_labels(i), NULL);
     // Reset pseudoresponses and instance_weights before updating...
-    for (size_t j = offset; j < offset + qr->num_results(); ++j)
+    for (size_t j = offset; j < offset + qr.num_results(); ++j)
       pseudoresponses_[j] = instance_weights_[j] = 0.0;
 
-
-    std::shared_ptr<data::RankedResults> ranked;
-    size_t *map_from_cleaned = new size_t[qr->num_results()];
-    Label *labels_cleaned = NULL;
-    Score *training_scores_cleaned = NULL;
+    size_t *map_from_cleaned = arena.allocate<size_t>(qr.num_results());
+    Label *labels_cleaned = qr.labels();
+    Score *training_scores_cleaned = scores_on_training_ + offset;
+    size_t count = qr.num_results();
     if (sample_presence) {
       // Clean the query results with missing samples
-      labels_cleaned = new Label[qr->num_results()];
-      training_scores_cleaned = new Score[qr->num_results()];
-      size_t count = 0;
-      for (size_t d = 0; d < qr->num_results(); ++d) {
+      labels_cleaned = arena.allocate<Label>(qr.num_results());
+      training_scores_cleaned = arena.allocate<Score>(qr.num_results());
+      count = 0;
+      for (size_t d = 0; d < qr.num_results(); ++d) {
         if (sample_presence[offset + d]) {
           map_from_cleaned[count] = d;
-          labels_cleaned[count] = qr->labels()[d];
+          labels_cleaned[count] = qr.labels()[d];
           training_scores_cleaned[count] = scores_on_training_[d];
           ++count;
         }
       }
-
-      auto qr_cleaned = std::shared_ptr<data::QueryResults>(
-          new data::QueryResults(count, labels_cleaned, NULL));
-      ranked = std::shared_ptr<data::RankedResults>(
-          new data::RankedResults(qr_cleaned, training_scores_cleaned));
     } else {
-      for (size_t d = 0; d < qr->num_results(); ++d)
+      for (size_t d = 0; d < qr.num_results(); ++d)
         map_from_cleaned[d] = d;
-      ranked = std::shared_ptr<data::RankedResults>(
-          new data::RankedResults(qr, scores_on_training_ + offset));
     }
-
-    std::unique_ptr<Jacobian> jacobian = scorer->jacobian(ranked);
-
-    // \todo TODO: rank by label once and for all ?
-    // \todo TODO: avoid n^2 loop ?
-    for (size_t j = 0; j < ranked->num_results(); j++) {
-      Label jthlabel = ranked->sorted_labels()[j];
-
-      size_t j_abs = offset + map_from_cleaned[ranked->pos_of_rank(j)];
-
-      for (size_t k = 0; k < ranked->num_results(); k++) {
-
-        size_t k_abs = offset + map_from_cleaned[ranked->pos_of_rank(k)];
-
-        if (k != j) {
-          // skip if we are beyond the top-K results
-          if (j >= cutoff && k >= cutoff)
-            break;
-
-          Label kthlabel = ranked->sorted_labels()[k];
-          if (jthlabel > kthlabel) {
-            double deltandcg = fabs(jacobian->at(j, k));
-
-            double rho = 1.0
-                / (1.0 + exp(scores_on_training_[j_abs]
-                                 - scores_on_training_[k_abs]) );
-            double lambda = rho * deltandcg;
-            double delta = rho * (1.0 - rho) * deltandcg;
-            pseudoresponses_[j_abs] += lambda;
-            pseudoresponses_[k_abs] -= lambda;
-            instance_weights_[j_abs] += delta;
-            instance_weights_[k_abs] += delta;
-          }
+    data::QueryResults qr_cleaned(count, labels_cleaned, NULL);
+    data::RankedResults ranked(qr_cleaned, training_scores_cleaned, arena);
+
+    // the changes of the metric are computed on demand from the tables of
+    // the metric, if any, otherwise they are stored in a Jacobian, which
+    // is also taken from the arena
+    double *discounts = arena.allocate<double>(count);
+    double *gains = arena.allocate<double>(count);
+    double normalization = 1.0;
+    const bool swap_tables = scorer->swap_tables(ranked, *dcg_tables_,
+                                                 discounts, gains,
+                                                 normalization);
+    Jacobian jacobian(swap_tables ? 0 : count, swap_tables ? NULL :
+        arena.allocate<double>(Jacobian::num_elements(count)));
+    if (!swap_tables)
+      scorer->jacobian(ranked, *dcg_tables_, arena, jacobian);
+
+    // only the pairs with a document in the top-cutoff change the metric
+    const size_t nresults = ranked.num_results();
+    const size_t top = std::min(cutoff, nresults);
+    for (size_t j = 0; j < nresults; j++) {
+      Label jthlabel = ranked.sorted_labels()[j];
+
+      size_t j_abs = offset + map_from_cleaned[ranked.pos_of_rank(j)];
+
+      const size_t kend = j < top ? nresults : top;
+      for (size_t k = 0; k < kend; k++) {
+        Label kthlabel = ranked.sorted_labels()[k];
+        if (k != j && jthlabel > kthlabel) {
+          size_t k_abs = offset + map_from_cleaned[ranked.pos_of_rank(k)];
+
+          double deltandcg = fabs(!swap_tables ? jacobian.at(j, k) :
+                                  (discounts[k] - discounts[j])
+                                      * (gains[j] - gains[k])
+                                      / normalization);
+
+          double rho = 1.0
+              / (1.0 + exp(scores_on_training_[j_abs]
+                               - scores_on_training_[k_abs]) );
+          double lambda = rho * deltandcg;
+          double delta = rho * (1.0 - rho) * deltandcg;
+          pseudoresponses_[j_abs] += lambda;
+          pseudoresponses_[k_abs] -= lambda;
+          instance_weights_[j_abs] += delta;
+          instance_weights_[k_abs] += delta;
         }
       }
     }
-
-    if (sample_presence) {
-      delete[] labels_cleaned;
-      delete[] training_scores_cleaned;
-      delete[] map_from_cleaned;
-    }
   }
 }
 
@@ -27,6 +27,11 @@
 #include <random>
 
 #include "utils/radix.h"
+#include "learning/tree/oblivious_scorer.h"
+#include "learning/tree/quantized_ensemble.h"
+#include "learning/tree/quickscorer.h"
+#include "learning/tree/vpred.h"
+#include "metric/ir/incremental_evaluator.h"
 
 namespace quickrank {
 namespace learning {
@@ -34,6 +39,38 @@ namespace forests {
 
 const std::string Mart::NAME_ = "MART";
 
+const std::vector<std::string> Mart::scoringEngineNames = {
+    "auto", "pointer", "quickscorer", "vpred", "oblivious"
+};
+
+Mart::ScoringEngine Mart::get_scoring_engine(std::string name) {
+  auto i_item = std::find(scoringEngineNames.cbegin(),
+                          scoringEngineNames.cend(),
+                          name);
+  if (i_item == scoringEngineNames.cend()) {
+    std::cerr << "!!! Scoring engine " << name << " is not valid."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return ScoringEngine(std::distance(scoringEngineNames.cbegin(), i_item));
+}
+
+const std::vector<std::string> Mart::leafPrecisionNames = {
+    "double", "float32", "int16"
+};
+
+Mart::LeafPrecision Mart::get_leaf_precision(std::string name) {
+  auto i_item = std::find(leafPrecisionNames.cbegin(),
+                          leafPrecisionNames.cend(),
+                          name);
+  if (i_item == leafPrecisionNames.cend()) {
+    std::cerr << "!!! Leaf precision " << name << " is not valid."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return LeafPrecision(std::distance(leafPrecisionNames.cbegin(), i_item));
+}
+
 Mart::Mart(const pugi::xml_document &model) {
   ntrees_ = 0;
   shrinkage_ = 0;
@@ -67,6 +104,12 @@ Mart::Mart(const pugi::xml_document &model) {
         model_info.child("collapse_leaves_factor").text().as_float();
   }
 
+  if (model_info.child("growth_policy")) {
+    growth_policy_ = RegressionTree::get_growth_policy(
+        model_info.child("growth_policy").text().as_string());
+    max_depth_ = model_info.child("max_depth").text().as_int();
+  }
+
   // read ensemble
   ensemble_model_.set_capacity(ntrees_);
 
@@ -104,6 +147,14 @@ std::ostream &Mart::put(std::ostream &os) const {
     os << "# max_features = " << max_features_ << std::endl;
   if (collapse_leaves_factor_)
     os << "# collapse leaves factor = " << collapse_leaves_factor_ << std::endl;
+  if (growth_policy_ != RegressionTree::GrowthPolicy::BEST_FIRST) {
+    os << "# growth policy = "
+       << RegressionTree::get_growth_policy(growth_policy_) << std::endl;
+    if (max_depth_)
+      os << "# max tree depth = " << max_depth_ << std::endl;
+  }
+  if (sparse_)
+    os << "# sparse training data = true" << std::endl;
   if (nthresholds_)
     os << "# no. of thresholds = " << nthresholds_ << std::endl;
   else
@@ -121,14 +172,6 @@ void Mart::init(
   scores_on_training_ = new double[nentries]();  //0.0f initialized
   pseudoresponses_ = new double[nentries]();  //0.0f initialized
   const size_t nfeatures = training_dataset->num_features();
-  sortedsid_ = new size_t * [nfeatures];
-  sortedsize_ = nentries;
-
-  #pragma omp parallel for
-  for (size_t i = 0; i < nfeatures; ++i) {
-    sortedsid_[i] = idx_radixsort(training_dataset->at(0, i),
-                                  training_dataset->num_instances()).release();
-  }
 
   thresholds_ = new float *[nfeatures];
   thresholds_size_ = new size_t[nfeatures];
@@ -136,16 +179,31 @@ void Mart::init(
   #pragma omp parallel for
   for (size_t i = 0; i < nfeatures; ++i) {
     //select feature array related to the current feature index
-    float const *features = training_dataset->at(0, i);  // ->get_fvector(i);
+    float const *features = NULL;
+    size_t nvalues = nentries;
+    //a sparse feature has its non-zero values, and 0 if some sample misses
+    //it: the thresholds only depend on the distinct values
+    std::vector<float> sparse_values;
+    if (training_dataset->is_sparse()) {
+      float const *nonzeros = training_dataset->nonzero_values(i);
+      sparse_values.assign(nonzeros,
+                           nonzeros + training_dataset->num_nonzeros(i));
+      if (sparse_values.size() < nentries)
+        sparse_values.push_back(0.0f);
+      features = sparse_values.data();
+      nvalues = sparse_values.size();
+    } else
+      features = training_dataset->at(0, i);  // ->get_fvector(i);
+    //get_ sample indexes sorted by the fid-th feature, only needed here
+    std::unique_ptr<size_t[]> sortedidx = idx_radixsort(features, nvalues);
+    size_t *idx = sortedidx.get();
     //init with values with the 1st sample
-    size_t *idx = sortedsid_[i];
-    //get_ sample indexes sorted by the fid-th feature
     size_t uniqs_size = 0;
     float *uniqs = (float *) malloc(sizeof(float) *
-        (nthresholds_ == 0 ? sortedsize_ + 1 : nthresholds_ + 1));
+        (nthresholds_ == 0 ? nvalues + 1 : nthresholds_ + 1));
     //skip samples with the same feature value. early stop for if nthresholds!=size_max
     uniqs[uniqs_size++] = features[idx[0]];
-    for (size_t j = 1; j < sortedsize_ && (nthresholds_ == 0 || uniqs_size != nthresholds_ + 1); ++j) {
+    for (size_t j = 1; j < nvalues && (nthresholds_ == 0 || uniqs_size != nthresholds_ + 1); ++j) {
       const float fval = features[idx[j]];
       if (uniqs[uniqs_size - 1] < fval)
         uniqs[uniqs_size++] = fval;
@@ -162,7 +220,7 @@ void Mart::init(
       thresholds_[i] = (float *) malloc(sizeof(float) * (nthresholds_ + 1));
       float t = features[idx[0]];  //equals fmin
       const float step =
-          (float) fabs(features[idx[sortedsize_ - 1]] - t) / nthresholds_;  //(fmax-fmin)/nthresholds
+          (float) fabs(features[idx[nvalues - 1]] - t) / nthresholds_;  //(fmax-fmin)/nthresholds
       for (size_t j = 0; j != nthresholds_; t += step)
         thresholds_[i][j++] = t;
       thresholds_[i][nthresholds_] = FLT_MAX;
@@ -170,9 +228,12 @@ void Mart::init(
   }
 
   // here, pseudo responses is empty !
+  // the histogram quantizes the training data into compact bins
+  histogram_pool_ = std::make_shared<HistogramPool>(nfeatures,
+                                                    thresholds_size_);
   hist_ = new RTRootHistogram(training_dataset.get(),
-                              sortedsid_, sortedsize_,
-                              thresholds_, thresholds_size_);
+                              thresholds_, thresholds_size_, histogram_pool_);
+  thread_best_splits_ = std::make_shared<split_search::ThreadBestSplits>();
 }
 
 void Mart::clear(size_t num_features) {
@@ -186,12 +247,9 @@ void Mart::clear(size_t num_features) {
     delete hist_;
   if (thresholds_size_)
     delete[] thresholds_size_;
-  if (sortedsid_) {
-    for (size_t i = 0; i < num_features; ++i) {
-      delete[] sortedsid_[i];
+  if (thresholds_) {
+    for (size_t i = 0; i < num_features; ++i)
       free(thresholds_[i]);
-    }
-    delete[] sortedsid_;
     delete[] thresholds_;
   }
 
@@ -200,9 +258,10 @@ void Mart::clear(size_t num_features) {
   scores_on_validation_ = NULL;
   pseudoresponses_ = NULL;
   thresholds_size_ = NULL;
-  sortedsid_ = NULL;
   thresholds_ = NULL;
   hist_ = NULL;
+  histogram_pool_.reset();
+  thread_best_splits_.reset();
 }
 
 void Mart::learn(std::shared_ptr<quickrank::data::Dataset> training_dataset,
@@ -218,7 +277,7 @@ void Mart::learn(std::shared_ptr<quickrank::data::Dataset> training_dataset,
 
   // create a copy of the training datasets and put it in vertical format
   std::shared_ptr<quickrank::data::VerticalDataset> vertical_training(
-      new quickrank::data::VerticalDataset(training_dataset));
+      new quickrank::data::VerticalDataset(training_dataset, sparse_));
 
   best_metric_on_validation_ = std::numeric_limits<double>::lowest();
   best_metric_on_training_ = std::numeric_limits<double>::lowest();
@@ -232,6 +291,13 @@ void Mart::learn(std::shared_ptr<quickrank::data::Dataset> training_dataset,
     scores_on_validation_ = new Score[validation_dataset->num_instances()]();
   }
 
+  // the metric is measured after every tree by re-ranking the changed lists
+  typedef quickrank::metric::ir::IncrementalEvaluator Evaluator;
+  Evaluator training_evaluator(scorer, vertical_training);
+  std::unique_ptr<Evaluator> validation_evaluator;
+  if (validation_dataset)
+    validation_evaluator.reset(new Evaluator(scorer, validation_dataset));
+
   // if the ensemble size is greater than zero, it means the learn method has
   // to start not from scratch but from a previously saved (intermediate) model
   if (ensemble_model_.is_notempty()) {
@@ -240,15 +306,15 @@ void Mart::learn(std::shared_ptr<quickrank::data::Dataset> training_dataset,
     // Update the model's outputs on all training samples
     score_dataset(training_dataset, scores_on_training_);
     // run metric
-    best_metric_on_training_ = scorer->evaluate_dataset(
-        vertical_training, scores_on_training_);
+    best_metric_on_training_ = training_evaluator.evaluate(
+        scores_on_training_);
 
     if (validation_dataset) {
       // Update the model's outputs on all validation samples
       score_dataset(validation_dataset, scores_on_validation_);
       // run metric
-      best_metric_on_validation_ = scorer->evaluate_dataset(
-          validation_dataset, scores_on_validation_);
+      best_metric_on_validation_ = validation_evaluator->evaluate(
+          scores_on_validation_);
     }
   }
 
@@ -342,10 +408,14 @@ void Mart::learn(std::shared_ptr<quickrank::data::Dataset> training_dataset,
     ensemble_model_.push(tree->get_proot(), shrinkage_, 0);  // maxlabel);
 
     //Update the model's outputs on all training samples
-    update_modelscores(vertical_training, scores_on_training_, tree.get());
+    //(a sparse vertical copy cannot be traversed by the tree)
+    if (vertical_training->is_sparse())
+      update_modelscores(training_dataset, scores_on_training_, tree.get());
+    else
+      update_modelscores(vertical_training, scores_on_training_, tree.get());
     // run metric
-    quickrank::MetricScore metric_on_training = scorer->evaluate_dataset(
-        vertical_training, scores_on_training_);
+    quickrank::MetricScore metric_on_training = training_evaluator.evaluate(
+        scores_on_training_);
 
     //show results
     std::cout << std::setw(7) << m + 1 << std::setw(9) << metric_on_training;
@@ -356,8 +426,8 @@ void Mart::learn(std::shared_ptr<quickrank::data::Dataset> training_dataset,
       update_modelscores(validation_dataset, scores_on_validation_, tree.get());
 
       // run metric
-      quickrank::MetricScore metric_on_validation = scorer->evaluate_dataset(
-          validation_dataset, scores_on_validation_);
+      quickrank::MetricScore metric_on_validation =
+          validation_evaluator->evaluate(scores_on_validation_);
       std::cout << std::setw(9) << metric_on_validation;
 
       if (metric_on_validation > best_metric_on_validation_) {
@@ -437,7 +507,9 @@ std::unique_ptr<RegressionTree> Mart::fit_regressor_on_gradient(
   /// \todo TODO: memory management of regression tree is wrong!!!
   RegressionTree *tree = new RegressionTree(nleaves_, training_dataset.get(),
                                             pseudoresponses_, minleafsupport_,
-                                            collapse_leaves_factor_);
+                                            collapse_leaves_factor_,
+                                            growth_policy_, max_depth_,
+                                            thread_best_splits_.get());
   tree->fit(hist_, sampleids, max_features_);
   //update the outputs of the tree (with gamma computed using the Newton-Raphson pruning_method)
   tree->update_output(pseudoresponses_);
@@ -449,10 +521,11 @@ void Mart::update_modelscores(std::shared_ptr<data::Dataset> dataset,
   const quickrank::Feature *d = dataset->at(0, 0);
   const size_t offset = 1;
   const size_t num_features = dataset->num_features();
+  const FlatTree flat(tree->get_proot());
   #pragma omp parallel for
   for (size_t i = 0; i < dataset->num_instances(); ++i) {
-    scores[i] += shrinkage_ * tree->get_proot()->score_instance(
-        d + i * num_features, offset);
+    scores[i] += shrinkage_ * flat.score_instance(d + i * num_features,
+                                                  offset);
   }
 }
 
@@ -461,9 +534,10 @@ void Mart::update_modelscores(std::shared_ptr<data::VerticalDataset> dataset,
 
   const quickrank::Feature *d = dataset->at(0, 0);
   const size_t offset = dataset->num_instances();
+  const FlatTree flat(tree->get_proot());
   #pragma omp parallel for
   for (size_t i = 0; i < dataset->num_instances(); ++i) {
-    scores[i] += shrinkage_ * tree->get_proot()->score_instance(d + i, offset);
+    scores[i] += shrinkage_ * flat.score_instance(d + i, offset);
   }
 }
 
@@ -484,6 +558,11 @@ pugi::xml_document *Mart::get_xml_model() const {
   info.append_child("subsample").text() = subsample_;
   info.append_child("max_features").text() = max_features_;
   info.append_child("collapse_leaves_factor").text() = collapse_leaves_factor_;
+  if (growth_policy_ != RegressionTree::GrowthPolicy::BEST_FIRST) {
+    info.append_child("growth_policy").text() =
+        RegressionTree::get_growth_policy(growth_policy_).c_str();
+    info.append_child("max_depth").text() = max_depth_;
+  }
 
   ensemble_model_.append_xml_model(root);
 
@@ -520,6 +599,90 @@ bool Mart::update_weights(std::vector<double>& weights) {
   return ensemble_model_.update_ensemble_weights(weights);
 }
 
+void Mart::score_dataset(std::shared_ptr<data::Dataset> dataset,
+                         Score *scores) const {
+  const Feature *d = dataset->at(0, 0);
+  const size_t ninstances = dataset->num_instances();
+  const size_t nfeatures = dataset->num_features();
+
+  if (leaf_precision_ != LeafPrecision::DOUBLE) {
+    if (!QuantizedEnsemble::is_supported(ensemble_model_)) {
+      std::cerr << "!!! QuantizedEnsemble supports at most "
+                << QuantizedEnsemble::MAX_THRESHOLDS
+                << " distinct thresholds per feature." << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    QuantizedEnsemble(ensemble_model_,
+                      leaf_precision_ == LeafPrecision::FLOAT32 ?
+                      QuantizedEnsemble::LeafType::FLOAT32 :
+                      QuantizedEnsemble::LeafType::INT16)
+        .score(d, ninstances, nfeatures, scores);
+    return;
+  }
+
+  ScoringEngine engine = scoring_engine_;
+  if (engine == ScoringEngine::AUTO) {
+#ifdef QUICKRANK_PERF_STATS
+    // the traversal of the trees is counted only by the pointer engine
+    engine = ScoringEngine::POINTER;
+#else
+    if (ObliviousScorer::is_supported(ensemble_model_))
+      engine = ScoringEngine::OBLIVIOUS;
+    else if (QuickScorer::is_supported(ensemble_model_))
+      engine = ScoringEngine::QUICKSCORER;
+    else
+      engine = ScoringEngine::POINTER;
+#endif
+  }
+
+  switch (engine) {
+    case ScoringEngine::QUICKSCORER:
+      if (!QuickScorer::is_supported(ensemble_model_)) {
+        std::cerr << "!!! QuickScorer supports trees with at most "
+                  << QuickScorer::MAX_LEAVES << " leaves." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      QuickScorer(ensemble_model_).score(d, ninstances, nfeatures, scores);
+      break;
+    case ScoringEngine::VPRED:
+      if (!VPred::is_supported(ensemble_model_)) {
+        std::cerr << "!!! VPred supports trees with depth at most "
+                  << VPred::MAX_DEPTH << "." << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      VPred(ensemble_model_).score(d, ninstances, nfeatures, scores);
+      break;
+    case ScoringEngine::OBLIVIOUS:
+      if (!ObliviousScorer::is_supported(ensemble_model_)) {
+        std::cerr << "!!! ObliviousScorer supports oblivious trees with depth"
+                  << " at most " << ObliviousScorer::MAX_DEPTH << "."
+                  << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      ObliviousScorer(ensemble_model_).score(d, ninstances, nfeatures,
+                                             scores);
+      break;
+    default:
+      ensemble_model_.score(d, ninstances, nfeatures, scores);
+      break;
+  }
+}
+
+TopKStats Mart::score_top_k(const data::QueryResults &results,
+                            const size_t nfeatures,
+                            const size_t k,
+                            Score *scores,
+                            const double bound_factor,
+                            const size_t stage_trees) const {
+  TopKStats stats;
+  stats.evaluations = ensemble_model_.score_top_k(
+      results.features(), results.num_results(), nfeatures, k, stage_trees,
+      bound_factor, scores, stats.pruned_documents);
+  stats.saved_evaluations = results.num_results()
+      * ensemble_model_.get_size() - stats.evaluations;
+  return stats;
+}
+
 void Mart::print_additional_stats(void) const {
 #ifdef QUICKRANK_PERF_STATS
   std::cout << "#" << std::endl;
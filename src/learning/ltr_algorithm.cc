@@ -51,6 +51,20 @@ void LTR_Algorithm::score_dataset(std::shared_ptr<data::Dataset> dataset,
   }
 }
 
+TopKStats LTR_Algorithm::score_top_k(const data::QueryResults &results,
+                                     const size_t nfeatures,
+                                     const size_t k,
+                                     Score *scores,
+                                     const double bound_factor,
+                                     const size_t stage_trees) const {
+  const Feature *d = results.features();
+  for (size_t i = 0; i < results.num_results(); ++i)
+    scores[i] = score_document(d + i * nfeatures);
+  TopKStats stats;
+  stats.evaluations = results.num_results();
+  return stats;
+}
+
 void LTR_Algorithm::save(std::string output_basename, int iteration) const {
   if (!output_basename.empty()) {
     std::string filename(output_basename);
@@ -38,6 +38,26 @@
 namespace quickrank {
 namespace learning {
 
+namespace {
+
+/// Returns the growth policy of the trees of MART/LambdaMART, which must
+/// not be combined with collapsing leaves unless it is BEST_FIRST.
+RegressionTree::GrowthPolicy tree_growth_policy(ParamsMap &pmap) {
+  RegressionTree::GrowthPolicy growth_policy =
+      RegressionTree::get_growth_policy(pmap.get<std::string>("growth-policy"));
+  if (growth_policy != RegressionTree::GrowthPolicy::BEST_FIRST
+      && pmap.get<float>("collapse-leaves-factor") > 0) {
+    std::cerr << " !! Collapsing leaves requires the "
+              << RegressionTree::get_growth_policy(
+                  RegressionTree::GrowthPolicy::BEST_FIRST)
+              << " growth policy." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return growth_policy;
+}
+
+}  // namespace
+
 std::shared_ptr<quickrank::learning::LTR_Algorithm> ltr_algorithm_factory(
     ParamsMap &pmap) {
 
@@ -64,6 +84,16 @@ std::shared_ptr<quickrank::learning::LTR_Algorithm> ltr_algorithm_factory(
     std::transform(algo_name.begin(), algo_name.end(),
                    algo_name.begin(), ::toupper);
 
+    if (pmap.isSet("sparse")
+        && algo_name != quickrank::learning::forests::Mart::NAME_
+        && algo_name != quickrank::learning::forests::LambdaMart::NAME_) {
+      std::cerr << " !! Sparse training data is supported only by "
+                << quickrank::learning::forests::Mart::NAME_ << " and "
+                << quickrank::learning::forests::LambdaMart::NAME_ << "."
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
     if (algo_name == quickrank::learning::forests::LambdaMart::NAME_) {
       ltr_algo = std::shared_ptr<quickrank::learning::LTR_Algorithm>(
           new quickrank::learning::forests::LambdaMart(
@@ -75,7 +105,10 @@ std::shared_ptr<quickrank::learning::LTR_Algorithm> ltr_algorithm_factory(
               pmap.get<float>("subsample"),
               pmap.get<float>("max-features"),
               pmap.get<size_t>("end-after-rounds"),
-              pmap.get<float>("collapse-leaves-factor")
+              pmap.get<float>("collapse-leaves-factor"),
+              tree_growth_policy(pmap),
+              pmap.get<size_t>("tree-depth"),
+              pmap.isSet("sparse")
           ));
     } else if (algo_name == quickrank::learning::forests::LambdaMartSelective::NAME_) {
       ltr_algo = std::shared_ptr<quickrank::learning::LTR_Algorithm>(
@@ -120,7 +153,10 @@ std::shared_ptr<quickrank::learning::LTR_Algorithm> ltr_algorithm_factory(
               pmap.get<float>("subsample"),
               pmap.get<float>("max-features"),
               pmap.get<size_t>("end-after-rounds"),
-              pmap.get<float>("collapse-leaves-factor")
+              pmap.get<float>("collapse-leaves-factor"),
+              tree_growth_policy(pmap),
+              pmap.get<size_t>("tree-depth"),
+              pmap.isSet("sparse")
           ));
     } else if (algo_name == quickrank::learning::forests::RandomForest::NAME_) {
         ltr_algo = std::shared_ptr<quickrank::learning::LTR_Algorithm>(
@@ -19,10 +19,14 @@
  * Contributor:
  *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
  */
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <iomanip>
+#include <numeric>
 
 #include "learning/tree/ensemble.h"
+#include "learning/tree/scoring_blocks.h"
 
 Ensemble::Ensemble(Ensemble&& other) {
   size = other.size;
@@ -41,8 +45,10 @@ Ensemble::~Ensemble() {
 
 void Ensemble::reset_state() {
   if (arr) {
-    for (size_t i = 0; i < size; ++i)
+    for (size_t i = 0; i < size; ++i) {
       delete arr[i].root;
+      delete arr[i].flat;
+    }
     free(arr);
     arr = nullptr;
   }
@@ -73,8 +79,10 @@ void Ensemble::set_capacity(const size_t n) {
 
     if (n < size) {
       // We need to call the destructor for the RTNode exceeding the new size
-      for (size_t i = n; i < size; ++i)
+      for (size_t i = n; i < size; ++i) {
         delete arr[i].root;
+        delete arr[i].flat;
+      }
       size = n;
     }
 
@@ -104,7 +112,9 @@ void Ensemble::push(RTNode *root, const double weight, const float maxlabel) {
 }
 
 void Ensemble::pop() {
-  delete arr[--size].root;
+  --size;
+  delete arr[size].root;
+  delete arr[size].flat;
 }
 
 // assumes vertical dataset
@@ -113,17 +123,99 @@ quickrank::Score Ensemble::score_instance(const quickrank::Feature *d,
   double sum = 0.0f;
 // #pragma omp parallel for reduction(+:sum)
   for (size_t i = 0; i < size; ++i)
-    sum += arr[i].root->score_instance(d, offset) * arr[i].weight;
+    sum += arr[i].flat->score_instance(d, offset) * arr[i].weight;
   return sum;
 }
 
+void Ensemble::score(const quickrank::Feature *d,
+                     const size_t ninstances,
+                     const size_t nfeatures,
+                     quickrank::Score *scores) const {
+  std::vector<size_t> tree_bytes(size);
+  for (size_t i = 0; i < size; ++i)
+    tree_bytes[i] = arr[i].flat->num_bytes();
+  const std::vector<size_t> blocks = scoring_blocks::tree_blocks(tree_bytes);
+  const size_t nblocks = blocks.size() - 1;
+  const size_t docs_per_block = scoring_blocks::documents_per_block(
+      ninstances, nfeatures, nblocks);
+  const size_t ndoc_blocks = (ninstances + docs_per_block - 1)
+      / docs_per_block;
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t db = 0; db < ndoc_blocks; ++db) {
+    const size_t begin = db * docs_per_block;
+    const size_t end = std::min(ninstances, begin + docs_per_block);
+    std::fill(scores + begin, scores + end, 0.0);
+    for (size_t b = 0; b < nblocks; ++b)
+      for (size_t i = begin; i < end; ++i)
+        for (size_t t = blocks[b]; t < blocks[b + 1]; ++t)
+          scores[i] += arr[t].flat->score_instance(d + i * nfeatures, 1)
+              * arr[t].weight;
+  }
+}
+
+size_t Ensemble::score_top_k(const quickrank::Feature *d,
+                             const size_t ninstances,
+                             const size_t nfeatures,
+                             const size_t k,
+                             const size_t stage_trees,
+                             const double bound_factor,
+                             quickrank::Score *scores,
+                             size_t &npruned) const {
+  // bounds of the sum of the outputs of trees [t, size)
+  std::vector<double> rest_min(size + 1, 0.0), rest_max(size + 1, 0.0);
+  for (size_t t = size; t-- > 0;) {
+    const double lo = arr[t].flat->min_leaf() * arr[t].weight;
+    const double hi = arr[t].flat->max_leaf() * arr[t].weight;
+    rest_min[t] = rest_min[t + 1] + std::min(lo, hi);
+    rest_max[t] = rest_max[t + 1] + std::max(lo, hi);
+  }
+
+  std::vector<size_t> active(ninstances);
+  std::iota(active.begin(), active.end(), 0);
+  std::fill(scores, scores + ninstances, 0.0);
+  std::vector<double> lower;
+  const size_t stage = std::max<size_t>(stage_trees, 1);
+  size_t evaluations = 0;
+  npruned = 0;
+  for (size_t begin = 0; begin < size; begin += stage) {
+    const size_t end = std::min(size, begin + stage);
+    for (size_t i: active)
+      for (size_t t = begin; t < end; ++t)
+        scores[i] += arr[t].flat->score_instance(d + i * nfeatures, 1)
+            * arr[t].weight;
+    evaluations += active.size() * (end - begin);
+    if (end == size || k == 0 || active.size() <= k)
+      continue;
+
+    // the k-th largest lower bound is not larger than the k-th score
+    lower.resize(active.size());
+    for (size_t j = 0; j < active.size(); ++j)
+      lower[j] = scores[active[j]] + bound_factor * rest_min[end];
+    std::nth_element(lower.begin(), lower.begin() + k - 1, lower.end(),
+                     std::greater<double>());
+    const double threshold = lower[k - 1];
+    size_t nactive = 0;
+    for (size_t i: active) {
+      const double upper = scores[i] + bound_factor * rest_max[end];
+      if (upper < threshold)
+        scores[i] = upper;
+      else
+        active[nactive++] = i;
+    }
+    npruned += active.size() - nactive;
+    active.resize(nactive);
+  }
+  return evaluations;
+}
+
 std::shared_ptr<std::vector<quickrank::Score>>
 Ensemble::partial_scores_instance(const quickrank::Feature *d,
                                   bool ignore_weights,
                                   const size_t offset) const {
   std::vector<quickrank::Score> scores(size);
   for (unsigned int i = 0; i < size; ++i) {
-    scores[i] = arr[i].root->score_instance(d, offset);
+    scores[i] = arr[i].flat->score_instance(d, offset);
     if (!ignore_weights)
       scores[i] *= arr[i].weight;
   }
@@ -153,6 +245,7 @@ bool Ensemble::filter_out_zero_weighted_trees() {
     if (arr[i].weight == 0) {
       // Remove 0-weight tree
       delete arr[i].root;
+      delete arr[i].flat;
     } else {
       // Check if we need to move back the tree in the array of root trees
       if (idx_curr < i)
@@ -0,0 +1,80 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/feature_bins.h"
+
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+// alignment of the bins of each feature
+const size_t BINS_ALIGNMENT = 64;
+
+}  // namespace
+
+const uint32_t FeatureBins::NO_SLOT;
+
+FeatureBins::FeatureBins(size_t nfeatures, size_t ninstances,
+                         const size_t *thresholds_size)
+    : ninstances_(ninstances),
+      bin_size_(nfeatures),
+      offsets_(nfeatures) {
+  allocate(thresholds_size, NULL);
+}
+
+FeatureBins::FeatureBins(size_t nfeatures, size_t ninstances,
+                         const size_t *thresholds_size,
+                         const size_t *default_bins, const size_t *nentries)
+    : ninstances_(ninstances),
+      bin_size_(nfeatures),
+      offsets_(nfeatures),
+      default_bins_(default_bins, default_bins + nfeatures),
+      doc_offsets_(nfeatures + 1, 0) {
+  if (ninstances > NO_SLOT) {
+    std::cerr << "!!! Sparse bins support up to " << NO_SLOT
+              << " documents." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  for (size_t f = 0; f < nfeatures; ++f)
+    doc_offsets_[f + 1] = doc_offsets_[f] + nentries[f];
+  docs_.resize(doc_offsets_[nfeatures]);
+  sample_slots_.assign(ninstances, NO_SLOT);
+  allocate(thresholds_size, nentries);
+}
+
+void FeatureBins::allocate(const size_t *thresholds_size,
+                           const size_t *nentries) {
+  size_t bytes = 0;
+  for (size_t f = 0; f < bin_size_.size(); ++f) {
+    if (thresholds_size[f] <= UINT8_MAX + 1)
+      bin_size_[f] = sizeof(uint8_t);
+    else if (thresholds_size[f] <= UINT16_MAX + 1)
+      bin_size_[f] = sizeof(uint16_t);
+    else
+      bin_size_[f] = sizeof(uint32_t);
+    offsets_[f] = bytes;
+    const size_t nbins = nentries ? nentries[f] : ninstances_;
+    bytes += (bin_size_[f] * nbins + BINS_ALIGNMENT - 1)
+        / BINS_ALIGNMENT * BINS_ALIGNMENT;
+  }
+  data_.resize(bytes);
+}
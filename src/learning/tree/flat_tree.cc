@@ -0,0 +1,45 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/flat_tree.h"
+
+#include <algorithm>
+
+FlatTree::FlatTree(RTNode const *root) {
+  root_ = add_subtree(root);
+  min_leaf_ = *std::min_element(leaves_.begin(), leaves_.end());
+  max_leaf_ = *std::max_element(leaves_.begin(), leaves_.end());
+}
+
+int32_t FlatTree::add_subtree(RTNode const *node) {
+  if (node->is_leaf()) {
+    leaves_.push_back(node->avglabel);
+    return ~(int32_t) (leaves_.size() - 1);
+  }
+  const int32_t id = (int32_t) nodes_.size();
+  nodes_.push_back({(uint32_t) node->get_feature_idx(), node->threshold,
+                    0, 0});
+  const int32_t left = add_subtree(node->left);
+  const int32_t right = add_subtree(node->right);
+  nodes_[id].left = left;
+  nodes_[id].right = right;
+  return id;
+}
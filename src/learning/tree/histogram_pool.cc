@@ -0,0 +1,105 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/histogram_pool.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// alignment of the bins of each feature
+const size_t BINS_ALIGNMENT = 64;
+
+// bins per cache line (sums and counts have the same size)
+const size_t BINS_PER_LINE = BINS_ALIGNMENT / sizeof(double);
+
+static_assert(sizeof(double) == sizeof(size_t),
+              "label sums and counts are expected to have the same size");
+
+}  // namespace
+
+HistogramPool::HistogramPool(size_t nfeatures, const size_t *thresholds_size)
+    : offsets_(nfeatures + 1, 0) {
+  for (size_t f = 0; f < nfeatures; ++f)
+    offsets_[f + 1] = offsets_[f] + (thresholds_size[f] + BINS_PER_LINE - 1)
+        / BINS_PER_LINE * BINS_PER_LINE;
+}
+
+HistogramPool::~HistogramPool() {
+  for (HistogramBlock *block: free_) {
+    free(block->sumlbl_data);
+    delete block;
+  }
+}
+
+HistogramBlock *HistogramPool::acquire() {
+  HistogramBlock *block = NULL;
+  #pragma omp critical(histogram_pool)
+  {
+    if (!free_.empty()) {
+      block = free_.back();
+      free_.pop_back();
+    } else {
+      ++nblocks_;
+    }
+  }
+  if (block)
+    return block;
+
+  // bins of sums and counts, followed by the pointers to each feature
+  const size_t nbins = num_bins();
+  const size_t nfeatures = num_features();
+  const size_t bytes = 2 * nbins * sizeof(double)
+      + nfeatures * (sizeof(double *) + sizeof(size_t *));
+  void *data = NULL;
+  if (posix_memalign(&data, BINS_ALIGNMENT, bytes) != 0) {
+    std::cerr << "!!! Unable to allocate a histogram of " << bytes
+              << " bytes" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  memset(data, 0, 2 * nbins * sizeof(double));
+
+  block = new HistogramBlock();
+  block->sumlbl_data = static_cast<double *>(data);
+  block->count_data = reinterpret_cast<size_t *>(block->sumlbl_data + nbins);
+  block->sumlbl = reinterpret_cast<double **>(block->count_data + nbins);
+  block->count = reinterpret_cast<size_t **>(block->sumlbl + nfeatures);
+  for (size_t f = 0; f < nfeatures; ++f) {
+    block->sumlbl[f] = block->sumlbl_data + offsets_[f];
+    block->count[f] = block->count_data + offsets_[f];
+  }
+  return block;
+}
+
+void HistogramPool::release(HistogramBlock *block) {
+  #pragma omp critical(histogram_pool)
+  free_.push_back(block);
+}
+
+void HistogramPool::clear_sumlbl(HistogramBlock *block) const {
+  memset(block->sumlbl_data, 0, num_bins() * sizeof(double));
+}
+
+void HistogramPool::clear(HistogramBlock *block) const {
+  memset(block->sumlbl_data, 0, 2 * num_bins() * sizeof(double));
+}
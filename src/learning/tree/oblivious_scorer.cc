@@ -0,0 +1,304 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/oblivious_scorer.h"
+#include "learning/tree/scoring_blocks.h"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define QUICKRANK_OBLIVIOUS_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
+
+namespace {
+
+size_t tree_depth(RTNode const *node) {
+  if (node->is_leaf())
+    return 0;
+  return 1 + std::max(tree_depth(node->left), tree_depth(node->right));
+}
+
+/// Checks that leaves are all at \a depth and that the nodes of every
+/// level are equal to the first one found in \a level_nodes.
+bool is_oblivious(RTNode const *node, const size_t level, const size_t depth,
+                  std::vector<RTNode const *> &level_nodes) {
+  if (node->is_leaf())
+    return level == depth;
+  RTNode const *first = level_nodes[level];
+  if (!first)
+    level_nodes[level] = node;
+  else if (first->get_feature_idx() != node->get_feature_idx()
+      || first->threshold != node->threshold)
+    return false;
+  return is_oblivious(node->left, level + 1, depth, level_nodes)
+      && is_oblivious(node->right, level + 1, depth, level_nodes);
+}
+
+void save_leaves(RTNode const *node, double *leaves, size_t &nleaves) {
+  if (node->is_leaf()) {
+    leaves[nleaves++] = node->avglabel;
+    return;
+  }
+  save_leaves(node->left, leaves, nleaves);
+  save_leaves(node->right, leaves, nleaves);
+}
+
+}  // namespace
+
+bool ObliviousScorer::is_supported(const Ensemble &ensemble) {
+  for (size_t t = 0; t < ensemble.get_size(); ++t) {
+    RTNode const *root = ensemble.getTree(t);
+    const size_t depth = tree_depth(root);
+    std::vector<RTNode const *> level_nodes(depth, nullptr);
+    if (depth > MAX_DEPTH || !is_oblivious(root, 0, depth, level_nodes))
+      return false;
+  }
+  return true;
+}
+
+ObliviousScorer::ObliviousScorer(const Ensemble &ensemble) {
+  ntrees_ = ensemble.get_size();
+  depths_.resize(ntrees_);
+  level_offsets_.resize(ntrees_);
+  leaf_offsets_.resize(ntrees_);
+  weights_.resize(ntrees_);
+
+  size_t nlevels = 0, nleaves = 0;
+  for (size_t t = 0; t < ntrees_; ++t) {
+    depths_[t] = tree_depth(ensemble.getTree(t));
+    level_offsets_[t] = nlevels;
+    leaf_offsets_[t] = nleaves;
+    nlevels += depths_[t];
+    nleaves += (size_t) 1 << depths_[t];
+    weights_[t] = ensemble.getWeight(t);
+  }
+
+  features_.resize(nlevels);
+  thresholds_.resize(nlevels);
+  leaves_.resize(nleaves);
+  for (size_t t = 0; t < ntrees_; ++t) {
+    // the leftmost path has a node for every level
+    RTNode const *node = ensemble.getTree(t);
+    for (size_t l = 0; l < depths_[t]; ++l, node = node->left) {
+      features_[level_offsets_[t] + l] = (int32_t) node->get_feature_idx();
+      thresholds_[level_offsets_[t] + l] = node->threshold;
+      nmodel_features_ = std::max(nmodel_features_,
+                                  node->get_feature_idx() + 1);
+    }
+    size_t n = 0;
+    save_leaves(ensemble.getTree(t), &leaves_[leaf_offsets_[t]], n);
+  }
+}
+
+void ObliviousScorer::score_instance(const quickrank::Feature *d,
+                                     const size_t tree_begin,
+                                     const size_t tree_end,
+                                     quickrank::Score &score) const {
+  for (size_t t = tree_begin; t < tree_end; ++t) {
+    const int32_t *features = &features_[level_offsets_[t]];
+    const float *thresholds = &thresholds_[level_offsets_[t]];
+    size_t idx = 0;
+    for (size_t l = 0; l < depths_[t]; ++l)
+      idx = 2 * idx + !(d[features[l]] <= thresholds[l]);
+    score += leaves_[leaf_offsets_[t] + idx] * weights_[t];
+  }
+}
+
+void ObliviousScorer::score_lockstep_scalar(const quickrank::Feature *d,
+                                            const size_t nfeatures,
+                                            const size_t tree_begin,
+                                            const size_t tree_end,
+                                            quickrank::Score *scores) const {
+  int32_t idx[LOCKSTEP];
+  for (size_t t = tree_begin; t < tree_end; ++t) {
+    const int32_t *features = &features_[level_offsets_[t]];
+    const float *thresholds = &thresholds_[level_offsets_[t]];
+    std::fill(idx, idx + LOCKSTEP, 0);
+    for (size_t l = 0; l < depths_[t]; ++l)
+      for (size_t v = 0; v < LOCKSTEP; ++v)
+        idx[v] = 2 * idx[v]
+            + !(d[v * nfeatures + features[l]] <= thresholds[l]);
+    add_leaves(t, idx, scores);
+  }
+}
+
+#ifdef QUICKRANK_OBLIVIOUS_X86
+
+__attribute__((target("avx2")))
+void ObliviousScorer::score_lockstep_avx2(const quickrank::Feature *d,
+                                          const size_t nfeatures,
+                                          const size_t tree_begin,
+                                          const size_t tree_end,
+                                          quickrank::Score *scores) const {
+  static_assert(LOCKSTEP == 16, "a lockstep must fill two AVX2 registers");
+  const __m256i stride = _mm256_set1_epi32((int) nfeatures);
+  const __m256i lo_offsets = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), stride);
+  const __m256i hi_offsets = _mm256_mullo_epi32(
+      _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15), stride);
+  alignas(32) int32_t leaf[LOCKSTEP];
+  for (size_t t = tree_begin; t < tree_end; ++t) {
+    const int32_t *features = &features_[level_offsets_[t]];
+    const float *thresholds = &thresholds_[level_offsets_[t]];
+    __m256i lo = _mm256_setzero_si256();
+    __m256i hi = _mm256_setzero_si256();
+    for (size_t l = 0; l < depths_[t]; ++l) {
+      const float *x = d + features[l];
+      const __m256 theta = _mm256_set1_ps(thresholds[l]);
+      // a true comparison is -1, i.e., a one appended to the leaf index
+      const __m256i lo_right = _mm256_castps_si256(_mm256_cmp_ps(
+          _mm256_i32gather_ps(x, lo_offsets, 4), theta, _CMP_NLE_UQ));
+      const __m256i hi_right = _mm256_castps_si256(_mm256_cmp_ps(
+          _mm256_i32gather_ps(x, hi_offsets, 4), theta, _CMP_NLE_UQ));
+      lo = _mm256_sub_epi32(_mm256_slli_epi32(lo, 1), lo_right);
+      hi = _mm256_sub_epi32(_mm256_slli_epi32(hi, 1), hi_right);
+    }
+    _mm256_store_si256((__m256i *) leaf, lo);
+    _mm256_store_si256((__m256i *) (leaf + 8), hi);
+    add_leaves(t, leaf, scores);
+  }
+}
+
+__attribute__((target("avx512f")))
+void ObliviousScorer::score_lockstep_avx512(const quickrank::Feature *d,
+                                            const size_t nfeatures,
+                                            const size_t tree_begin,
+                                            const size_t tree_end,
+                                            quickrank::Score *scores) const {
+  static_assert(LOCKSTEP == 16, "a lockstep must fill an AVX-512 register");
+  const __m512i offsets = _mm512_mullo_epi32(
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                        8, 9, 10, 11, 12, 13, 14, 15),
+      _mm512_set1_epi32((int) nfeatures));
+  const __m512i one = _mm512_set1_epi32(1);
+  const __mmask16 all = 0xFFFF;
+  alignas(64) int32_t leaf[LOCKSTEP];
+  for (size_t t = tree_begin; t < tree_end; ++t) {
+    const int32_t *features = &features_[level_offsets_[t]];
+    const float *thresholds = &thresholds_[level_offsets_[t]];
+    __m512i idx = _mm512_setzero_si512();
+    for (size_t l = 0; l < depths_[t]; ++l) {
+      // masked forms avoid the undefined registers of the unmasked ones
+      const __m512 x = _mm512_mask_i32gather_ps(
+          _mm512_setzero_ps(), all, offsets, d + features[l], 4);
+      const __mmask16 right = _mm512_cmp_ps_mask(
+          x, _mm512_set1_ps(thresholds[l]), _CMP_NLE_UQ);
+      idx = _mm512_add_epi32(idx, idx);
+      idx = _mm512_mask_add_epi32(idx, right, idx, one);
+    }
+    _mm512_store_si512(leaf, idx);
+    add_leaves(t, leaf, scores);
+  }
+}
+
+ObliviousScorer::Kernel ObliviousScorer::best_kernel() {
+  if (__builtin_cpu_supports("avx512f"))
+    return &ObliviousScorer::score_lockstep_avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return &ObliviousScorer::score_lockstep_avx2;
+  return &ObliviousScorer::score_lockstep_scalar;
+}
+
+const char *ObliviousScorer::kernel_name() {
+  if (__builtin_cpu_supports("avx512f"))
+    return "avx512";
+  if (__builtin_cpu_supports("avx2"))
+    return "avx2";
+  return "scalar";
+}
+
+#else
+
+void ObliviousScorer::score_lockstep_avx2(const quickrank::Feature *d,
+                                          const size_t nfeatures,
+                                          const size_t tree_begin,
+                                          const size_t tree_end,
+                                          quickrank::Score *scores) const {
+  score_lockstep_scalar(d, nfeatures, tree_begin, tree_end, scores);
+}
+
+void ObliviousScorer::score_lockstep_avx512(const quickrank::Feature *d,
+                                            const size_t nfeatures,
+                                            const size_t tree_begin,
+                                            const size_t tree_end,
+                                            quickrank::Score *scores) const {
+  score_lockstep_scalar(d, nfeatures, tree_begin, tree_end, scores);
+}
+
+ObliviousScorer::Kernel ObliviousScorer::best_kernel() {
+  return &ObliviousScorer::score_lockstep_scalar;
+}
+
+const char *ObliviousScorer::kernel_name() {
+  return "scalar";
+}
+
+#endif
+
+void ObliviousScorer::score(const quickrank::Feature *d,
+                            const size_t ninstances,
+                            const size_t nfeatures,
+                            quickrank::Score *scores) const {
+  if (nfeatures < nmodel_features_) {
+    std::cerr << "!!! The model uses " << nmodel_features_
+              << " features but documents have only " << nfeatures
+              << "." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<size_t> tree_bytes(ntrees_);
+  for (size_t t = 0; t < ntrees_; ++t)
+    tree_bytes[t] = depths_[t] * (sizeof(int32_t) + sizeof(float))
+        + ((size_t) 1 << depths_[t]) * sizeof(double);
+  const std::vector<size_t> blocks = scoring_blocks::tree_blocks(tree_bytes);
+  const size_t nblocks = blocks.size() - 1;
+  // blocks of documents are made of whole locksteps
+  size_t docs_per_block = scoring_blocks::documents_per_block(
+      ninstances, nfeatures, nblocks);
+  docs_per_block = (docs_per_block + LOCKSTEP - 1) / LOCKSTEP * LOCKSTEP;
+  const size_t ndoc_blocks = (ninstances + docs_per_block - 1)
+      / docs_per_block;
+  const Kernel kernel = best_kernel();
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t db = 0; db < ndoc_blocks; ++db) {
+    const size_t begin = db * docs_per_block;
+    const size_t end = std::min(ninstances, begin + docs_per_block);
+    std::fill(scores + begin, scores + end, 0.0);
+    for (size_t b = 0; b < nblocks; ++b) {
+      size_t i = begin;
+      for (; i + LOCKSTEP <= end; i += LOCKSTEP)
+        (this->*kernel)(d + i * nfeatures, nfeatures, blocks[b],
+                        blocks[b + 1], scores + i);
+      for (; i < end; ++i)
+        score_instance(d + i * nfeatures, blocks[b], blocks[b + 1],
+                       scores[i]);
+    }
+  }
+}
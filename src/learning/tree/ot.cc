@@ -36,7 +36,9 @@ void ObliviousRT::fit(RTNodeHistogram *hist,
   //histarray and nodearray store histograms and treenodes used in the entire procedure (i.e. the entire tree)
   RTNode **nodearray = new RTNode *[POWTWO(treedepth + 1)](); //initialized NULL
   //init tree root
-  nodearray[0] = root = new RTNode(sampleids, hist);
+  const size_t nsampleids = hist->count[0][hist->thresholds_size[0] - 1];
+  init_samples(sampleids, nsampleids);
+  nodearray[0] = root = new RTNode(0, nsampleids, hist);
   //allocate a matrix for each (feature,threshold)
   double **sum_scores = new double *[nfeaturesamples];
   for (size_t i = 0; i < nfeaturesamples; ++i)
@@ -58,7 +60,7 @@ void ObliviousRT::fit(RTNodeHistogram *hist,
     for (size_t i = lbegin; i < lend; ++i)
       fill(sum_scores, nfeaturesamples, nodearray[i]->hist);
     //find best split in the matrix
-    const int nth = omp_get_num_procs();
+    const int nth = omp_get_max_threads();
     double *thread_maxscore = new double[nth];  // double thread_minvar[nth];
     size_t *thread_best_featureidx =
         new size_t[nth];  // size_t thread_best_featureidx[nth];
@@ -102,51 +104,50 @@ void ObliviousRT::fit(RTNodeHistogram *hist,
       //calculate some values related to best_featureidx and best_thresholdid
       const size_t last_thresholdid =
           node->hist->thresholds_size[best_featureidx] - 1;
-      const size_t lcount =
-          node->hist->count[best_featureidx][best_thresholdid];
-      const size_t rcount =
-          node->hist->count[best_featureidx][last_thresholdid] - lcount;
       const float best_threshold =
           node->hist->thresholds[best_featureidx][best_thresholdid];
       //split samples between left and right child
-      size_t *lsamples = new size_t[lcount], lsize = 0;
-      size_t *rsamples = new size_t[rcount], rsize = 0;
-      float const *features = training_dataset->at(0,
-                                                   best_featureidx);  //training_set->get_fvector(best_featureidx);
-      for (size_t j = 0, nsampleids = node->nsampleids; j < nsampleids;
-           ++j) {
-        const size_t k = node->sampleids[j];
-        if (features[k] <= best_threshold)
-          lsamples[lsize++] = k;
-        else
-          rsamples[rsize++] = k;
-      }
+      const size_t lend = partition(node->sample_begin, node->sample_end,
+                                    node->hist->bins, best_featureidx,
+                                    best_thresholdid);
+      const size_t lsize = lend - node->sample_begin;
+      const size_t rsize = node->sample_end - lend;
       //create new histograms (except for the last level when nodes are leaves)
       RTNodeHistogram *lhist = NULL;
       RTNodeHistogram *rhist = NULL;
       if (depth != treedepth - 1) {
-        lhist = new RTNodeHistogram(node->hist, lsamples, lsize,
-                                    training_labels);
+        //only the smaller child is scanned, the larger one is subtracted
+        const bool left_smaller = lsize <= rsize;
+        RTNodeHistogram *small_hist = left_smaller
+            ? new RTNodeHistogram(node->hist, sampleids_ + node->sample_begin,
+                                  lsize, training_labels)
+            : new RTNodeHistogram(node->hist, sampleids_ + lend, rsize,
+                                  training_labels);
+        RTNodeHistogram *large_hist = NULL;
         if (node == root)
-          rhist = new RTNodeHistogram(node->hist, lhist);
+          large_hist = new RTNodeHistogram(node->hist, small_hist);
         else {
-          //save some new/delete by converting parent histogram into the right-child one
-          node->hist->transform_intorightchild(lhist);
-          rhist = node->hist;
+          //save some new/delete by converting parent histogram into the larger-child one
+          node->hist->transform_intochild(small_hist);
+          large_hist = node->hist;
           node->hist = NULL;
         }
+        lhist = left_smaller ? small_hist : large_hist;
+        rhist = left_smaller ? large_hist : small_hist;
         //update current node
-        node->left = nodearray[2 * i + 1] = new RTNode(lsamples, lhist);
-        node->right = nodearray[2 * i + 2] = new RTNode(rsamples, rhist);
+        node->left = nodearray[2 * i + 1] =
+            new RTNode(node->sample_begin, lend, lhist);
+        node->right = nodearray[2 * i + 2] =
+            new RTNode(lend, node->sample_end, rhist);
       } else {
         const double lsum =
             node->hist->sumlbl[best_featureidx][best_thresholdid];
         const double rsum =
             node->hist->sumlbl[best_featureidx][last_thresholdid] - lsum;
-        node->left = nodearray[2 * i + 1] = new RTNode(lsamples, lsize,
-                                                       lsum / lsize);
-        node->right = nodearray[2 * i + 2] = new RTNode(rsamples, rsize,
-                                                        rsum / rsize);
+        node->left = nodearray[2 * i + 1] =
+            new RTNode(node->sample_begin, lend, lsum / lsize);
+        node->right = nodearray[2 * i + 2] =
+            new RTNode(lend, node->sample_end, rsum / rsize);
       }
       node->set_feature(
           best_featureidx,
@@ -155,8 +156,8 @@ void ObliviousRT::fit(RTNodeHistogram *hist,
       // node->deviance = minvar;
       //free mem
       if (depth) {
-        delete node->hist, delete[] node->sampleids;
-        node->hist = NULL, node->sampleids = NULL, node->nsampleids = 0;
+        delete node->hist;
+        node->hist = NULL;
       }
     }
   }
@@ -0,0 +1,196 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/quantized_ensemble.h"
+#include "learning/tree/scoring_blocks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+namespace {
+
+typedef std::map<size_t, std::vector<float>> FeatureThresholds;
+
+void collect_thresholds(RTNode const *node, FeatureThresholds &thresholds) {
+  if (node->is_leaf())
+    return;
+  thresholds[node->get_feature_idx()].push_back(node->threshold);
+  collect_thresholds(node->left, thresholds);
+  collect_thresholds(node->right, thresholds);
+}
+
+/// Returns the sorted distinct thresholds of every feature of \a ensemble.
+FeatureThresholds distinct_thresholds(const Ensemble &ensemble) {
+  FeatureThresholds thresholds;
+  for (size_t t = 0; t < ensemble.get_size(); ++t)
+    collect_thresholds(ensemble.getTree(t), thresholds);
+  for (auto &f: thresholds) {
+    std::sort(f.second.begin(), f.second.end());
+    f.second.erase(std::unique(f.second.begin(), f.second.end()),
+                   f.second.end());
+  }
+  return thresholds;
+}
+
+}  // namespace
+
+bool QuantizedEnsemble::is_supported(const Ensemble &ensemble) {
+  const FeatureThresholds thresholds = distinct_thresholds(ensemble);
+  if (thresholds.size() > MAX_FEATURES)
+    return false;
+  for (auto const &f: thresholds)
+    if (f.second.size() > MAX_THRESHOLDS)
+      return false;
+  return true;
+}
+
+QuantizedEnsemble::QuantizedEnsemble(const Ensemble &ensemble,
+                                     const LeafType leaf_type)
+    : leaf_type_(leaf_type) {
+  std::vector<size_t> feature_position;
+  for (auto &f: distinct_thresholds(ensemble)) {
+    if (feature_position.size() <= f.first)
+      feature_position.resize(f.first + 1);
+    feature_position[f.first] = features_.size();
+    features_.push_back(f.first);
+    thresholds_.push_back(std::move(f.second));
+  }
+
+  const size_t ntrees = ensemble.get_size();
+  roots_.resize(ntrees);
+  tree_bytes_.resize(ntrees);
+  if (leaf_type_ == LeafType::INT16)
+    scales_.resize(ntrees);
+  std::vector<double> leaves;
+  for (size_t t = 0; t < ntrees; ++t) {
+    const size_t first_node = nodes_.size();
+    leaves.clear();
+    roots_[t] = add_subtree(ensemble.getTree(t), t, leaves,
+                            feature_position);
+
+    // the weight of the tree is folded into its leaves
+    for (auto &leaf: leaves)
+      leaf *= ensemble.getWeight(t);
+    if (leaf_type_ == LeafType::FLOAT32) {
+      for (auto leaf: leaves)
+        leaves32_.push_back((float) leaf);
+    } else {
+      double largest = 0.0;
+      for (auto leaf: leaves)
+        largest = std::max(largest, std::fabs(leaf));
+      const float scale = largest > 0.0 ? (float) (largest / 32767.0) : 1.0f;
+      scales_[t] = scale;
+      for (auto leaf: leaves) {
+        const long q = std::lround(leaf / scale);
+        leaves16_.push_back((int16_t) std::max(-32767L, std::min(32767L, q)));
+      }
+    }
+    tree_bytes_[t] = (nodes_.size() - first_node) * sizeof(Node)
+        + leaves.size() * (leaf_type_ == LeafType::FLOAT32 ? sizeof(float)
+                                                            : sizeof(int16_t));
+  }
+}
+
+int32_t QuantizedEnsemble::add_subtree(
+    RTNode const *node, const size_t t, std::vector<double> &leaves,
+    std::vector<size_t> const &feature_position) {
+  if (node->is_leaf()) {
+    // leaves of tree t follow the ones of the previous trees
+    const size_t first_leaf = leaf_type_ == LeafType::FLOAT32 ?
+                              leaves32_.size() : leaves16_.size();
+    leaves.push_back(node->avglabel);
+    return ~(int32_t) (first_leaf + leaves.size() - 1);
+  }
+  const size_t f = feature_position[node->get_feature_idx()];
+  const std::vector<float> &thresholds = thresholds_[f];
+  const size_t bin = std::lower_bound(thresholds.begin(), thresholds.end(),
+                                      node->threshold) - thresholds.begin();
+  const int32_t id = (int32_t) nodes_.size();
+  nodes_.push_back({(uint16_t) f, (uint16_t) bin, 0, 0});
+  const int32_t left = add_subtree(node->left, t, leaves, feature_position);
+  const int32_t right = add_subtree(node->right, t, leaves, feature_position);
+  nodes_[id].left = left;
+  nodes_[id].right = right;
+  return id;
+}
+
+void QuantizedEnsemble::check_num_features(const size_t nfeatures) const {
+  // features_ is sorted, the last one is the largest feature id
+  if (!features_.empty() && nfeatures <= features_.back()) {
+    std::cerr << "!!! The model uses " << features_.back() + 1
+              << " features but documents have only " << nfeatures
+              << "." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+void QuantizedEnsemble::bin_documents(const quickrank::Feature *d,
+                                      const size_t ninstances,
+                                      const size_t nfeatures,
+                                      uint16_t *bins) const {
+  check_num_features(nfeatures);
+  const size_t nmodel_features = features_.size();
+  for (size_t f = 0; f < nmodel_features; ++f) {
+    const std::vector<float> &thresholds = thresholds_[f];
+    for (size_t i = 0; i < ninstances; ++i) {
+      const quickrank::Feature x = d[i * nfeatures + features_[f]];
+      // NaN is larger than any threshold, as x <= threshold is false
+      bins[i * nmodel_features + f] = (uint16_t) (std::isnan(x) ?
+          thresholds.size() :
+          std::lower_bound(thresholds.begin(), thresholds.end(), x)
+              - thresholds.begin());
+    }
+  }
+}
+
+void QuantizedEnsemble::score(const quickrank::Feature *d,
+                              const size_t ninstances,
+                              const size_t nfeatures,
+                              quickrank::Score *scores) const {
+  check_num_features(nfeatures);
+  const std::vector<size_t> blocks = scoring_blocks::tree_blocks(tree_bytes_);
+  const size_t nblocks = blocks.size() - 1;
+  const size_t docs_per_block = scoring_blocks::documents_per_block(
+      ninstances, nfeatures, nblocks);
+  const size_t ndoc_blocks = (ninstances + docs_per_block - 1)
+      / docs_per_block;
+  const size_t nmodel_features = features_.size();
+
+  #pragma omp parallel
+  {
+    std::vector<uint16_t> bins(docs_per_block * nmodel_features);
+    #pragma omp for schedule(dynamic)
+    for (size_t db = 0; db < ndoc_blocks; ++db) {
+      const size_t begin = db * docs_per_block;
+      const size_t end = std::min(ninstances, begin + docs_per_block);
+      bin_documents(d + begin * nfeatures, end - begin, nfeatures,
+                    bins.data());
+      std::fill(scores + begin, scores + end, 0.0);
+      for (size_t b = 0; b < nblocks; ++b)
+        for (size_t i = begin; i < end; ++i)
+          for (size_t t = blocks[b]; t < blocks[b + 1]; ++t)
+            scores[i] += score_tree(
+                t, &bins[(i - begin) * nmodel_features]);
+    }
+  }
+}
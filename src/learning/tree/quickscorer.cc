@@ -0,0 +1,197 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/quickscorer.h"
+#include "learning/tree/scoring_blocks.h"
+
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
+
+namespace {
+
+size_t count_leaves(RTNode const *node) {
+  if (node->is_leaf())
+    return 1;
+  return count_leaves(node->left) + count_leaves(node->right);
+}
+
+}  // namespace
+
+struct QuickScorer::Node {
+  size_t block;
+  size_t featureidx;
+  float threshold;
+  uint32_t tree_id;
+  uint64_t bitvector;
+};
+
+bool QuickScorer::is_supported(const Ensemble &ensemble) {
+  for (size_t t = 0; t < ensemble.get_size(); ++t)
+    if (count_leaves(ensemble.getTree(t)) > MAX_LEAVES)
+      return false;
+  return true;
+}
+
+QuickScorer::QuickScorer(const Ensemble &ensemble, size_t trees_per_block) {
+  ntrees_ = ensemble.get_size();
+  leaf_offsets_.resize(ntrees_);
+  weights_.resize(ntrees_);
+
+  // blocks of trees
+  if (trees_per_block) {
+    for (size_t t = 0; t < ntrees_; t += trees_per_block)
+      block_trees_.push_back(t);
+    block_trees_.push_back(ntrees_);
+    if (block_trees_.size() == 1)
+      block_trees_.push_back(ntrees_);
+  } else {
+    // bytes of the nodes and of the leaves of each tree
+    std::vector<size_t> tree_bytes(ntrees_);
+    for (size_t t = 0; t < ntrees_; ++t) {
+      const size_t nleaves = count_leaves(ensemble.getTree(t));
+      tree_bytes[t] = (nleaves - 1) * (sizeof(float) + sizeof(uint32_t)
+          + sizeof(uint64_t)) + nleaves * sizeof(double);
+    }
+    block_trees_ = scoring_blocks::tree_blocks(tree_bytes);
+  }
+
+  std::vector<Node> nodes;
+  for (size_t b = 0; b < num_blocks(); ++b)
+    for (size_t t = block_trees_[b]; t < block_trees_[b + 1]; ++t) {
+      leaf_offsets_[t] = leaf_values_.size();
+      weights_[t] = ensemble.getWeight(t);
+      const size_t first = nodes.size();
+      add_subtree(ensemble.getTree(t), (uint32_t) (t - block_trees_[b]), 0,
+                  nodes);
+      for (size_t i = first; i < nodes.size(); ++i)
+        nodes[i].block = b;
+    }
+
+  // group the nodes of every block by feature, by increasing threshold
+  std::stable_sort(nodes.begin(), nodes.end(),
+                   [](const Node &a, const Node &b) {
+                     if (a.block != b.block)
+                       return a.block < b.block;
+                     if (a.featureidx != b.featureidx)
+                       return a.featureidx < b.featureidx;
+                     return a.threshold < b.threshold;
+                   });
+
+  for (const Node &node: nodes)
+    nmodel_features_ = std::max(nmodel_features_, node.featureidx + 1);
+  const size_t stride = nmodel_features_ + 1;
+  feature_offsets_.assign(num_blocks() * stride, 0);
+  thresholds_.resize(nodes.size());
+  tree_ids_.resize(nodes.size());
+  bitvectors_.resize(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    ++feature_offsets_[nodes[i].block * stride + nodes[i].featureidx + 1];
+    thresholds_[i] = nodes[i].threshold;
+    tree_ids_[i] = nodes[i].tree_id;
+    bitvectors_[i] = nodes[i].bitvector;
+  }
+  // offsets of a block start where the previous block ends
+  size_t offset = 0;
+  for (size_t b = 0; b < num_blocks(); ++b) {
+    feature_offsets_[b * stride] = offset;
+    for (size_t f = 0; f < nmodel_features_; ++f)
+      feature_offsets_[b * stride + f + 1] += feature_offsets_[b * stride + f];
+    offset = feature_offsets_[b * stride + nmodel_features_];
+  }
+}
+
+size_t QuickScorer::add_subtree(RTNode const *node, const uint32_t tree_id,
+                                size_t nleaves, std::vector<Node> &nodes) {
+  if (node->is_leaf()) {
+    leaf_values_.push_back(node->avglabel);
+    return 1;
+  }
+  const size_t nleft = add_subtree(node->left, tree_id, nleaves, nodes);
+  const size_t nright = add_subtree(node->right, tree_id, nleaves + nleft,
+                                    nodes);
+  // a false test, i.e., !(value <= threshold) as for NaN, excludes the left
+  // subtree
+  const uint64_t left_leaves = ((UINT64_C(1) << nleft) - 1) << nleaves;
+  nodes.push_back({0, node->get_feature_idx(), node->threshold, tree_id,
+                   ~left_leaves});
+  return nleft + nright;
+}
+
+void QuickScorer::score_block(const size_t b, const quickrank::Feature *d,
+                              const size_t nfeatures, uint64_t *leafidx,
+                              quickrank::Score &score) const {
+  const size_t tree_begin = block_trees_[b];
+  const size_t ntrees = block_trees_[b + 1] - tree_begin;
+  std::fill(leafidx, leafidx + ntrees, ~UINT64_C(0));
+
+  const size_t *offsets = &feature_offsets_[b * (nmodel_features_ + 1)];
+  for (size_t f = 0; f < nmodel_features_; ++f) {
+    const quickrank::Feature x = f < nfeatures ? d[f] : 0.0f;
+    const size_t end = offsets[f + 1];
+    for (size_t i = offsets[f]; i < end && !(x <= thresholds_[i]); ++i)
+      leafidx[tree_ids_[i]] &= bitvectors_[i];
+  }
+
+  const size_t *leaf_offsets = &leaf_offsets_[tree_begin];
+  const double *weights = &weights_[tree_begin];
+  for (size_t t = 0; t < ntrees; ++t)
+    score += leaf_values_[leaf_offsets[t] + __builtin_ctzll(leafidx[t])]
+        * weights[t];
+}
+
+quickrank::Score QuickScorer::score_instance(const quickrank::Feature *d,
+                                             const size_t nfeatures,
+                                             uint64_t *leafidx) const {
+  double score = 0.0;
+  for (size_t b = 0; b < num_blocks(); ++b)
+    score_block(b, d, nfeatures, leafidx, score);
+  return score;
+}
+
+void QuickScorer::score(const quickrank::Feature *d,
+                        const size_t ninstances,
+                        const size_t nfeatures,
+                        quickrank::Score *scores) const {
+  const size_t docs_per_block = scoring_blocks::documents_per_block(
+      ninstances, nfeatures, num_blocks());
+  const size_t ndoc_blocks = (ninstances + docs_per_block - 1)
+      / docs_per_block;
+
+  #pragma omp parallel
+  {
+    std::vector<uint64_t> leafidx(ntrees_);
+    #pragma omp for schedule(dynamic)
+    for (size_t db = 0; db < ndoc_blocks; ++db) {
+      const size_t begin = db * docs_per_block;
+      const size_t end = std::min(ninstances, begin + docs_per_block);
+      std::fill(scores + begin, scores + end, 0.0);
+      for (size_t b = 0; b < num_blocks(); ++b)
+        for (size_t i = begin; i < end; ++i)
+          score_block(b, d + i * nfeatures, nfeatures, leafidx.data(),
+                      scores[i]);
+    }
+  }
+}
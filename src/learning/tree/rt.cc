@@ -20,6 +20,10 @@
  *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
  */
 #include "learning/tree/rt.h"
+#include "learning/tree/split_search.h"
+
+#include <algorithm>
+#include <iostream>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -31,30 +35,133 @@
 #include "utils/omp-stubs.h"
 #endif
 
+namespace {
+
+/// Best split of a feature of a node.
+struct FeatureSplit {
+  double score;
+  size_t thresholdid;
+};
+
+/// Minimum number of samples of a block partitioned by a thread.
+const size_t PARTITION_BLOCK_SIZE = 16384;
+
+}  // namespace
+
+const std::vector<std::string> RegressionTree::growthPolicyNames = {
+    "BEST_FIRST", "LEVEL_WISE"
+};
+
+RegressionTree::GrowthPolicy RegressionTree::get_growth_policy(
+    std::string name) {
+  auto i_item = std::find(growthPolicyNames.cbegin(),
+                          growthPolicyNames.cend(),
+                          name);
+  if (i_item == growthPolicyNames.cend()) {
+    std::cerr << "!!! Growth policy " << name << " is not valid."
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return GrowthPolicy(std::distance(growthPolicyNames.cbegin(), i_item));
+}
+
 /// \todo TODO: memory management of regression tree is wrong!!!
 RegressionTree::~RegressionTree() {
-  // if leaves[0] is the root, hist cannot be deallocated and sampleids has
-  // been already deallocated
+  // if leaves[0] is the root, hist cannot be deallocated
   for (size_t i = 0; i < nleaves; ++i)
     if (leaves[i] != root) {
-      delete[] leaves[i]->sampleids;
       delete leaves[i]->hist;
       leaves[i]->hist = NULL;
-      leaves[i]->sampleids = NULL;
-      leaves[i]->nsampleids = 0;
     }
   free(leaves);
+  delete[] sampleids_;
+  delete[] partition_buffer_;
+}
+
+void RegressionTree::init_samples(size_t const *sampleids,
+                                  const size_t nsampleids) {
+  delete[] sampleids_;
+  delete[] partition_buffer_;
+  sampleids_ = new size_t[nsampleids];
+  partition_buffer_ = new size_t[nsampleids];
+  std::copy(sampleids, sampleids + nsampleids, sampleids_);
+}
+
+size_t RegressionTree::partition(const size_t begin, const size_t end,
+                                 FeatureBins const *bins,
+                                 const size_t featureidx,
+                                 const size_t thresholdid) {
+  const size_t nsamples = end - begin;
+  const size_t nblocks = std::max<size_t>(
+      1, std::min<size_t>(omp_get_max_threads(),
+                          nsamples / PARTITION_BLOCK_SIZE));
+  const size_t block_size = (nsamples + nblocks - 1) / nblocks;
+  std::vector<size_t> lcounts(nblocks);
+
+  // partition every block in the scratch buffer: lefts are copied there
+  // directly, while rights are first packed at the beginning of the block
+  #pragma omp parallel for if(nblocks > 1)
+  for (size_t b = 0; b < nblocks; ++b) {
+    const size_t bbegin = begin + b * block_size;
+    const size_t bend = std::min(end, bbegin + block_size);
+    size_t lsize = 0, rsize = 0;
+    // a sample goes left iff its bin is not after the threshold one
+    for (size_t i = bbegin; i < bend; ++i) {
+      const size_t s = sampleids_[i];
+      if (bins->get(featureidx, s) <= thresholdid)
+        partition_buffer_[bbegin + lsize++] = s;
+      else
+        sampleids_[bbegin + rsize++] = s;
+    }
+    std::copy(sampleids_ + bbegin, sampleids_ + bbegin + rsize,
+              partition_buffer_ + bbegin + lsize);
+    lcounts[b] = lsize;
+  }
+
+  // move every block at its final offset, preserving the order of samples
+  std::vector<size_t> loffsets(nblocks), roffsets(nblocks);
+  size_t lend = begin;
+  for (size_t b = 0; b < nblocks; ++b) {
+    loffsets[b] = lend;
+    lend += lcounts[b];
+  }
+  size_t rend = lend;
+  for (size_t b = 0; b < nblocks; ++b) {
+    const size_t bbegin = begin + b * block_size;
+    const size_t bend = std::min(end, bbegin + block_size);
+    roffsets[b] = rend;
+    rend += bend - bbegin - lcounts[b];
+  }
+
+  #pragma omp parallel for if(nblocks > 1)
+  for (size_t b = 0; b < nblocks; ++b) {
+    const size_t bbegin = begin + b * block_size;
+    const size_t bend = std::min(end, bbegin + block_size);
+    size_t const *lefts = partition_buffer_ + bbegin;
+    size_t const *rights = lefts + lcounts[b];
+    size_t const *rights_end = partition_buffer_ + bend;
+    std::copy(lefts, rights, sampleids_ + loffsets[b]);
+    std::copy(rights, rights_end, sampleids_ + roffsets[b]);
+  }
+  return lend;
 }
 
 void RegressionTree::fit(RTNodeHistogram *hist,
                          size_t *sampleids,
                          float max_features) {
+  if (growth_policy == GrowthPolicy::LEVEL_WISE) {
+    fit_levelwise(hist, sampleids, max_features);
+    return;
+  }
+
   rt_maxheap heap(nrequiredleaves);
   size_t taken = 0;
   size_t n_nodes = 1; // root
   double max_deviance = 0.0;
 
-  root = new RTNode(sampleids, hist);
+  const size_t nsampleids = hist->count[0][hist->thresholds_size[0] - 1];
+  init_samples(sampleids, nsampleids);
+  root = new RTNode(0, nsampleids, hist);
   if (split(root, max_features, false)) {
     heap.push(root->left->deviance, root->left);
     heap.push(root->right->deviance, root->right);
@@ -82,11 +189,6 @@ void RegressionTree::fit(RTNodeHistogram *hist,
     // Clear node histogram
     delete node->hist;
     node->hist = NULL;
-
-    if (!collapse_leaves_factor && node != root && !node->is_leaf()) {
-      delete[] node->sampleids;
-      node->sampleids = NULL;
-    }
   }
 
   size_t n_leaves = nrequiredleaves;
@@ -110,16 +212,15 @@ void RegressionTree::fit(RTNodeHistogram *hist,
         if (n_nodes > max_n_nodes * collapse_leaves_factor)
           break;
 
-        // lets the parent become a leaf node (and delete the two children)
+        // lets the parent become a leaf node (and delete the two children),
+        // whose samples are the union of the ones of the children
         if (enriched_node->parent->left->hist != NULL)
           delete enriched_node->parent->left->hist;
-        delete[] enriched_node->parent->left->sampleids;
         delete enriched_node->parent->left;
         enriched_node->parent->left = NULL;
 
         if (enriched_node->parent->right->hist != NULL)
           delete enriched_node->parent->right->hist;
-        delete[] enriched_node->parent->right->sampleids;
         delete enriched_node->parent->right;
         enriched_node->parent->right = NULL;
 
@@ -137,15 +238,6 @@ void RegressionTree::fit(RTNodeHistogram *hist,
     // Still need to clear all remaining EnrichedNode(s)
     while (heap_nodes.is_notempty()) {
       RTNodeEnriched* enriched_node = heap_nodes.top();
-
-      if (enriched_node->node != root && !enriched_node->node->is_leaf()) {
-        // Free useless resources in RTNode
-        if (enriched_node->node->sampleids != NULL)
-          delete[] enriched_node->node->sampleids;
-        enriched_node->node->sampleids = NULL;
-        enriched_node->node->nsampleids = 0;
-      }
-
       delete enriched_node;
       heap_nodes.pop();
     }
@@ -167,8 +259,8 @@ double RegressionTree::update_output(double const *pseudoresponses) {
   #pragma omp parallel for reduction(max:maxlabel)
   for (size_t i = 0; i < nleaves; ++i) {
     double psum = 0.0f;
-    const size_t nsampleids = leaves[i]->nsampleids;
-    const size_t *sampleids = leaves[i]->sampleids;
+    const size_t nsampleids = leaves[i]->nsamples();
+    const size_t *sampleids = sampleids_ + leaves[i]->sample_begin;
     for (size_t j = 0; j < nsampleids; ++j) {
       size_t k = sampleids[j];
       psum += pseudoresponses[k];
@@ -190,8 +282,8 @@ double RegressionTree::update_output(double const *pseudoresponses,
   for (size_t i = 0; i < nleaves; ++i) {
     double s1 = 0.0;
     double s2 = 0.0;
-    const size_t nsampleids = leaves[i]->nsampleids;
-    const size_t *sampleids = leaves[i]->sampleids;
+    const size_t nsampleids = leaves[i]->nsamples();
+    const size_t *sampleids = sampleids_ + leaves[i]->sample_begin;
     for (size_t j = 0; j < nsampleids; ++j) {
       size_t k = sampleids[j];
       s1 += pseudoresponses[k];
@@ -206,53 +298,235 @@ double RegressionTree::update_output(double const *pseudoresponses,
   return maxlabel;
 }
 
-bool RegressionTree::split(RTNode *node, const float max_features,
-                           const bool require_devianceltparent) {
+size_t *RegressionTree::sample_features(const float max_features,
+                                        size_t &nfeaturesamples) {
+  nfeaturesamples = training_dataset->num_features();
+  size_t *featuresamples = NULL; // NULL means it will use all the features
 
-  if (node->deviance > 0.0f) {
-    const double initvar = -1;  // minimum split score
-    // get current node histogram pointer
-    RTNodeHistogram *h = node->hist;
+  //need to make a sub-sampling
+  if (max_features != 1.0f) {
 
-    // feature idx to be used for tree split node
-    size_t nfeaturesamples = training_dataset->num_features();
-    size_t *featuresamples = NULL; // NULL means it will use all the features
+    size_t nfeatures = training_dataset->num_features();
+
+    if (max_features > 1.0f) {
+      // >1: Max feature is the number of features to use
+      nfeaturesamples = (size_t) max_features;
+    } else {
+      // <1: Max feature is the fraction of features to use
+      nfeaturesamples = (size_t) std::ceil(max_features * nfeatures);
+    }
+
+    featuresamples = new size_t[nfeatures];
+    #pragma omp parallel for
+    for (size_t i = 0; i < nfeatures; ++i)
+      featuresamples[i] = i;
+
+    // shuffle the sample idx
+    auto seed = std::chrono::system_clock::now().time_since_epoch().count();
+    auto rng = std::default_random_engine(seed);
+    std::shuffle(&featuresamples[0], &featuresamples[nfeatures], rng);
+  }
+  return featuresamples;
+}
 
-    //need to make a sub-sampling
-    if (max_features != 1.0f) {
+void RegressionTree::fit_levelwise(RTNodeHistogram *hist,
+                                   size_t *sampleids,
+                                   float max_features) {
+  const double initvar = -1;  // minimum split score
+  const split_search::Kernel best_split = split_search::best_kernel();
+
+  const size_t nsampleids = hist->count[0][hist->thresholds_size[0] - 1];
+  init_samples(sampleids, nsampleids);
+  root = new RTNode(0, nsampleids, hist);
+  size_t n_leaves = 1;
+  std::vector<RTNode *> frontier(1, root);
+
+  for (size_t depth = 0;
+       !frontier.empty() && (max_depth == 0 || depth < max_depth); ++depth) {
+    const size_t nnodes = frontier.size();
+
+    // features to be used by each node
+    std::vector<size_t *> featuresamples(nnodes, NULL);
+    std::vector<size_t> nfeaturesamples(nnodes, 0);
+    size_t max_nfeaturesamples = 0;
+    for (size_t n = 0; n < nnodes; ++n) {
+      featuresamples[n] = sample_features(max_features, nfeaturesamples[n]);
+      max_nfeaturesamples = std::max(max_nfeaturesamples, nfeaturesamples[n]);
+    }
 
-      size_t nfeatures = training_dataset->num_features();
+    // ---------------------------
+    // find the best split of every feature of every node in one sweep
+    std::vector<FeatureSplit> feature_best(nnodes * max_nfeaturesamples);
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t p = 0; p < nnodes * max_nfeaturesamples; ++p) {
+      const size_t n = p / max_nfeaturesamples;
+      const size_t i = p % max_nfeaturesamples;
+      FeatureSplit &best = feature_best[p];
+      best.score = initvar;
+      best.thresholdid = uint_max;
+      if (frontier[n]->deviance > 0.0f && i < nfeaturesamples[n]) {
+        const size_t f = featuresamples[n] ? featuresamples[n][i] : i;
+        RTNodeHistogram const *h = frontier[n]->hist;
+        best.thresholdid = best_split(h->sumlbl[f], h->count[f],
+                                      h->thresholds_size[f], minls,
+                                      best.score);
+      }
+    }
 
-      if (max_features > 1.0f) {
-        // >1: Max feature is the number of features to use
-        nfeaturesamples = (size_t) max_features;
-      } else {
-        // <1: Max feature is the fraction of features to use
-        nfeaturesamples = (size_t) std::ceil(max_features * nfeatures);
+    // best split of each node: ties go to the first sampled feature, as in
+    // the best-first growth
+    std::vector<size_t> best_featureidx(nnodes, uint_max);
+    std::vector<size_t> best_thresholdid(nnodes, uint_max);
+    std::vector<size_t> candidates;
+    for (size_t n = 0; n < nnodes; ++n) {
+      double best_score = initvar;
+      for (size_t i = 0; i < nfeaturesamples[n]; ++i) {
+        const FeatureSplit &best = feature_best[n * max_nfeaturesamples + i];
+        if (best.thresholdid != uint_max && best.score > best_score) {
+          best_score = best.score;
+          best_featureidx[n] = featuresamples[n] ? featuresamples[n][i] : i;
+          best_thresholdid[n] = best.thresholdid;
+        }
       }
+      delete[] featuresamples[n];
+      if (best_score != initvar)
+        candidates.push_back(n);
+    }
 
-      featuresamples = new size_t[nfeatures];
-      #pragma omp parallel for
-      for (size_t i = 0; i < nfeatures; ++i)
-        featuresamples[i] = i;
+    // when leaves are limited, split the nodes with the largest deviance
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [&frontier](size_t a, size_t b) {
+                       return frontier[a]->deviance > frontier[b]->deviance;
+                     });
+    if (nrequiredleaves && n_leaves + candidates.size() > nrequiredleaves)
+      candidates.resize(nrequiredleaves - n_leaves);
+    const size_t nsplits = candidates.size();
+    n_leaves += nsplits;
+
+    // children of the last level are leaves and do not need histograms
+    const bool last_level = (max_depth && depth + 1 == max_depth)
+        || (nrequiredleaves && n_leaves == nrequiredleaves);
+
+    //split the samples of every node between its left and right child:
+    //nodes are partitioned in parallel when they are enough to keep every
+    //thread busy, otherwise every node is partitioned by all the threads
+    std::vector<size_t> lends(nsplits);
+    #pragma omp parallel for schedule(dynamic) \
+        if(nsplits >= (size_t) omp_get_max_threads())
+    for (size_t c = 0; c < nsplits; ++c) {
+      RTNode *node = frontier[candidates[c]];
+      const size_t f = best_featureidx[candidates[c]];
+      const size_t threshold = best_thresholdid[candidates[c]];
+      RTNodeHistogram const *h = node->hist;
+      lends[c] = partition(node->sample_begin, node->sample_end, h->bins, f,
+                           threshold);
+
+      node->set_feature(f, f + 1);
+      node->threshold = h->thresholds[f][threshold];
+    }
 
-      // shuffle the sample idx
-      auto seed = std::chrono::system_clock::now().time_since_epoch().count();
-      auto rng = std::default_random_engine(seed);
-      std::shuffle(&featuresamples[0], &featuresamples[nfeatures], rng);
+    std::vector<RTNode *> next_frontier;
+    if (last_level) {
+      for (size_t c = 0; c < nsplits; ++c) {
+        RTNode *node = frontier[candidates[c]];
+        const size_t f = best_featureidx[candidates[c]];
+        RTNodeHistogram const *h = node->hist;
+        const double lsum = h->sumlbl[f][best_thresholdid[candidates[c]]];
+        const double rsum = h->sumlbl[f][h->thresholds_size[f] - 1] - lsum;
+        const size_t lsize = lends[c] - node->sample_begin;
+        const size_t rsize = node->sample_end - lends[c];
+        node->left = new RTNode(node->sample_begin, lends[c], lsum / lsize);
+        node->right = new RTNode(lends[c], node->sample_end, rsum / rsize);
+      }
+    } else {
+      //build the histograms of the smaller children in one pass, and get
+      //the ones of the larger children by subtraction
+      std::vector<RTNodeHistogram const *> parents(nsplits);
+      std::vector<size_t const *> small_samples(nsplits);
+      std::vector<size_t> small_sizes(nsplits);
+      std::vector<bool> left_smaller(nsplits);
+      for (size_t c = 0; c < nsplits; ++c) {
+        RTNode const *node = frontier[candidates[c]];
+        const size_t lsize = lends[c] - node->sample_begin;
+        const size_t rsize = node->sample_end - lends[c];
+        left_smaller[c] = lsize <= rsize;
+        parents[c] = node->hist;
+        small_samples[c] = sampleids_
+            + (left_smaller[c] ? node->sample_begin : lends[c]);
+        small_sizes[c] = left_smaller[c] ? lsize : rsize;
+      }
+      std::vector<RTNodeHistogram *> small_hists = RTNodeHistogram::build(
+          parents, small_samples, small_sizes, training_labels);
+
+      for (size_t c = 0; c < nsplits; ++c) {
+        RTNode *node = frontier[candidates[c]];
+        RTNodeHistogram *large_hist = NULL;
+        if (node == root)
+          large_hist = new RTNodeHistogram(node->hist, small_hists[c]);
+        else {
+          node->hist->transform_intochild(small_hists[c]);
+          large_hist = node->hist;
+          node->hist = NULL;
+        }
+        node->left = new RTNode(node->sample_begin, lends[c],
+                                left_smaller[c] ? small_hists[c] : large_hist);
+        node->right = new RTNode(lends[c], node->sample_end,
+                                 left_smaller[c] ? large_hist : small_hists[c]);
+        next_frontier.push_back(node->left);
+        next_frontier.push_back(node->right);
+      }
+    }
+
+    // histograms of the current level are no longer needed
+    for (RTNode *node: frontier) {
+      if (node == root)
+        continue;
+      delete node->hist;
+      node->hist = NULL;
+    }
+    frontier.swap(next_frontier);
+  }
+
+  // the last frontier is made of leaves
+  for (RTNode *node: frontier) {
+    if (node != root) {
+      delete node->hist;
+      node->hist = NULL;
     }
+  }
+
+  //visit tree and save leaves in a leaves[] array
+  size_t capacity = n_leaves;
+  leaves = (RTNode **) malloc(sizeof(RTNode *) * capacity);
+  nleaves = 0;
+  root->save_leaves(leaves, nleaves, capacity);
+}
+
+bool RegressionTree::split(RTNode *node, const float max_features,
+                           const bool require_devianceltparent) {
+
+  if (node->deviance > 0.0f) {
+    const double initvar = -1;  // minimum split score
+    // get current node histogram pointer
+    RTNodeHistogram *h = node->hist;
+
+    // feature idx to be used for tree split node
+    size_t nfeaturesamples;
+    // NULL means it will use all the features
+    size_t *featuresamples = sample_features(max_features, nfeaturesamples);
 
     // ---------------------------
     // find best split
-    const int nth = omp_get_num_procs();
-    double *thread_best_score = new double[nth];
-    size_t *thread_best_featureidx = new size_t[nth];
-    size_t *thread_best_thresholdid = new size_t[nth];
-    for (int i = 0; i < nth; ++i) {
-      thread_best_score[i] = initvar;
-      thread_best_featureidx[i] = uint_max;
-      thread_best_thresholdid[i] = uint_max;
-    }
+    const int nth = omp_get_max_threads();
+    split_search::ThreadBestSplit *thread_best =
+        thread_best_->reset(nth, initvar);
+
+    // NOTE by cla: to compute the correct squared error reduction
+    // the split score should be decreases by ( s*s/(double) c ).
+    // Since this is invariant within the same node, and since
+    // score is not user later, e.g., to select next splitting node,
+    // we avoid such computation.
+    const split_search::Kernel best_split = split_search::best_kernel();
 
     #pragma omp parallel for
     for (size_t i = 0; i < nfeaturesamples; ++i) {
@@ -260,91 +534,63 @@ bool RegressionTree::split(RTNode *node, const float max_features,
       const size_t f = featuresamples ? featuresamples[i] : i;
       //get thread identification number
       const int ith = omp_get_thread_num();
-      //define pointer shortcuts
-      double *sumlabels = h->sumlbl[f];
-      size_t *samplecount = h->count[f];
-      //get last elements
-      size_t threshold_size = h->thresholds_size[f];
-      double s = sumlabels[threshold_size - 1];
-      size_t c = samplecount[threshold_size - 1];
+      split_search::ThreadBestSplit &best = thread_best[ith];
 
       //looking for the feature that minimizes sumvar
-      for (size_t t = 0; t < threshold_size; ++t) {
-        size_t lcount = samplecount[t];
-        size_t rcount = c - lcount;
-        if (lcount >= minls && rcount >= minls) {
-          double lsum = sumlabels[t];
-          double rsum = s - lsum;
-          double score = lsum * lsum / (double) lcount
-                       + rsum * rsum / (double) rcount;
-          // NOTE by cla: to compute the correct squared error reduction
-          // the variable score should be decreases by ( s*s/(double) c ).
-          // Since this is invariant within the same node, and since
-          // score is not user later, e.g., to select next splitting node,
-          // we avoid such computation.
-          if (score > thread_best_score[ith]) {
-            thread_best_score[ith] = score;
-            thread_best_featureidx[ith] = f;
-            thread_best_thresholdid[ith] = t;
-          }
-        }
+      const size_t t = best_split(h->sumlbl[f], h->count[f],
+                                  h->thresholds_size[f], minls, best.score);
+      if (t != uint_max) {
+        best.featureidx = f;
+        best.thresholdid = t;
       }
     }
 
     //free feature samples
     delete[] featuresamples;
     //get best minvar among thread partial results
-    double best_score = thread_best_score[0];
-    size_t best_featureidx = thread_best_featureidx[0];
-    size_t best_thresholdid = thread_best_thresholdid[0];
+    double best_score = thread_best[0].score;
+    size_t best_featureidx = thread_best[0].featureidx;
+    size_t best_thresholdid = thread_best[0].thresholdid;
     for (int i = 1; i < nth; ++i) {
-      if (thread_best_score[i] > best_score) {
-        best_score = thread_best_score[i];
-        best_featureidx = thread_best_featureidx[i];
-        best_thresholdid = thread_best_thresholdid[i];
+      if (thread_best[i].score > best_score) {
+        best_score = thread_best[i].score;
+        best_featureidx = thread_best[i].featureidx;
+        best_thresholdid = thread_best[i].thresholdid;
       }
     }
-    // free some memory
-    delete[] thread_best_score;
-    delete[] thread_best_featureidx;
-    delete[] thread_best_thresholdid;
     //if minvar is the same of initvalue then the node is unsplitable
     if (best_score == initvar)
       return false;
 
     //set some result values related to minvar
-    const size_t last_thresholdidx = h->thresholds_size[best_featureidx] - 1;
     const float best_threshold =
         h->thresholds[best_featureidx][best_thresholdid];
 
-    const size_t count = h->count[best_featureidx][last_thresholdidx];
-    const size_t lcount = h->count[best_featureidx][best_thresholdid];
-    const size_t rcount = count - lcount;
-
     //split samples between left and right child
-    size_t *lsamples = new size_t[lcount], lsize = 0;
-    size_t *rsamples = new size_t[rcount], rsize = 0;
-    float const *features = training_dataset->at(0, best_featureidx);
-    for (size_t i = 0; i < node->nsampleids; ++i) {
-      size_t s = node->sampleids[i];
-      if (features[s] <= best_threshold)
-        lsamples[lsize++] = s;
-      else
-        rsamples[rsize++] = s;
-    }
-
-    //create histograms for children
-    RTNodeHistogram *lhist = new RTNodeHistogram(node->hist, lsamples, lsize,
-                                                 training_labels);
-    RTNodeHistogram *rhist = NULL;
+    const size_t lend = partition(node->sample_begin, node->sample_end,
+                                  h->bins, best_featureidx, best_thresholdid);
+    const size_t lsize = lend - node->sample_begin;
+    const size_t rsize = node->sample_end - lend;
+
+    //create histograms for children: only the smaller child is scanned,
+    //the histogram of the larger one is obtained by subtraction
+    const bool left_smaller = lsize <= rsize;
+    RTNodeHistogram *small_hist = left_smaller
+        ? new RTNodeHistogram(node->hist, sampleids_ + node->sample_begin,
+                              lsize, training_labels)
+        : new RTNodeHistogram(node->hist, sampleids_ + lend, rsize,
+                              training_labels);
+    RTNodeHistogram *large_hist = NULL;
     if (node == root)
-      rhist = new RTNodeHistogram(node->hist, lhist);
+      large_hist = new RTNodeHistogram(node->hist, small_hist);
     else {
-      //save some new/delete by converting parent histogram into the right-child one
-      node->hist->transform_intorightchild(lhist);
-      rhist = node->hist;
+      //save some new/delete by converting parent histogram into the larger-child one
+      node->hist->transform_intochild(small_hist);
+      large_hist = node->hist;
       node->hist = NULL; // Used to avoid deleting it!
     }
+    RTNodeHistogram *lhist = left_smaller ? small_hist : large_hist;
+    RTNodeHistogram *rhist = left_smaller ? large_hist : small_hist;
 
     //update current node
     node->set_feature(
@@ -353,8 +599,8 @@ bool RegressionTree::split(RTNode *node, const float max_features,
     node->threshold = best_threshold;
 
     //create children
-    node->left = new RTNode(lsamples, lhist);
-    node->right = new RTNode(rsamples, rhist);
+    node->left = new RTNode(node->sample_begin, lend, lhist);
+    node->right = new RTNode(lend, node->sample_end, rhist);
 
     return true;
   }
@@ -21,21 +21,141 @@
  */
 #include "learning/tree/rtnode_histogram.h"
 
+#include <algorithm>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
+
+namespace {
+
+/// Number of samples each thread accumulates for all the features before
+/// moving to the next block, so that ids and labels stay in cache.
+const size_t SAMPLE_BLOCK_SIZE = 4096;
+
+/// Row blocks are used only when there are less than this many features per
+/// thread, i.e., when the feature-parallel loop cannot balance the load.
+const size_t MIN_FEATURES_PER_THREAD = 4;
+
+/// Row blocks are used only when the scan is at least this many times more
+/// expensive than zeroing and merging the per-thread histograms.
+const size_t MIN_SCAN_TO_MERGE_RATIO = 4;
+
+/// Accumulates the labels and the counts of the given samples in the
+/// bins of a feature.
+struct BinAccumulator {
+  size_t const *sampleids;
+  const size_t nsampleids;
+  double const *labels;
+  double *sumlbl;
+  size_t *count;
+
+  template<typename BinT>
+  void operator()(const BinT *bins) {
+    for (size_t i = 0; i < nsampleids; ++i) {
+      const size_t s = sampleids[i];
+      const BinT t = bins[s];
+      sumlbl[t] += labels[s];
+      count[t]++;
+    }
+  }
+};
+
+/// Accumulates the labels of all the documents in the bins of a feature.
+struct LabelAccumulator {
+  double const *labels;
+  const size_t nlabels;
+  double *sumlbl;
+
+  template<typename BinT>
+  void operator()(const BinT *bins) {
+    for (size_t i = 0; i < nlabels; ++i)
+      sumlbl[bins[i]] += labels[i];
+  }
+};
+
+/// Accumulates the labels and the counts of the documents stored in the
+/// sparse bins of a feature, in the histograms of the nodes given by their
+/// sample slot. Documents out of every node are skipped.
+struct SparseBinAccumulator {
+  uint32_t const *documents;
+  const size_t nentries;
+  uint32_t const *slots;
+  double const *labels;
+  double *const *sumlbl;  // of every node
+  size_t *const *count;  // of every node
+
+  template<typename BinT>
+  void operator()(const BinT *bins) {
+    for (size_t k = 0; k < nentries; ++k) {
+      const uint32_t slot = slots[documents[k]];
+      if (slot != FeatureBins::NO_SLOT) {
+        sumlbl[slot][bins[k]] += labels[documents[k]];
+        count[slot][bins[k]]++;
+      }
+    }
+  }
+};
+
+/// Accumulates the labels of the documents stored in the sparse bins of a
+/// feature.
+struct SparseLabelAccumulator {
+  uint32_t const *documents;
+  const size_t nentries;
+  double const *labels;
+  double *sumlbl;
+
+  template<typename BinT>
+  void operator()(const BinT *bins) {
+    for (size_t k = 0; k < nentries; ++k)
+      sumlbl[bins[k]] += labels[documents[k]];
+  }
+};
+
+/// Puts in the default bin of a sparse feature the labels and the count of
+/// the documents not found in the other bins, given the totals of the node.
+inline void fill_default_bin(double *sumlbl, size_t *count,
+                             const size_t nthresholds, const size_t default_bin,
+                             const double node_sumlbl,
+                             const size_t node_count) {
+  double stored_sumlbl = 0.0;
+  size_t stored_count = 0;
+  for (size_t t = 0; t < nthresholds; ++t) {
+    stored_sumlbl += sumlbl[t];
+    stored_count += count[t];
+  }
+  sumlbl[default_bin] = node_sumlbl - stored_sumlbl;
+  count[default_bin] = node_count - stored_count;
+}
+
+/// Returns the first bin whose threshold is not smaller than \a value.
+/// Values larger than any threshold fall in the last bin.
+inline size_t find_bin(const float *threshold, const float *threshold_end,
+                       const float value) {
+  const float *it = std::lower_bound(threshold, threshold_end, value);
+  return it != threshold_end ? it - threshold : threshold_end - threshold - 1;
+}
+
+}  // namespace
+
 RTNodeHistogram::RTNodeHistogram(float **thresholds,
                                  size_t *thresholds_size,
-                                 size_t nfeatures)
+                                 size_t nfeatures,
+                                 std::shared_ptr<HistogramPool> shared_pool)
     : thresholds(thresholds),
       thresholds_size(thresholds_size),
       nfeatures(nfeatures),
-      squares_sum_(0.0) {
-
-  sumlbl = new double *[nfeatures];
-  count = new size_t *[nfeatures];
-  for (size_t i = 0; i < nfeatures; ++i) {
-    const size_t threshold_size = thresholds_size[i];
-    sumlbl[i] = new double[threshold_size]();
-    count[i] = new size_t[threshold_size]();
-  }
+      squares_sum_(0.0),
+      pool(shared_pool ? shared_pool
+                       : std::make_shared<HistogramPool>(nfeatures,
+                                                         thresholds_size)) {
+  block = pool->acquire();
+  pool->clear(block);
+  sumlbl = block->sumlbl;
+  count = block->count;
 }
 
 RTNodeHistogram::RTNodeHistogram(RTNodeHistogram const *parent,
@@ -44,50 +164,39 @@ RTNodeHistogram::RTNodeHistogram(RTNodeHistogram const *parent,
                                  double const *labels)
     : RTNodeHistogram(parent->thresholds,
                       parent->thresholds_size,
-                      parent->nfeatures) {
-
-  stmap = parent->stmap;
-
-  #pragma omp parallel for
-  for (size_t f = 0; f < nfeatures; ++f) {
-    for (size_t i = 0; i < nsampleids; ++i) {
-      const size_t s = sampleids[i];
-      const size_t t = stmap[f][s];
-      sumlbl[f][t] += labels[s];
-      count[f][t]++;
-    }
-    for (size_t t = 1; t < thresholds_size[f]; ++t) {
-      sumlbl[f][t] += sumlbl[f][t - 1];
-      count[f][t] += count[f][t - 1];
-    }
-  }
+                      parent->nfeatures,
+                      parent->pool) {
 
-  squares_sum_ = 0.0;
-  for (size_t i = 0; i < nsampleids; ++i) {
-    const size_t s = sampleids[i];
-    squares_sum_ += labels[s] * labels[s];
-  }
+  bins = parent->bins;
+  accumulate(sampleids, nsampleids, labels);
 }
 
 RTNodeHistogram::RTNodeHistogram(RTNodeHistogram const *parent,
-                                 RTNodeHistogram const *left)
+                                 RTNodeHistogram const *sibling)
     : RTNodeHistogram(parent->thresholds,
                       parent->thresholds_size,
-                      parent->nfeatures) {
-  stmap = parent->stmap;
-
+                      parent->nfeatures,
+                      parent->pool) {
+  bins = parent->bins;
+
+  const size_t nbins = pool->num_bins();
+  double *sums = block->sumlbl_data;
+  size_t *counts = block->count_data;
+  double const *parent_sums = parent->block->sumlbl_data;
+  size_t const *parent_counts = parent->block->count_data;
+  double const *sibling_sums = sibling->block->sumlbl_data;
+  size_t const *sibling_counts = sibling->block->count_data;
   #pragma omp parallel for
-  for (size_t f = 0; f < nfeatures; ++f) {
-    for (size_t t = 0; t < thresholds_size[f]; ++t) {
-      sumlbl[f][t] = parent->sumlbl[f][t] - left->sumlbl[f][t];
-      count[f][t] = parent->count[f][t] - left->count[f][t];
-    }
+  for (size_t b = 0; b < nbins; ++b) {
+    sums[b] = parent_sums[b] - sibling_sums[b];
+    counts[b] = parent_counts[b] - sibling_counts[b];
   }
-  squares_sum_ = parent->squares_sum_ - left->squares_sum_;
+  squares_sum_ = parent->squares_sum_ - sibling->squares_sum_;
 }
 
 RTNodeHistogram::RTNodeHistogram(const RTNodeHistogram& source)
-    : nfeatures(source.nfeatures) {
+    : nfeatures(source.nfeatures),
+      pool(source.pool) {
   squares_sum_ = source.squares_sum_;
 
   thresholds_size = new size_t[nfeatures];
@@ -103,55 +212,46 @@ RTNodeHistogram::RTNodeHistogram(const RTNodeHistogram& source)
     }
   }
 
-  stmap = new size_t*[nfeatures];
-  for (unsigned int f=0; f<nfeatures; ++f) {
-    stmap[f] = new size_t[thresholds_size[f]];
-    for (unsigned int t=0; t<thresholds_size[f]; ++t) {
-      stmap[f][t] = source.stmap[f][t];
-    }
-  }
+  bins = source.bins;
 
-  sumlbl = new double*[nfeatures];
-  for (unsigned int f=0; f<nfeatures; ++f) {
-    sumlbl[f] = new double[thresholds_size[f]];
-    for (unsigned int t=0; t<thresholds_size[f]; ++t) {
-      sumlbl[f][t] = source.sumlbl[f][t];
-    }
-  }
-
-  count = new size_t*[nfeatures];
-  for (unsigned int f=0; f<nfeatures; ++f) {
-    count[f] = new size_t[thresholds_size[f]];
-    for (unsigned int t=0; t<thresholds_size[f]; ++t) {
-      count[f][t] = source.count[f][t];
-    }
-  }
+  block = pool->acquire();
+  const size_t nbins = pool->num_bins();
+  std::copy(source.block->sumlbl_data, source.block->sumlbl_data + nbins,
+            block->sumlbl_data);
+  std::copy(source.block->count_data, source.block->count_data + nbins,
+            block->count_data);
+  sumlbl = block->sumlbl;
+  count = block->count;
 }
 
 RTNodeHistogram::~RTNodeHistogram() {
-  for (size_t i = 0; i < nfeatures; ++i) {
-    delete[] sumlbl[i];
-    delete[] count[i];
-
-  }
-  delete[] sumlbl;
-  delete[] count;
+  pool->release(block);
 }
 
 void RTNodeHistogram::update(double *labels, const size_t nlabels) {
 
-  #pragma omp parallel for
-  for (size_t f = 0; f < nfeatures; ++f) {
-    for (size_t t = 0; t < thresholds_size[f]; ++t) {
-      sumlbl[f][t] = 0.0;
+  pool->clear_sumlbl(block);
+
+  if (bins->is_sparse()) {
+    double total = 0.0;
+    for (size_t k = 0; k < nlabels; ++k)
+      total += labels[k];
+    #pragma omp parallel for
+    for (size_t f = 0; f < nfeatures; ++f) {
+      SparseLabelAccumulator accumulate = {bins->documents(f),
+                                           bins->num_entries(f), labels,
+                                           sumlbl[f]};
+      bins->apply(f, accumulate);
+      double stored = 0.0;
+      for (size_t t = 0; t < thresholds_size[f]; ++t)
+        stored += sumlbl[f][t];
+      sumlbl[f][bins->default_bin(f)] = total - stored;
     }
-  }
-
-  #pragma omp parallel for
-  for (size_t f = 0; f < nfeatures; ++f) {
-    for (size_t i = 0; i < nlabels; ++i) {
-      const size_t t = stmap[f][i];
-      sumlbl[f][t] += labels[i];
+  } else {
+    #pragma omp parallel for
+    for (size_t f = 0; f < nfeatures; ++f) {
+      LabelAccumulator accumulate = {labels, nlabels, sumlbl[f]};
+      bins->apply(f, accumulate);
       //count doesn't change, so no need to re-compute
     }
   }
@@ -172,48 +272,226 @@ void RTNodeHistogram::update(double *labels, const size_t nlabels) {
 void RTNodeHistogram::update(double *labels,
                              const size_t nsampleids, const size_t *sampleids) {
 
-  #pragma omp parallel for
-  for (size_t f = 0; f < nfeatures; ++f) {
-    for (size_t t = 0; t < thresholds_size[f]; ++t) {
-      sumlbl[f][t] = 0.0;
-      count[f][t] = 0;
+  pool->clear(block);
+
+  //count change, so we need to re-compute it!!
+  accumulate(sampleids, nsampleids, labels);
+}
+
+void RTNodeHistogram::accumulate(size_t const *sampleids,
+                                 const size_t nsampleids,
+                                 double const *labels) {
+  if (bins->is_sparse()) {
+    accumulate_sparse({this}, {sampleids}, {nsampleids}, labels);
+    return;
+  }
+
+  const size_t nthreads = omp_get_max_threads();
+  const size_t nbins = pool->num_bins();
+
+  const bool row_blocks = nthreads > 1
+      && nfeatures < MIN_FEATURES_PER_THREAD * nthreads
+      && MIN_SCAN_TO_MERGE_RATIO * nthreads * nbins <= nsampleids * nfeatures;
+
+  if (row_blocks) {
+    std::vector<HistogramBlock *> thread_blocks(nthreads, NULL);
+    std::vector<double> thread_squares(nthreads, 0.0);
+
+    #pragma omp parallel num_threads(nthreads)
+    {
+      const size_t ith = omp_get_thread_num();
+      const size_t nth = omp_get_num_threads();
+      const size_t begin = nsampleids * ith / nth;
+      const size_t end = nsampleids * (ith + 1) / nth;
+      HistogramBlock *mine = pool->acquire();
+      pool->clear(mine);
+      thread_blocks[ith] = mine;
+
+      for (size_t b = begin; b < end; b += SAMPLE_BLOCK_SIZE) {
+        const size_t nblock = std::min(SAMPLE_BLOCK_SIZE, end - b);
+        for (size_t f = 0; f < nfeatures; ++f) {
+          BinAccumulator accumulate = {sampleids + b, nblock, labels,
+                                       mine->sumlbl[f], mine->count[f]};
+          bins->apply(f, accumulate);
+        }
+      }
+      double squares_sum = 0.0;
+      for (size_t i = begin; i < end; ++i) {
+        const size_t s = sampleids[i];
+        squares_sum += labels[s] * labels[s];
+      }
+      thread_squares[ith] = squares_sum;
+
+      // merge partial histograms in thread order, so that the result does
+      // not depend on the scheduling
+      #pragma omp barrier
+      #pragma omp for schedule(dynamic)
+      for (size_t f = 0; f < nfeatures; ++f) {
+        for (size_t th = 0; th < nth; ++th) {
+          double const *th_sumlbl = thread_blocks[th]->sumlbl[f];
+          size_t const *th_count = thread_blocks[th]->count[f];
+          for (size_t t = 0; t < thresholds_size[f]; ++t) {
+            sumlbl[f][t] += th_sumlbl[t];
+            count[f][t] += th_count[t];
+          }
+        }
+        for (size_t t = 1; t < thresholds_size[f]; ++t) {
+          sumlbl[f][t] += sumlbl[f][t - 1];
+          count[f][t] += count[f][t - 1];
+        }
+      }
+      pool->release(mine);
+    }
+
+    squares_sum_ = 0.0;
+    for (size_t th = 0; th < nthreads; ++th)
+      squares_sum_ += thread_squares[th];
+  } else {
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t f = 0; f < nfeatures; ++f) {
+      BinAccumulator accumulate = {sampleids, nsampleids, labels,
+                                   sumlbl[f], count[f]};
+      bins->apply(f, accumulate);
+      for (size_t t = 1; t < thresholds_size[f]; ++t) {
+        sumlbl[f][t] += sumlbl[f][t - 1];
+        count[f][t] += count[f][t - 1];
+      }
+    }
+
+    squares_sum_ = 0.0;
+    for (size_t i = 0; i < nsampleids; ++i) {
+      const size_t s = sampleids[i];
+      squares_sum_ += labels[s] * labels[s];
     }
   }
+}
+
+void RTNodeHistogram::transform_intochild(RTNodeHistogram const *sibling) {
+  squares_sum_ = squares_sum_ - sibling->squares_sum_;
 
+  const size_t nbins = pool->num_bins();
+  double *sums = block->sumlbl_data;
+  size_t *counts = block->count_data;
+  double const *sibling_sums = sibling->block->sumlbl_data;
+  size_t const *sibling_counts = sibling->block->count_data;
   #pragma omp parallel for
-  for (size_t f = 0; f < nfeatures; ++f) {
-    for (size_t j = 0; j < nsampleids; ++j) {
-      const size_t s = sampleids[j];
-      const size_t t = stmap[f][s];
-      sumlbl[f][t] += labels[s];
-      count[f][t]++;
-      //count change, so we need to re-compute it!!
-    }
+  for (size_t b = 0; b < nbins; ++b) {
+    sums[b] -= sibling_sums[b];
+    counts[b] -= sibling_counts[b];
+  }
+}
 
-    for (size_t t = 1; t < thresholds_size[f]; ++t) {
-      sumlbl[f][t] += sumlbl[f][t - 1];
-      count[f][t] += count[f][t - 1];
+std::vector<RTNodeHistogram *> RTNodeHistogram::build(
+    std::vector<RTNodeHistogram const *> const &parents,
+    std::vector<size_t const *> const &sampleids,
+    std::vector<size_t> const &nsampleids,
+    double const *labels) {
+  const size_t nnodes = parents.size();
+  std::vector<RTNodeHistogram *> hists(nnodes, NULL);
+  if (nnodes == 0)
+    return hists;
+
+  for (size_t n = 0; n < nnodes; ++n) {
+    hists[n] = new RTNodeHistogram(parents[n]->thresholds,
+                                   parents[n]->thresholds_size,
+                                   parents[n]->nfeatures,
+                                   parents[n]->pool);
+    hists[n]->bins = parents[n]->bins;
+  }
+
+  if (parents[0]->bins->is_sparse()) {
+    accumulate_sparse(hists, sampleids, nsampleids, labels);
+    return hists;
+  }
+
+  // one work item per feature and node, so that the nodes sharing a feature
+  // are scanned one after the other
+  const size_t nfeatures = parents[0]->nfeatures;
+  FeatureBins const *bins = parents[0]->bins;
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t p = 0; p < nfeatures * nnodes; ++p) {
+    const size_t f = p / nnodes;
+    RTNodeHistogram *h = hists[p % nnodes];
+    BinAccumulator accumulate = {sampleids[p % nnodes], nsampleids[p % nnodes],
+                                 labels, h->sumlbl[f], h->count[f]};
+    bins->apply(f, accumulate);
+    for (size_t t = 1; t < h->thresholds_size[f]; ++t) {
+      h->sumlbl[f][t] += h->sumlbl[f][t - 1];
+      h->count[f][t] += h->count[f][t - 1];
     }
   }
 
-  squares_sum_ = 0.0;
-  for (size_t k = 0; k < nsampleids; ++k) {
-    const size_t s = sampleids[k];
-    squares_sum_ += labels[s] * labels[s];
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t n = 0; n < nnodes; ++n) {
+    double squares_sum = 0.0;
+    for (size_t i = 0; i < nsampleids[n]; ++i) {
+      const size_t s = sampleids[n][i];
+      squares_sum += labels[s] * labels[s];
+    }
+    hists[n]->squares_sum_ = squares_sum;
   }
+  return hists;
 }
 
-void RTNodeHistogram::transform_intorightchild(RTNodeHistogram const *left) {
-  squares_sum_ = squares_sum_ - left->squares_sum_;
+void RTNodeHistogram::accumulate_sparse(
+    std::vector<RTNodeHistogram *> const &hists,
+    std::vector<size_t const *> const &sampleids,
+    std::vector<size_t> const &nsampleids,
+    double const *labels) {
+  const size_t nnodes = hists.size();
+  const size_t nfeatures = hists[0]->nfeatures;
+  FeatureBins const *bins = hists[0]->bins;
+
+  // mark the samples of every node, and get the totals of the nodes
+  uint32_t *slots = bins->sample_slots();
+  std::vector<double> node_sumlbl(nnodes);
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t n = 0; n < nnodes; ++n) {
+    double sum = 0.0;
+    double squares_sum = 0.0;
+    for (size_t i = 0; i < nsampleids[n]; ++i) {
+      const size_t s = sampleids[n][i];
+      slots[s] = (uint32_t) n;
+      sum += labels[s];
+      squares_sum += labels[s] * labels[s];
+    }
+    node_sumlbl[n] = sum;
+    hists[n]->squares_sum_ = squares_sum;
+  }
 
-  #pragma omp parallel for
-  for (size_t f = 0; f < nfeatures; ++f) {
-    const size_t nthresholds = thresholds_size[f];
-    for (size_t t = 0; t < nthresholds; ++t) {
-      sumlbl[f][t] -= left->sumlbl[f][t];
-      count[f][t] -= left->count[f][t];
+  // one work item per feature, scanning its stored documents only once for
+  // all the nodes
+  #pragma omp parallel
+  {
+    std::vector<double *> sumlbl(nnodes);
+    std::vector<size_t *> count(nnodes);
+    #pragma omp for schedule(dynamic)
+    for (size_t f = 0; f < nfeatures; ++f) {
+      for (size_t n = 0; n < nnodes; ++n) {
+        sumlbl[n] = hists[n]->sumlbl[f];
+        count[n] = hists[n]->count[f];
+      }
+      SparseBinAccumulator accumulate = {bins->documents(f),
+                                         bins->num_entries(f), slots, labels,
+                                         sumlbl.data(), count.data()};
+      bins->apply(f, accumulate);
+
+      const size_t nthresholds = hists[0]->thresholds_size[f];
+      for (size_t n = 0; n < nnodes; ++n) {
+        fill_default_bin(sumlbl[n], count[n], nthresholds,
+                         bins->default_bin(f), node_sumlbl[n], nsampleids[n]);
+        for (size_t t = 1; t < nthresholds; ++t) {
+          sumlbl[n][t] += sumlbl[n][t - 1];
+          count[n][t] += count[n][t - 1];
+        }
+      }
     }
   }
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t n = 0; n < nnodes; ++n)
+    for (size_t i = 0; i < nsampleids[n]; ++i)
+      slots[sampleids[n][i]] = FeatureBins::NO_SLOT;
 }
 
 void RTNodeHistogram::quick_dump(size_t f, size_t num_t) {
@@ -225,35 +503,78 @@ void RTNodeHistogram::quick_dump(size_t f, size_t num_t) {
 
 
 RTRootHistogram::RTRootHistogram(quickrank::data::VerticalDataset *dataset,
-                                 size_t **sortedidx, size_t sortedidxsize,
-                                 float **thresholds, size_t *thresholds_size)
-    : RTNodeHistogram(thresholds, thresholds_size, dataset->num_features()) {
+                                 float **thresholds, size_t *thresholds_size,
+                                 std::shared_ptr<HistogramPool> pool)
+    : RTNodeHistogram(thresholds, thresholds_size, dataset->num_features(),
+                      pool) {
+
+  const size_t ninstances = dataset->num_instances();
+  if (dataset->is_sparse()) {
+    build_sparse_bins(dataset);
+    return;
+  }
 
-  stmap = new size_t *[nfeatures];
+  bins = new FeatureBins(nfeatures, ninstances, thresholds_size);
 
   #pragma omp parallel for
   for (size_t f = 0; f < nfeatures; ++f) {
-    stmap[f] = new size_t[sortedidxsize];
-    size_t threshold_size = thresholds_size[f];
     float *features = dataset->at(0, f);
     float *threshold = thresholds[f];
-    size_t last = -1, j;
-    for (size_t t = 0; t < threshold_size; ++t) {
-      //find the first sample exceeding the current threshold
-      for (j = last + 1; j < sortedidxsize; ++j) {
-        size_t k = sortedidx[f][j];
-        if (features[k] > threshold[t])
-          break;
-        stmap[f][k] = t;
+    float *threshold_end = threshold + thresholds_size[f];
+    for (size_t i = 0; i < ninstances; ++i) {
+      const size_t t = find_bin(threshold, threshold_end, features[i]);
+      bins->set(f, i, t);
+      count[f][t]++;
+    }
+
+    for (size_t t = 1; t < thresholds_size[f]; ++t)
+      count[f][t] += count[f][t - 1];
+  }
+}
+
+void RTRootHistogram::build_sparse_bins(
+    quickrank::data::VerticalDataset *dataset) {
+  const size_t ninstances = dataset->num_instances();
+
+  // the missing values are 0: only the documents whose value falls in
+  // another bin than 0 need to be stored
+  std::vector<size_t> default_bins(nfeatures);
+  std::vector<size_t> nentries(nfeatures, 0);
+  #pragma omp parallel for
+  for (size_t f = 0; f < nfeatures; ++f) {
+    float *threshold = thresholds[f];
+    float *threshold_end = threshold + thresholds_size[f];
+    default_bins[f] = find_bin(threshold, threshold_end, 0.0f);
+    quickrank::Feature const *values = dataset->nonzero_values(f);
+    for (size_t k = 0; k < dataset->num_nonzeros(f); ++k)
+      nentries[f] += find_bin(threshold, threshold_end, values[k])
+          != default_bins[f];
+  }
+
+  bins = new FeatureBins(nfeatures, ninstances, thresholds_size,
+                         default_bins.data(), nentries.data());
+
+  #pragma omp parallel for
+  for (size_t f = 0; f < nfeatures; ++f) {
+    float *threshold = thresholds[f];
+    float *threshold_end = threshold + thresholds_size[f];
+    uint32_t const *documents = dataset->nonzero_documents(f);
+    quickrank::Feature const *values = dataset->nonzero_values(f);
+    size_t nstored = 0;
+    for (size_t k = 0; k < dataset->num_nonzeros(f); ++k) {
+      const size_t t = find_bin(threshold, threshold_end, values[k]);
+      if (t != default_bins[f]) {
+        bins->set_entry(f, nstored++, documents[k], t);
+        count[f][t]++;
       }
-      last = j - 1;
-      count[f][t] = j;
     }
+    count[f][default_bins[f]] = ninstances - nstored;
+
+    for (size_t t = 1; t < thresholds_size[f]; ++t)
+      count[f][t] += count[f][t - 1];
   }
 }
 
 RTRootHistogram::~RTRootHistogram() {
-  for (size_t i = 0; i < nfeatures; ++i)
-    delete[] stmap[i];
-  delete[] stmap;
+  delete bins;
 }
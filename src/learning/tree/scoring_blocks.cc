@@ -0,0 +1,82 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/scoring_blocks.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
+
+#include "types.h"
+
+namespace scoring_blocks {
+
+/// Document blocks are not made smaller than this.
+const size_t MIN_DOCUMENTS_PER_BLOCK = 16;
+
+size_t cache_size(unsigned int level) {
+  long size = -1;
+#if defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+  if (level == 2)
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  else if (level == 3)
+    size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+  if (size > 0)
+    return (size_t) size;
+  return level == 2 ? 256 * 1024 : 8 * 1024 * 1024;
+}
+
+std::vector<size_t> tree_blocks(std::vector<size_t> const &tree_bytes) {
+  const size_t budget = cache_size(2) / 2;
+  std::vector<size_t> blocks(1, 0);
+  size_t block_bytes = 0;
+  for (size_t t = 0; t < tree_bytes.size(); ++t) {
+    if (t > blocks.back() && block_bytes + tree_bytes[t] > budget) {
+      blocks.push_back(t);
+      block_bytes = 0;
+    }
+    block_bytes += tree_bytes[t];
+  }
+  blocks.push_back(tree_bytes.size());
+  return blocks;
+}
+
+size_t documents_per_block(size_t ninstances, size_t nfeatures,
+                           size_t ntree_blocks) {
+  const size_t nthreads = omp_get_max_threads();
+  // every thread needs a block, as long as there are enough documents
+  const size_t max_docs = std::max<size_t>(
+      1, (ninstances + nthreads - 1) / nthreads);
+  if (ntree_blocks <= 1)
+    return std::min<size_t>(max_docs, MIN_DOCUMENTS_PER_BLOCK);
+  const size_t doc_bytes =
+      std::max<size_t>(1, nfeatures) * sizeof(quickrank::Feature);
+  const size_t docs = cache_size(3) / 2 / nthreads / doc_bytes;
+  return std::min(max_docs, std::max(docs, MIN_DOCUMENTS_PER_BLOCK));
+}
+
+}  // namespace scoring_blocks
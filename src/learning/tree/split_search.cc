@@ -0,0 +1,262 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/split_search.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define QUICKRANK_SPLIT_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace split_search {
+
+namespace {
+
+const size_t npos = (size_t) -1;
+
+/// Evaluates the thresholds in [begin, nthresholds) one at a time.
+inline size_t scan(double const *sumlbl, size_t const *count,
+                   size_t begin, size_t nthresholds, size_t minls,
+                   double &best_score) {
+  const double s = sumlbl[nthresholds - 1];
+  const size_t c = count[nthresholds - 1];
+  size_t best_threshold = npos;
+  for (size_t t = begin; t < nthresholds; ++t) {
+    size_t lcount = count[t];
+    size_t rcount = c - lcount;
+    if (lcount >= minls && rcount >= minls) {
+      double lsum = sumlbl[t];
+      double rsum = s - lsum;
+      double score = lsum * lsum / (double) lcount
+                   + rsum * rsum / (double) rcount;
+      if (score > best_score) {
+        best_score = score;
+        best_threshold = t;
+      }
+    }
+  }
+  return best_threshold;
+}
+
+#ifdef QUICKRANK_SPLIT_SEARCH_X86
+
+// Counts are converted to double by placing them in the mantissa of 2^52,
+// which is exact as long as they are smaller than 2^52.
+const int64_t MANTISSA_BITS = 0x4330000000000000;
+const double MANTISSA_BASE = 4503599627370496.0;
+
+/// Picks the best among the per-lane bests, i.e., the largest score and the
+/// first threshold on ties. Lanes with a negative threshold did not improve.
+inline size_t reduce_lanes(double const *scores, double const *thresholds,
+                           size_t nlanes, double &best_score) {
+  size_t best_threshold = npos;
+  for (size_t l = 0; l < nlanes; ++l) {
+    if (thresholds[l] < 0.0)
+      continue;
+    const size_t t = (size_t) thresholds[l];
+    if (best_threshold == npos || scores[l] > best_score
+        || (scores[l] == best_score && t < best_threshold)) {
+      best_score = scores[l];
+      best_threshold = t;
+    }
+  }
+  return best_threshold;
+}
+
+#endif
+
+}  // namespace
+
+size_t best_split_scalar(double const *sumlbl, size_t const *count,
+                         size_t nthresholds, size_t minls,
+                         double &best_score) {
+  if (nthresholds == 0)
+    return npos;
+  return scan(sumlbl, count, 0, nthresholds, minls, best_score);
+}
+
+#ifdef QUICKRANK_SPLIT_SEARCH_X86
+
+__attribute__((target("avx2")))
+size_t best_split_avx2(double const *sumlbl, size_t const *count,
+                       size_t nthresholds, size_t minls,
+                       double &best_score) {
+  if (nthresholds == 0)
+    return npos;
+  const size_t nvectors = nthresholds / 4 * 4;
+  const __m256i mantissa_bits = _mm256_set1_epi64x(MANTISSA_BITS);
+  const __m256d mantissa_base = _mm256_set1_pd(MANTISSA_BASE);
+  const __m256d s = _mm256_set1_pd(sumlbl[nthresholds - 1]);
+  const __m256d c = _mm256_set1_pd((double) count[nthresholds - 1]);
+  const __m256d min_count = _mm256_set1_pd((double) minls);
+  const __m256d step = _mm256_set1_pd(4.0);
+
+  __m256d lane_score = _mm256_set1_pd(best_score);
+  __m256d lane_threshold = _mm256_set1_pd(-1.0);
+  __m256d t = _mm256_set_pd(3.0, 2.0, 1.0, 0.0);
+  for (size_t i = 0; i < nvectors; i += 4, t = _mm256_add_pd(t, step)) {
+    const __m256i lcount_bits = _mm256_or_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(count + i)),
+        mantissa_bits);
+    const __m256d lcount = _mm256_sub_pd(_mm256_castsi256_pd(lcount_bits),
+                                         mantissa_base);
+    const __m256d rcount = _mm256_sub_pd(c, lcount);
+    const __m256d valid = _mm256_and_pd(
+        _mm256_cmp_pd(lcount, min_count, _CMP_GE_OQ),
+        _mm256_cmp_pd(rcount, min_count, _CMP_GE_OQ));
+
+    const __m256d lsum = _mm256_loadu_pd(sumlbl + i);
+    const __m256d rsum = _mm256_sub_pd(s, lsum);
+    const __m256d score = _mm256_add_pd(
+        _mm256_div_pd(_mm256_mul_pd(lsum, lsum), lcount),
+        _mm256_div_pd(_mm256_mul_pd(rsum, rsum), rcount));
+
+    const __m256d better = _mm256_and_pd(
+        valid, _mm256_cmp_pd(score, lane_score, _CMP_GT_OQ));
+    lane_score = _mm256_blendv_pd(lane_score, score, better);
+    lane_threshold = _mm256_blendv_pd(lane_threshold, t, better);
+  }
+
+  double scores[4], thresholds[4];
+  _mm256_storeu_pd(scores, lane_score);
+  _mm256_storeu_pd(thresholds, lane_threshold);
+  size_t best_threshold = reduce_lanes(scores, thresholds, 4, best_score);
+  const size_t tail = scan(sumlbl, count, nvectors, nthresholds, minls,
+                           best_score);
+  return tail != npos ? tail : best_threshold;
+}
+
+__attribute__((target("avx512f")))
+size_t best_split_avx512(double const *sumlbl, size_t const *count,
+                         size_t nthresholds, size_t minls,
+                         double &best_score) {
+  if (nthresholds == 0)
+    return npos;
+  const size_t nvectors = nthresholds / 8 * 8;
+  const __m512i mantissa_bits = _mm512_set1_epi64(MANTISSA_BITS);
+  const __m512d mantissa_base = _mm512_set1_pd(MANTISSA_BASE);
+  const __m512d s = _mm512_set1_pd(sumlbl[nthresholds - 1]);
+  const __m512d c = _mm512_set1_pd((double) count[nthresholds - 1]);
+  const __m512d min_count = _mm512_set1_pd((double) minls);
+  const __m512d step = _mm512_set1_pd(8.0);
+
+  __m512d lane_score = _mm512_set1_pd(best_score);
+  __m512d lane_threshold = _mm512_set1_pd(-1.0);
+  __m512d t = _mm512_set_pd(7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0);
+  for (size_t i = 0; i < nvectors; i += 8, t = _mm512_add_pd(t, step)) {
+    const __m512i lcount_bits = _mm512_or_si512(
+        _mm512_loadu_si512(count + i), mantissa_bits);
+    const __m512d lcount = _mm512_sub_pd(_mm512_castsi512_pd(lcount_bits),
+                                         mantissa_base);
+    const __m512d rcount = _mm512_sub_pd(c, lcount);
+    const __mmask8 valid =
+        _mm512_cmp_pd_mask(lcount, min_count, _CMP_GE_OQ)
+        & _mm512_cmp_pd_mask(rcount, min_count, _CMP_GE_OQ);
+
+    const __m512d lsum = _mm512_loadu_pd(sumlbl + i);
+    const __m512d rsum = _mm512_sub_pd(s, lsum);
+    const __m512d score = _mm512_add_pd(
+        _mm512_div_pd(_mm512_mul_pd(lsum, lsum), lcount),
+        _mm512_div_pd(_mm512_mul_pd(rsum, rsum), rcount));
+
+    const __mmask8 better =
+        _mm512_mask_cmp_pd_mask(valid, score, lane_score, _CMP_GT_OQ);
+    lane_score = _mm512_mask_blend_pd(better, lane_score, score);
+    lane_threshold = _mm512_mask_blend_pd(better, lane_threshold, t);
+  }
+
+  double scores[8], thresholds[8];
+  _mm512_storeu_pd(scores, lane_score);
+  _mm512_storeu_pd(thresholds, lane_threshold);
+  size_t best_threshold = reduce_lanes(scores, thresholds, 8, best_score);
+  const size_t tail = scan(sumlbl, count, nvectors, nthresholds, minls,
+                           best_score);
+  return tail != npos ? tail : best_threshold;
+}
+
+Kernel best_kernel() {
+  static const Kernel kernel =
+      __builtin_cpu_supports("avx512f") ? best_split_avx512
+    : __builtin_cpu_supports("avx2") ? best_split_avx2
+    : best_split_scalar;
+  return kernel;
+}
+
+const char *best_kernel_name() {
+  return __builtin_cpu_supports("avx512f") ? "avx512"
+       : __builtin_cpu_supports("avx2") ? "avx2"
+       : "scalar";
+}
+
+#else
+
+size_t best_split_avx2(double const *sumlbl, size_t const *count,
+                       size_t nthresholds, size_t minls,
+                       double &best_score) {
+  return best_split_scalar(sumlbl, count, nthresholds, minls, best_score);
+}
+
+size_t best_split_avx512(double const *sumlbl, size_t const *count,
+                         size_t nthresholds, size_t minls,
+                         double &best_score) {
+  return best_split_scalar(sumlbl, count, nthresholds, minls, best_score);
+}
+
+Kernel best_kernel() {
+  return best_split_scalar;
+}
+
+const char *best_kernel_name() {
+  return "scalar";
+}
+
+#endif
+
+ThreadBestSplits::~ThreadBestSplits() {
+  free(entries_);
+}
+
+ThreadBestSplit *ThreadBestSplits::reset(size_t nthreads, double score) {
+  if (size_ < nthreads) {
+    free(entries_);
+    void *data = NULL;
+    if (posix_memalign(&data, alignof(ThreadBestSplit),
+                       nthreads * sizeof(ThreadBestSplit)) != 0) {
+      std::cerr << "!!! Unable to allocate the best splits of " << nthreads
+                << " threads" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    entries_ = static_cast<ThreadBestSplit *>(data);
+    size_ = nthreads;
+  }
+  for (size_t i = 0; i < nthreads; ++i) {
+    entries_[i].score = score;
+    entries_[i].featureidx = npos;
+    entries_[i].thresholdid = npos;
+  }
+  return entries_;
+}
+
+}  // namespace split_search
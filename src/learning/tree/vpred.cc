@@ -0,0 +1,248 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "learning/tree/vpred.h"
+#include "learning/tree/scoring_blocks.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define QUICKRANK_VPRED_X86
+#include <immintrin.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
+
+namespace {
+
+size_t tree_depth(RTNode const *node) {
+  if (node->is_leaf())
+    return 0;
+  return 1 + std::max(tree_depth(node->left), tree_depth(node->right));
+}
+
+}  // namespace
+
+bool VPred::is_supported(const Ensemble &ensemble) {
+  for (size_t t = 0; t < ensemble.get_size(); ++t)
+    if (tree_depth(ensemble.getTree(t)) > MAX_DEPTH)
+      return false;
+  return true;
+}
+
+VPred::VPred(const Ensemble &ensemble) {
+  ntrees_ = ensemble.get_size();
+  depths_.resize(ntrees_);
+  node_offsets_.resize(ntrees_);
+  leaf_offsets_.resize(ntrees_);
+  weights_.resize(ntrees_);
+
+  size_t nnodes = 0, nleaves = 0;
+  for (size_t t = 0; t < ntrees_; ++t) {
+    depths_[t] = tree_depth(ensemble.getTree(t));
+    node_offsets_[t] = nnodes;
+    leaf_offsets_[t] = nleaves;
+    nnodes += ((size_t) 1 << depths_[t]) - 1;
+    nleaves += (size_t) 1 << depths_[t];
+    weights_[t] = ensemble.getWeight(t);
+  }
+
+  features_.resize(nnodes);
+  thresholds_.resize(nnodes);
+  leaves_.resize(nleaves);
+  for (size_t t = 0; t < ntrees_; ++t)
+    add_subtree(ensemble.getTree(t), t, 0, 0);
+}
+
+void VPred::add_subtree(RTNode const *node, const size_t t, const size_t pos,
+                        const size_t level) {
+  if (level == depths_[t]) {
+    const size_t first_leaf = ((size_t) 1 << level) - 1;
+    leaves_[leaf_offsets_[t] + pos - first_leaf] = node->avglabel;
+    return;
+  }
+  const size_t i = node_offsets_[t] + pos;
+  if (node->is_leaf()) {
+    // documents go left but NaN values, both subtrees lead to copies of
+    // the leaf
+    features_[i] = 0;
+    thresholds_[i] = std::numeric_limits<float>::infinity();
+    add_subtree(node, t, 2 * pos + 1, level + 1);
+    add_subtree(node, t, 2 * pos + 2, level + 1);
+  } else {
+    features_[i] = (int32_t) node->get_feature_idx();
+    thresholds_[i] = node->threshold;
+    nmodel_features_ = std::max(nmodel_features_,
+                                node->get_feature_idx() + 1);
+    add_subtree(node->left, t, 2 * pos + 1, level + 1);
+    add_subtree(node->right, t, 2 * pos + 2, level + 1);
+  }
+}
+
+void VPred::score_instance(const quickrank::Feature *d,
+                           const size_t tree_begin, const size_t tree_end,
+                           quickrank::Score &score) const {
+  for (size_t t = tree_begin; t < tree_end; ++t) {
+    const int32_t *features = &features_[node_offsets_[t]];
+    const float *thresholds = &thresholds_[node_offsets_[t]];
+    size_t idx = 0;
+    for (size_t level = 0; level < depths_[t]; ++level)
+      idx = 2 * idx + 1 + !(d[features[idx]] <= thresholds[idx]);
+    const size_t first_leaf = ((size_t) 1 << depths_[t]) - 1;
+    score += leaves_[leaf_offsets_[t] + idx - first_leaf] * weights_[t];
+  }
+}
+
+void VPred::score_lockstep_scalar(const quickrank::Feature *d,
+                                  const size_t nfeatures,
+                                  const size_t tree_begin,
+                                  const size_t tree_end,
+                                  quickrank::Score *scores) const {
+  for (size_t t = tree_begin; t < tree_end; ++t) {
+    const int32_t *features = &features_[node_offsets_[t]];
+    const float *thresholds = &thresholds_[node_offsets_[t]];
+    size_t idx[LOCKSTEP] = {0};
+    for (size_t level = 0; level < depths_[t]; ++level)
+      for (size_t v = 0; v < LOCKSTEP; ++v)
+        idx[v] = 2 * idx[v] + 1
+            + !(d[v * nfeatures + features[idx[v]]] <= thresholds[idx[v]]);
+    const size_t first_leaf = ((size_t) 1 << depths_[t]) - 1;
+    for (size_t v = 0; v < LOCKSTEP; ++v)
+      scores[v] += leaves_[leaf_offsets_[t] + idx[v] - first_leaf]
+          * weights_[t];
+  }
+}
+
+#ifdef QUICKRANK_VPRED_X86
+
+__attribute__((target("avx2")))
+void VPred::score_lockstep_avx2(const quickrank::Feature *d,
+                                const size_t nfeatures,
+                                const size_t tree_begin,
+                                const size_t tree_end,
+                                quickrank::Score *scores) const {
+  static_assert(LOCKSTEP == 8, "a lockstep must fill an AVX2 register");
+  const __m256i doc_offsets = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+      _mm256_set1_epi32((int) nfeatures));
+  const __m256i one = _mm256_set1_epi32(1);
+  alignas(32) int32_t leaf[LOCKSTEP];
+  for (size_t t = tree_begin; t < tree_end; ++t) {
+    const int32_t *features = &features_[node_offsets_[t]];
+    const float *thresholds = &thresholds_[node_offsets_[t]];
+    __m256i idx = _mm256_setzero_si256();
+    for (size_t level = 0; level < depths_[t]; ++level) {
+      const __m256i f = _mm256_i32gather_epi32(features, idx, 4);
+      const __m256 theta = _mm256_i32gather_ps(thresholds, idx, 4);
+      const __m256 x = _mm256_i32gather_ps(
+          d, _mm256_add_epi32(doc_offsets, f), 4);
+      // a true comparison is -1, i.e., one more step to the right, and
+      // NaN values go right as in the trees
+      const __m256i right = _mm256_castps_si256(
+          _mm256_cmp_ps(x, theta, _CMP_NLE_UQ));
+      idx = _mm256_sub_epi32(
+          _mm256_add_epi32(_mm256_slli_epi32(idx, 1), one), right);
+    }
+    _mm256_store_si256((__m256i *) leaf, idx);
+    const double *leaves = leaves_.data() + leaf_offsets_[t];
+    const int32_t first_leaf = (1 << depths_[t]) - 1;
+    for (size_t v = 0; v < LOCKSTEP; ++v)
+      scores[v] += leaves[leaf[v] - first_leaf] * weights_[t];
+  }
+}
+
+VPred::Kernel VPred::best_kernel() {
+  return __builtin_cpu_supports("avx2") ? &VPred::score_lockstep_avx2
+                                        : &VPred::score_lockstep_scalar;
+}
+
+const char *VPred::kernel_name() {
+  return __builtin_cpu_supports("avx2") ? "avx2" : "scalar";
+}
+
+#else
+
+void VPred::score_lockstep_avx2(const quickrank::Feature *d,
+                                const size_t nfeatures,
+                                const size_t tree_begin,
+                                const size_t tree_end,
+                                quickrank::Score *scores) const {
+  score_lockstep_scalar(d, nfeatures, tree_begin, tree_end, scores);
+}
+
+VPred::Kernel VPred::best_kernel() {
+  return &VPred::score_lockstep_scalar;
+}
+
+const char *VPred::kernel_name() {
+  return "scalar";
+}
+
+#endif
+
+void VPred::score(const quickrank::Feature *d,
+                  const size_t ninstances,
+                  const size_t nfeatures,
+                  quickrank::Score *scores) const {
+  if (nfeatures < nmodel_features_) {
+    std::cerr << "!!! The model uses " << nmodel_features_
+              << " features but documents have only " << nfeatures
+              << "." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<size_t> tree_bytes(ntrees_);
+  for (size_t t = 0; t < ntrees_; ++t)
+    tree_bytes[t] = (((size_t) 1 << depths_[t]) - 1)
+        * (sizeof(int32_t) + sizeof(float))
+        + ((size_t) 1 << depths_[t]) * sizeof(double);
+  const std::vector<size_t> blocks = scoring_blocks::tree_blocks(tree_bytes);
+  const size_t nblocks = blocks.size() - 1;
+  // blocks of documents are made of whole locksteps
+  size_t docs_per_block = scoring_blocks::documents_per_block(
+      ninstances, nfeatures, nblocks);
+  docs_per_block = (docs_per_block + LOCKSTEP - 1) / LOCKSTEP * LOCKSTEP;
+  const size_t ndoc_blocks = (ninstances + docs_per_block - 1)
+      / docs_per_block;
+  const Kernel kernel = best_kernel();
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t db = 0; db < ndoc_blocks; ++db) {
+    const size_t begin = db * docs_per_block;
+    const size_t end = std::min(ninstances, begin + docs_per_block);
+    std::fill(scores + begin, scores + end, 0.0);
+    for (size_t b = 0; b < nblocks; ++b) {
+      size_t i = begin;
+      for (; i + LOCKSTEP <= end; i += LOCKSTEP)
+        (this->*kernel)(d + i * nfeatures, nfeatures, blocks[b],
+                        blocks[b + 1], scores + i);
+      for (; i < end; ++i)
+        score_instance(d + i * nfeatures, blocks[b], blocks[b + 1],
+                       scores[i]);
+    }
+  }
+}
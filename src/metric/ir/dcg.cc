@@ -38,6 +38,15 @@ MetricScore Dcg::compute_dcg(const Label *labels, size_t len) const {
   return (MetricScore) dcg;
 }
 
+MetricScore Dcg::compute_dcg(const Label *labels, size_t len,
+                             const DcgTables &tables) const {
+  const size_t size = std::min(cutoff(), len);
+  double dcg = 0.0;
+  for (size_t i = 0; i < size; ++i)
+    dcg += (tables.gain(labels[i]) - 1.0f) / tables.log2_rank(i);
+  return (MetricScore) dcg;
+}
+
 MetricScore Dcg::evaluate_result_list(const quickrank::data::QueryResults *rl,
                                       const Score *scores) const {
   const size_t size = std::min(cutoff(), rl->num_results());
@@ -56,30 +65,87 @@ MetricScore Dcg::evaluate_result_list(const quickrank::data::QueryResults *rl,
   return dcg;
 }
 
-std::unique_ptr<Jacobian> Dcg::jacobian(
-    std::shared_ptr<data::RankedResults> ranked) const {
-  const size_t size = std::min(cutoff(), ranked->num_results());
-  std::unique_ptr<Jacobian> jacobian = std::unique_ptr<Jacobian>(
-      new Jacobian(ranked->num_results()));
+bool Dcg::evaluate_ranking(const quickrank::data::QueryResults *rl,
+                           const size_t *ranking,
+                           MetricScore &score) const {
+  const size_t size = std::min(cutoff(), rl->num_results());
+  double dcg = 0.0;
+  for (size_t i = 0; i < size; ++i)
+    dcg += (pow(2.0, rl->labels()[ranking[i]]) - 1.0f) / log2(i + 2.0f);
+  score = (MetricScore) dcg;
+  return true;
+}
+
+MetricScore Dcg::evaluate_list(const Label *labels, const Score *scores,
+                              const size_t nresults,
+                              Workspace &workspace) const {
+  const size_t size = std::min(cutoff(), nresults);
+  if (size == 0)
+    return 0.0;
+
+  size_t *ranking = workspace.ranking.data();
+  data::QueryResults(nresults, const_cast<Label *>(labels), NULL)
+      .indexing_of_sorted_labels(scores, ranking);
 
+  double dcg = 0.0;
+  for (size_t i = 0; i < size; ++i)
+    dcg += (workspace.tables.gain(labels[ranking[i]]) - 1.0f)
+        / workspace.tables.log2_rank(i);
+  return (MetricScore) dcg;
+}
+
+void Dcg::jacobian(data::RankedResults &ranked,
+                   const DcgTables &tables,
+                   ScratchArena &arena,
+                   Jacobian &jacobian) const {
+  fill_jacobian(ranked, tables, 1.0, jacobian);
+}
+
+void Dcg::fill_jacobian(const data::RankedResults &ranked,
+                        const DcgTables &tables,
+                        const double normalization,
+                        Jacobian &jacobian) const {
+  const size_t nresults = ranked.num_results();
+  const size_t size = std::min(cutoff(), nresults);
+  if (size == 0)
+    return;
+
+  const Label *labels = ranked.sorted_labels();
   for (size_t i = 0; i < size; ++i) {
-    for (size_t j = i + 1; j < ranked->num_results(); ++j) {
+    const double gain_i = tables.gain(labels[i]);
+    for (size_t j = i + 1; j < nresults; ++j) {
       // if the score is the same, non changes occur
-      if (ranked->sorted_labels()[i] != ranked->sorted_labels()[j]) {
+      if (labels[i] != labels[j]) {
         if (j < size)
-          jacobian->at(i, j) =
-              (1.0f / log2((double) (j + 2)) - 1.0f / log2((double) (i + 2)))
-                  * (pow(2.0, (double) ranked->sorted_labels()[i])
-                      - pow(2.0, (double) ranked->sorted_labels()[j]));
+          jacobian.at(i, j) = (tables.discount(j) - tables.discount(i))
+              * (gain_i - tables.gain(labels[j])) / normalization;
         else
-          jacobian->at(i, j) = (-1.0f / log2((double) (i + 2)))
-              * (   pow(2.0, (double) ranked->sorted_labels()[i])
-                  - pow(2.0, (double) ranked->sorted_labels()[j]) );
+          jacobian.at(i, j) = -tables.discount(i)
+              * (gain_i - tables.gain(labels[j])) / normalization;
       }
     }
   }
+}
+
+void Dcg::fill_discounts(const size_t nresults, const DcgTables &tables,
+                         double *discounts) const {
+  const size_t size = std::min(cutoff(), nresults);
+  for (size_t i = 0; i < size; ++i)
+    discounts[i] = tables.discount(i);
+  std::fill(discounts + size, discounts + nresults, 0.0);
+}
 
-  return jacobian;
+bool Dcg::swap_tables(const data::RankedResults &ranked,
+                      const DcgTables &tables,
+                      double *discounts,
+                      double *gains,
+                      double &normalization) const {
+  const size_t nresults = ranked.num_results();
+  fill_discounts(nresults, tables, discounts);
+  for (size_t i = 0; i < nresults; ++i)
+    gains[i] = tables.gain(ranked.sorted_labels()[i]);
+  normalization = 1.0;
+  return true;
 }
 
 std::ostream &Dcg::put(std::ostream &os) const {
@@ -0,0 +1,48 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include <cmath>
+#include <algorithm>
+
+#include "metric/ir/dcg_tables.h"
+
+namespace quickrank {
+namespace metric {
+namespace ir {
+
+DcgTables::DcgTables(Label max_label, size_t max_ranks) {
+  const size_t nlabels = max_label >= 0.0f ? (size_t) max_label + 1 : 0;
+  gains_.resize(nlabels);
+  for (size_t l = 0; l < nlabels; ++l)
+    gains_[l] = pow(2.0, (double) (Label) l);
+
+  // same expressions of Dcg::compute_dcg and Dcg::fill_discounts
+  log2_ranks_.resize(max_ranks);
+  discounts_.resize(max_ranks);
+  for (size_t i = 0; i < max_ranks; ++i) {
+    log2_ranks_[i] = log2(i + 2.0f);
+    discounts_[i] = 1.0 / log2((double) (i + 2));
+  }
+}
+
+}  // namespace ir
+}  // namespace metric
+}  // namespace quickrank
@@ -0,0 +1,149 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include <algorithm>
+
+#include "metric/ir/incremental_evaluator.h"
+
+namespace quickrank {
+namespace metric {
+namespace ir {
+
+IncrementalEvaluator::IncrementalEvaluator(
+    std::shared_ptr<Metric> metric, std::shared_ptr<data::Dataset> dataset)
+    : metric_(metric) {
+  evaluate_dataset_ = [metric, dataset](const Score *scores) {
+    return metric->evaluate_dataset(dataset, scores);
+  };
+  init(dataset->query_labels(0), dataset->offsets(), dataset->num_queries());
+}
+
+IncrementalEvaluator::IncrementalEvaluator(
+    std::shared_ptr<Metric> metric,
+    std::shared_ptr<data::VerticalDataset> dataset)
+    : metric_(metric) {
+  evaluate_dataset_ = [metric, dataset](const Score *scores) {
+    return metric->evaluate_dataset(dataset, scores);
+  };
+  init(dataset->query_labels(0), dataset->offsets(), dataset->num_queries());
+}
+
+void IncrementalEvaluator::init(Label *labels, const size_t *offsets,
+                                size_t nqueries) {
+  labels_ = labels;
+  offsets_.assign(offsets, offsets + nqueries + 1);
+  ranking_.resize(offsets[nqueries]);
+  query_scores_.resize(nqueries);
+  cached_.assign(nqueries, 0);
+}
+
+size_t IncrementalEvaluator::rerank(const data::QueryResults &results,
+                                    const Score *scores, size_t *ranking) {
+  const size_t nresults = results.num_results();
+  // about the moves of sorting the list from scratch
+  const size_t max_moves = 8 * nresults;
+  size_t moves = 0;
+  size_t first_changed = nresults;
+  for (size_t i = 1; i < nresults; ++i) {
+    const size_t doc = ranking[i];
+    const Score score = scores[doc];
+    size_t j = i;
+    while (j > 0 && scores[ranking[j - 1]] < score) {
+      ranking[j] = ranking[j - 1];
+      --j;
+    }
+    if (j != i) {
+      ranking[j] = doc;
+      first_changed = std::min(first_changed, j);
+      moves += i - j;
+      if (moves > max_moves) {
+        results.indexing_of_sorted_labels(scores, ranking);
+        return 0;
+      }
+    }
+  }
+  return first_changed;
+}
+
+MetricScore IncrementalEvaluator::evaluate(const Score *scores) {
+  if (!rank_based_)
+    return evaluate_dataset_(scores);
+
+  const size_t nqueries = query_scores_.size();
+  if (nqueries == 0)
+    return 0.0;
+
+  const size_t cutoff = metric_->cutoff();
+  size_t num_reranked = 0;
+  bool rank_based = true;
+  #pragma omp parallel for schedule(dynamic, 64) \
+      reduction(+:num_reranked) reduction(&&:rank_based)
+  for (size_t q = 0; q < nqueries; ++q) {
+    const size_t offset = offsets_[q];
+    const size_t nresults = offsets_[q + 1] - offset;
+    const data::QueryResults results(nresults, labels_ + offset, NULL);
+    const Score *list_scores = scores + offset;
+    size_t *ranking = &ranking_[offset];
+
+    size_t first_changed = 0;
+    if (ranked_)
+      first_changed = rerank(results, list_scores, ranking);
+    else
+      results.indexing_of_sorted_labels(list_scores, ranking);
+    if (first_changed < nresults)
+      ++num_reranked;
+
+    // ties in the measured results are broken as the metric does, by
+    // measuring the list from scratch
+    const size_t size = std::min(cutoff, nresults);
+    bool ties = false;
+    for (size_t i = 1; i < nresults && i <= size && !ties; ++i)
+      ties = list_scores[ranking[i - 1]] == list_scores[ranking[i]];
+
+    if (ties) {
+      query_scores_[q] = metric_->evaluate_result_list(&results, list_scores);
+      cached_[q] = 0;
+    } else if (first_changed < size || !cached_[q]) {
+      if (metric_->evaluate_ranking(&results, ranking, query_scores_[q]))
+        cached_[q] = 1;
+      else
+        rank_based = false;
+    }
+  }
+  ranked_ = true;
+  num_reranked_ = num_reranked;
+
+  if (!rank_based) {
+    rank_based_ = false;
+    return evaluate_dataset_(scores);
+  }
+
+  // same order of the sum of Metric::evaluate_dataset
+  MetricScore avg_score = 0.0;
+  for (size_t q = 0; q < nqueries; ++q)
+    avg_score += query_scores_[q];
+  avg_score /= (MetricScore) nqueries;
+  return avg_score;
+}
+
+}  // namespace ir
+}  // namespace metric
+}  // namespace quickrank
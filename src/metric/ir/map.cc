@@ -44,25 +44,25 @@ MetricScore Map::evaluate_result_list(const quickrank::data::QueryResults *rl,
   return count > 0 ? ap / count : 0.0;
 }
 
-std::unique_ptr<Jacobian> Map::jacobian(
-    std::shared_ptr<data::RankedResults> ranked) const {
-  int *labels = new int[ranked->num_results()];  // int labels[ql.size];
-  int *relcount = new int[ranked->num_results()];  // int relcount[ql.size];
+void Map::jacobian(data::RankedResults &ranked,
+                   const DcgTables &tables,
+                   ScratchArena &arena,
+                   Jacobian &changes) const {
+  int *labels = arena.allocate<int>(ranked.num_results());
+  int *relcount = arena.allocate<int>(ranked.num_results());
   MetricScore count = 0;
-  for (size_t i = 0; i < ranked->num_results(); ++i) {
-    if (ranked->sorted_labels()[i] > 0.0f)  //relevant if true
+  for (size_t i = 0; i < ranked.num_results(); ++i) {
+    if (ranked.sorted_labels()[i] > 0.0f)  //relevant if true
       labels[i] = 1, ++count;
     else
       labels[i] = 0;
     relcount[i] = count;
   }
   // count = (ql.qid<nrelevantdocs && relevantdocs[ql.qid]>count) ? relevantdocs[ql.qid] : count;
-  std::unique_ptr<Jacobian> changes = std::unique_ptr<Jacobian>(
-      new Jacobian(ranked->num_results()));
   if (count != 0) {
 #pragma omp parallel for
-    for (size_t i = 0; i < ranked->num_results() - 1; ++i)
-      for (size_t j = i + 1; j < ranked->num_results(); ++j)
+    for (size_t i = 0; i < ranked.num_results() - 1; ++i)
+      for (size_t j = i + 1; j < ranked.num_results(); ++j)
         if (labels[i] != labels[j]) {
           const int diff = labels[j] - labels[i];
           MetricScore change = ((relcount[i] + diff) * labels[j]
@@ -71,13 +71,9 @@ std::unique_ptr<Jacobian> Map::jacobian(
             if (labels[k] > 0)
               change += (relcount[k] + diff) / (k + 1.0f);
           change += (-relcount[j] * diff) / (j + 1.0f);
-          changes->at(i, j) = change / count;
+          changes.at(i, j) = change / count;
         }
   }
-  delete[] labels;
-  delete[] relcount;
-  return changes;
-
 }
 
 std::ostream &Map::put(std::ostream &os) const {
@@ -36,9 +36,10 @@ MetricScore Ndcg::compute_idcg(const quickrank::data::QueryResults *rl) const {
   //make a copy of labels
   Label *copyoflabels = new Label[rl->num_results()];
   memcpy(copyoflabels, rl->labels(), sizeof(Label) * rl->num_results());
-  //sort the copy
-  std::sort(copyoflabels, copyoflabels + rl->num_results(),
-            std::greater<int>());
+  //sort the top of the copy, the only part measured by dcg
+  const size_t size = std::min(cutoff(), rl->num_results());
+  std::partial_sort(copyoflabels, copyoflabels + size,
+                    copyoflabels + rl->num_results(), std::greater<int>());
   //compute dcg
   MetricScore dcg = compute_dcg(copyoflabels, rl->num_results());
 
@@ -46,6 +47,27 @@ MetricScore Ndcg::compute_idcg(const quickrank::data::QueryResults *rl) const {
   return dcg;
 }
 
+MetricScore Ndcg::compute_idcg(const Label *labels, const size_t nresults,
+                               Workspace &workspace) const {
+  Label *copyoflabels = workspace.labels.data();
+  std::copy(labels, labels + nresults, copyoflabels);
+  const size_t size = std::min(cutoff(), nresults);
+  std::partial_sort(copyoflabels, copyoflabels + size,
+                    copyoflabels + nresults, std::greater<int>());
+  return compute_dcg(copyoflabels, nresults, workspace.tables);
+}
+
+MetricScore Ndcg::compute_idcg(const Label *labels, const size_t nresults,
+                               const DcgTables &tables,
+                               ScratchArena &arena) const {
+  Label *copyoflabels = arena.allocate<Label>(nresults);
+  std::copy(labels, labels + nresults, copyoflabels);
+  const size_t size = std::min(cutoff(), nresults);
+  std::partial_sort(copyoflabels, copyoflabels + size,
+                    copyoflabels + nresults, std::greater<int>());
+  return compute_dcg(copyoflabels, nresults, tables);
+}
+
 MetricScore Ndcg::evaluate_result_list(const quickrank::data::QueryResults *rl,
                                        const Score *scores) const {
   if (rl->num_results() == 0)
@@ -57,38 +79,68 @@ MetricScore Ndcg::evaluate_result_list(const quickrank::data::QueryResults *rl,
     return 0;
 }
 
-std::unique_ptr<Jacobian> Ndcg::jacobian(
-    std::shared_ptr<data::RankedResults> ranked) const {
-  std::unique_ptr<Jacobian> jacobian = std::unique_ptr<Jacobian>(
-      new Jacobian(ranked->num_results()));
-
-  auto results = std::shared_ptr<data::QueryResults>(
-      new data::QueryResults(ranked->num_results(), ranked->sorted_labels(),
-                             NULL));
-  const double idcg = compute_idcg(results.get());
-  if (idcg <= 0.0)
-    return jacobian;
-
-  const size_t size = std::min(cutoff(), ranked->num_results());
-
-  for (size_t i = 0; i < size; ++i) {
-    for (size_t j = i + 1; j < ranked->num_results(); ++j) {
-      // if the score is the same, non changes occur
-      if (ranked->sorted_labels()[i] != ranked->sorted_labels()[j]) {
-        if (j < size)
-          jacobian->at(i, j) =
-              (1.0f / log2((double) (j + 2)) - 1.0f / log2((double) (i + 2)))
-                  * (pow(2.0, (double) ranked->sorted_labels()[i])
-                      - pow(2.0, (double) ranked->sorted_labels()[j])) / idcg;
-        else
-          jacobian->at(i, j) = (-1.0f / log2((double) (i + 2)))
-              * (pow(2.0, (double) ranked->sorted_labels()[i])
-                  - pow(2.0, (double) ranked->sorted_labels()[j])) / idcg;
-      }
-    }
+bool Ndcg::evaluate_ranking(const quickrank::data::QueryResults *rl,
+                            const size_t *ranking,
+                            MetricScore &score) const {
+  score = 0.0;
+  if (rl->num_results() == 0)
+    return true;
+  const MetricScore idcg = Ndcg::compute_idcg(rl);
+  if (idcg > 0) {
+    Dcg::evaluate_ranking(rl, ranking, score);
+    score /= idcg;
   }
+  return true;
+}
+
+MetricScore Ndcg::evaluate_list(const Label *labels, const Score *scores,
+                               const size_t nresults,
+                               Workspace &workspace) const {
+  if (nresults == 0)
+    return 0.0;
+  const MetricScore idcg = compute_idcg(labels, nresults, workspace);
+  if (idcg > 0)
+    return Dcg::evaluate_list(labels, scores, nresults, workspace) / idcg;
+  else
+    return 0;
+}
 
-  return jacobian;
+void Ndcg::jacobian(data::RankedResults &ranked,
+                    const DcgTables &tables,
+                    ScratchArena &arena,
+                    Jacobian &jacobian) const {
+  const double idcg = compute_idcg(ranked.sorted_labels(),
+                                   ranked.num_results(), tables, arena);
+  if (idcg > 0.0)
+    fill_jacobian(ranked, tables, idcg, jacobian);
+}
+
+bool Ndcg::swap_tables(const data::RankedResults &ranked,
+                       const DcgTables &tables,
+                       double *discounts,
+                       double *gains,
+                       double &normalization) const {
+  Dcg::swap_tables(ranked, tables, discounts, gains, normalization);
+
+  // the IDCG is measured on a copy of the gains sorted in the discounts,
+  // which are then filled again
+  const size_t nresults = ranked.num_results();
+  const size_t size = std::min(cutoff(), nresults);
+  std::copy(gains, gains + nresults, discounts);
+  std::partial_sort(discounts, discounts + size, discounts + nresults,
+                    std::greater<double>());
+  double idcg = 0.0;
+  for (size_t i = 0; i < size; ++i)
+    idcg += (discounts[i] - 1.0f) / tables.log2_rank(i);
+
+  if (idcg > 0.0) {
+    fill_discounts(nresults, tables, discounts);
+    normalization = idcg;
+  } else {
+    // every change is null, as for the Jacobian
+    std::fill(discounts, discounts + nresults, 0.0);
+  }
+  return true;
 }
 
 std::ostream &Ndcg::put(std::ostream &os) const {
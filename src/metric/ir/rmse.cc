@@ -49,12 +49,9 @@ MetricScore Rmse::evaluate_dataset(
   if (size == 0)
     return 0.0;
 
-  MetricScore sse = 0.0f;
-  for (size_t q = 0; q < dataset->num_queries(); q++) {
-    std::shared_ptr<data::QueryResults> r = dataset->getQueryResults(q);
-    sse += evaluate_result_list(r.get(), scores);
-    scores += r->num_results();
-  }
+  MetricScore sse = sum_result_lists(dataset->query_labels(0), scores,
+                                     dataset->offsets(),
+                                     dataset->num_queries());
 
   return -sqrt(sse / dataset->num_instances());
 }
@@ -67,24 +64,18 @@ MetricScore Rmse::evaluate_dataset(
   if (size == 0)
     return 0.0;
 
-  MetricScore sse = 0.0f;
-  for (size_t q = 0; q < dataset->num_queries(); q++) {
-    std::shared_ptr<data::QueryResults> r = dataset->getQueryResults(q);
-    sse += evaluate_result_list(r.get(), scores);
-    scores += r->num_results();
-  }
+  MetricScore sse = sum_result_lists(dataset->query_labels(0), scores,
+                                     dataset->offsets(),
+                                     dataset->num_queries());
 
   return -sqrt(sse / dataset->num_instances());
 }
 
-std::unique_ptr<Jacobian> Rmse::jacobian(
-    std::shared_ptr<data::RankedResults> ranked) const {
-
-  // count = (ql.qid<nrelevantdocs && relevantdocs[ql.qid]>count) ? relevantdocs[ql.qid] : count;
-  std::unique_ptr<Jacobian> changes = std::unique_ptr<Jacobian>(
-      new Jacobian(ranked->num_results()));
+void Rmse::jacobian(data::RankedResults &ranked,
+                    const DcgTables &tables,
+                    ScratchArena &arena,
+                    Jacobian &jacobian) const {
   // RMSE is not affected by the rank...
-  return changes;
 }
 
 std::ostream &Rmse::put(std::ostream &os) const {
@@ -72,33 +72,31 @@ MetricScore Tndcg::evaluate_result_list(const quickrank::data::QueryResults *rl,
   return tndcg;
 }
 
-std::unique_ptr<Jacobian> Tndcg::jacobian(
-    std::shared_ptr<data::RankedResults> ranked) const {
-  std::unique_ptr<Jacobian> jacobian = std::unique_ptr<Jacobian>(
-      new Jacobian(ranked->num_results()));
-
-  auto _results = std::shared_ptr<data::QueryResults>(
-      new data::QueryResults(ranked->num_results(), ranked->sorted_labels(),
-                             NULL));
-  const double idcg = compute_idcg(_results.get());
+void Tndcg::jacobian(data::RankedResults &ranked,
+                     const DcgTables &tables,
+                     ScratchArena &arena,
+                     Jacobian &jacobian) const {
+  const double idcg = compute_idcg(ranked.sorted_labels(),
+                                   ranked.num_results(), tables, arena);
   if (idcg <= 0.0)
-    return jacobian;
+    return;
 
-  const size_t size = std::min(cutoff(), ranked->num_results());
+  const size_t size = std::min(cutoff(), ranked.num_results());
 
-  double *weights = new double[ranked->num_results()]();  // init with 0s
+  double *weights = arena.allocate<double>(ranked.num_results());
+  std::fill(weights, weights + ranked.num_results(), 0.0);
 
   /// \todo TODO: it makes sense to pre-compute weights also in ndcg
-  for (size_t i = 0; i < ranked->num_results();) {
+  for (size_t i = 0; i < ranked.num_results();) {
     // find how many with the same score
     // and compute avg score
     size_t j = i + 1;
-    while (j < ranked->num_results()
-        && ranked->sorted_scores()[i] == ranked->sorted_scores()[j])
+    while (j < ranked.num_results()
+        && ranked.sorted_scores()[i] == ranked.sorted_scores()[j])
       j++;
 
     for (size_t k = i; k < j; k++)
-      weights[i] += (1.0 / log2(k + 2.0f));
+      weights[i] += (1.0 / tables.log2_rank(k));
     double tie_size = (double) (j - i);
     weights[i] /= tie_size;     // divide by tie size
     weights[i] /= idcg;         // divide now by idcg to save future operations
@@ -109,25 +107,20 @@ std::unique_ptr<Jacobian> Tndcg::jacobian(
 
   /// \todo TODO: jacobian->at is expensive, we should do this in the results list order
   /// and not in the re-sorted list
+  const Label *labels = ranked.sorted_labels();
   for (size_t i = 0; i < size; ++i) {
-    for (size_t j = i + 1; j < ranked->num_results(); ++j) {
+    for (size_t j = i + 1; j < ranked.num_results(); ++j) {
       // if the score is the same, non changes occur
-      if (ranked->sorted_labels()[i] != ranked->sorted_labels()[j]) {
+      if (labels[i] != labels[j]) {
         if (j < size)
-          jacobian->at(i, j) =
-          jacobian->at(i, j) = (weights[j] - weights[i]) *
-              ( pow(2.0, ranked->sorted_labels()[i])
-              - pow(2.0, ranked->sorted_labels()[j]) );
+          jacobian.at(i, j) = (weights[j] - weights[i]) *
+              (tables.gain(labels[i]) - tables.gain(labels[j]));
         else
-          jacobian->at(i, j) = weights[i] *
-              ( pow(2.0, ranked->sorted_labels()[j])
-                  - pow(2.0, ranked->sorted_labels()[i]) );
+          jacobian.at(i, j) = weights[i] *
+              (tables.gain(labels[j]) - tables.gain(labels[i]));
       }
     }
   }
-
-  delete[] weights;
-  return jacobian;
 }
 
 std::ostream &Tndcg::put(std::ostream &os) const {
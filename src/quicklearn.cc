@@ -111,6 +111,8 @@ int main(int argc, char *argv[]) {
   float subsample = 1.0f;
   float max_features = 1.0f;
   float collapse_leaves_factor = 0;
+  std::string growth_policy = RegressionTree::get_growth_policy(
+      RegressionTree::GrowthPolicy::BEST_FIRST);
   int sampling_iterations = 0;
   float rank_sampling_factor = 1.0;
   float random_sampling_factor = 0.0;
@@ -232,9 +234,23 @@ int main(int argc, char *argv[]) {
 
   pmap.addOptionWithArg("tree-depth",
                         {"set tree depth",
-                         "[applies only to ObliviousMART/ObliviousLambdaMART]."},
+                         "[applies only to ObliviousMART/ObliviousLambdaMART,",
+                         "and to MART/LambdaMART with LEVEL_WISE growth]."},
                         treedepth);
 
+  pmap.addOptionWithArg("growth-policy",
+                        {"set the order in which tree nodes are split",
+                         "[BEST_FIRST|LEVEL_WISE]. LEVEL_WISE splits all the",
+                         "leaves of a level at once, up to tree-depth and",
+                         "num-leaves, and does not collapse leaves [applies",
+                         "only to MART/LambdaMART]."},
+                        growth_policy);
+
+  pmap.addOption("sparse",
+                 {"keep only the non-zero training values, and bin them",
+                  "sparsely: missing values are 0 [applies only to",
+                  "MART/LambdaMART]."});
+
   pmap.addOptionWithArg("subsample",
                         {"the fraction of samples to be used for individual",
                          "base learners."},
@@ -476,6 +492,45 @@ int main(int argc, char *argv[]) {
   pmap.addOption("detailed",
                  {"enable detailed testing [applies only to ensemble models]."});
 
+  pmap.addOptionWithArg("scoring-engine",
+                        {"set the engine scoring the test data [applies only",
+                         "to ensemble models]. Allowed options are:",
+                         "-  \"auto\" (the first supported among oblivious,",
+                         "   quickscorer and pointer),",
+                         "-  \"pointer\" (one tree at a time),",
+                         "-  \"quickscorer\" (trees with at most 64 leaves),",
+                         "-  \"vpred\" (trees with depth at most 16),",
+                         "-  \"oblivious\" (oblivious trees with depth at most 16)."},
+                        std::string("auto"));
+
+  pmap.addOptionWithArg<size_t>("top-k",
+                                {"score the test queries in stages of trees, dropping",
+                                 "the documents that cannot enter the top k [applies",
+                                 "only to ensemble models]. Must not be smaller than",
+                                 "the test cutoff. Dropped documents are scored with",
+                                 "an upper bound. 0 means disabled."},
+                                0);
+
+  pmap.addOptionWithArg<double>("top-k-bound",
+                                {"scale factor of the bounds on the contribution of",
+                                 "the trees left when pruning for --top-k. 1 is exact,",
+                                 "smaller values prune more aggressively."},
+                                1.0);
+
+  pmap.addOptionWithArg("leaf-precision",
+                        {"set the precision of the leaves of the model scoring",
+                         "the test data [applies only to ensemble models].",
+                         "Allowed options are:",
+                         "-  \"double\" (the model as learnt),",
+                         "-  \"float32\" (tree weights folded into float leaves),",
+                         "-  \"int16\" (tree weights folded into int16 leaves",
+                         "   with a scale per tree).",
+                         "The quantized models compare thresholds as uint16",
+                         "bins. Their deviation from the full precision model",
+                         "is reported on the validation data, if given, or",
+                         "on the test data."},
+                        std::string("double"));
+
 
   // --------------------------------------------------------
   pmap.addMessage({"Code generation - general options:"});
@@ -492,6 +547,22 @@ int main(int argc, char *argv[]) {
                         std::string("condop"));
 
 
+  // --------------------------------------------------------
+  pmap.addMessage({"Dataset conversion - general options:"});
+  pmap.addOptionWithArg<std::string>("convert-in",
+                                     {"set dataset file to be converted",
+                                      "(SVML or binary format)."});
+
+  pmap.addOptionWithArg<std::string>("convert-out",
+                                     {"set converted dataset file path."});
+
+  pmap.addOptionWithArg("convert-format",
+                        {"set converted dataset format. Allowed options are:",
+                         "-  \"binary\" (memory mapped at loading time),",
+                         "-  \"svml\"."},
+                        std::string("binary"));
+
+
   // --------------------------------------------------------
   pmap.addMessage({"Help options:"});
   pmap.addOption("help", "h", {"print help message."});
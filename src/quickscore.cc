@@ -29,6 +29,16 @@
 
 #include "data/dataset.h"
 #include "io/svml.h"
+#include "io/binary.h"
+#include "learning/ltr_algorithm.h"
+#include "learning/compiled/compiled_ranker.h"
+#include "scoring/throughput.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
 
 void print_logo() {
   if (isatty(fileno(stdout))) {
@@ -60,6 +70,7 @@ void print_logo() {
 }
 
 double ranker(float *v);
+void ranker_batch(const float *docs, size_t n, size_t stride, double *out);
 
 int main(int argc, char *argv[]) {
   print_logo();
@@ -70,10 +81,48 @@ int main(int argc, char *argv[]) {
   pmap.addMessage({"QuickScore options:"});
   pmap.addOption("help", "h", {"print help message"});
   pmap.addOptionWithArg<std::string>("dataset", "d",
-                                     {"Input dataset in SVML format"});
+                                     {"Input dataset in SVML or binary format"});
   pmap.addOptionWithArg<int>("rounds", "r", {"Number of test repetitions"}, 10);
   pmap.addOptionWithArg<std::string>("scores", "s",
                                      {"File where scores are saved (Optional)."});
+  pmap.addOptionWithArg<std::string>("model", "m",
+                                     {"XML model scored instead of the built-in ranker,",
+                                      "by the library engines or by its generated code",
+                                      "(Optional)."});
+  pmap.addOptionWithArg("scoring-engine", "e",
+                        {"Engine scoring the XML model. Allowed options are:",
+                         "-  \"auto\" (the first supported among oblivious,",
+                         "   quickscorer and pointer),",
+                         "-  \"pointer\" (one tree at a time),",
+                         "-  \"quickscorer\" (trees with at most 64 leaves),",
+                         "-  \"vpred\" (trees with depth at most 16),",
+                         "-  \"oblivious\" (oblivious trees with depth at most 16)."},
+                        std::string("auto"));
+  pmap.addOptionWithArg<std::string>("generator", "g",
+                                     {"Scores the XML model with the code of the given",
+                                      "generator, compiled at run time: [condop|oblivious]",
+                                      "(Optional)."});
+  pmap.addOptionWithArg<std::string>("jit-cache", "c",
+                                     {"Directory where compiled models are cached",
+                                      "(Optional)."});
+
+  pmap.addMessage({"Throughput mode options:"});
+  pmap.addOption("throughput", "t",
+                 {"Serves the queries of the dataset on 1, 2, 4, ... up to",
+                  "--threads cores, and reports the documents per second",
+                  "and the p50/p99 query latencies. XML models are scored",
+                  "document by document, unless compiled with --generator."});
+  pmap.addOptionWithArg<size_t>("threads", "j",
+                                {"Maximum number of threads, 0 means all cores."},
+                                0);
+  pmap.addOption("pin", "p", {"Pins every thread to a distinct CPU."});
+  pmap.addOptionWithArg<size_t>("batch", "b",
+                                {"Maximum number of documents of a query scored",
+                                 "at once, 0 means the whole query."},
+                                0);
+  pmap.addOptionWithArg<size_t>("warmup", "w",
+                                {"Rounds over the dataset before timing."},
+                                1);
 
   bool parse_status = pmap.parse(argc, argv);
   if (!parse_status || pmap.isSet("help") || !pmap.isSet("dataset")) {
@@ -86,38 +135,126 @@ int main(int argc, char *argv[]) {
   size_t rounds = pmap.get<int>("rounds");
   std::string scores_file;
   if (pmap.isSet("scores")) scores_file = pmap.get<std::string>("scores");
+  std::string scoring_engine = pmap.get<std::string>("scoring-engine");
+
+  // load the model scored by the library, if any
+  std::shared_ptr<quickrank::learning::LTR_Algorithm> model;
+  if (pmap.isSet("generator")) {
+    if (!pmap.isSet("model")) {
+      std::cerr << "!!! A model is needed to generate its code." << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::string jit_cache;
+    if (pmap.isSet("jit-cache")) jit_cache = pmap.get<std::string>("jit-cache");
+    auto start_compile = std::chrono::high_resolution_clock::now();
+    auto compiled = std::make_shared<quickrank::learning::CompiledRanker>(
+        pmap.get<std::string>("model"), pmap.get<std::string>("generator"),
+        jit_cache);
+    auto end_compile = std::chrono::high_resolution_clock::now();
+    std::cout << *compiled << "# "
+              << (compiled->compiled() ? "compiled" : "loaded from cache")
+              << " in " << std::chrono::duration_cast<
+                  std::chrono::duration<double>>(
+                  end_compile - start_compile).count() << " s." << std::endl;
+    model = compiled;
+  } else if (pmap.isSet("model")) {
+    model = quickrank::learning::LTR_Algorithm::load_model_from_file(
+        pmap.get<std::string>("model"));
+    if (!model) {
+      std::cerr << "!!! Model type is not supported." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (!model->set_scoring_engine(scoring_engine)
+        && scoring_engine != "auto") {
+      std::cerr << "!!! Scoring engine " << scoring_engine
+                << " applies only to ensemble models." << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::cout << "# Scoring engine: " << scoring_engine << std::endl;
+  }
 
 
   // read dataset
-  quickrank::io::Svml reader;
-  auto dataset = reader.read_horizontal(dataset_file);
+  std::shared_ptr<quickrank::data::Dataset> dataset;
+  if (quickrank::io::Binary::is_binary(dataset_file)) {
+    quickrank::io::Binary reader;
+    dataset = reader.read_horizontal(dataset_file);
+  } else {
+    quickrank::io::Svml reader;
+    dataset = reader.read_horizontal(dataset_file);
+  }
   std::cout << *dataset;
 
   // score dataset
   std::vector<double> scores(dataset->num_instances());
-  auto start_scoring = std::chrono::high_resolution_clock::now();
 
-  for (size_t r = 0; r < rounds; r++) {
-    float *document = dataset->at(0, 0);
-    for (size_t i = 0; i < dataset->num_instances(); i++) {
-      scores[i] = ranker(document);
-      document += dataset->num_features();
+  if (pmap.isSet("throughput")) {
+    quickrank::scoring::ThroughputBenchmark::BatchScorer scorer;
+    auto compiled = std::dynamic_pointer_cast<
+        quickrank::learning::CompiledRanker>(model);
+    if (compiled) {
+      scorer = [compiled](const float *d, size_t n, size_t nfeatures,
+                          double *out) {
+        compiled->score_batch(d, n, nfeatures, out);
+      };
+    } else if (model) {
+      scorer = [model](const float *d, size_t n, size_t nfeatures,
+                       double *out) {
+        for (size_t i = 0; i < n; ++i)
+          out[i] = model->score_document(d + i * nfeatures);
+      };
+    } else {
+      scorer = ranker_batch;
     }
-  }
 
-  auto end_scoring = std::chrono::high_resolution_clock::now();
+    size_t max_threads = pmap.get<size_t>("threads");
+    if (max_threads == 0)
+      max_threads = omp_get_num_procs();
+    quickrank::scoring::ThroughputBenchmark benchmark(
+        dataset, scorer, pmap.get<size_t>("batch"),
+        pmap.get<size_t>("warmup"), rounds, pmap.isSet("pin"));
 
-  double scoring_time =
-      std::chrono::duration_cast<std::chrono::duration<double>>(
-          end_scoring - start_scoring).count();
+    std::cout << "#" << std::endl << "# threads          docs/s   speedup"
+              << "  efficiency    p50 (us)    p99 (us)" << std::endl;
+    std::vector<quickrank::scoring::ThroughputBenchmark::Result> results;
+    for (size_t nthreads:
+        quickrank::scoring::ThroughputBenchmark::thread_counts(max_threads)) {
+      results.push_back(benchmark.run(nthreads, &scores[0]));
+      quickrank::scoring::ThroughputBenchmark::print_scaling(
+          std::cout, results.back(), results.front());
+    }
 
-  std::cout << "       Total scoring time: " << scoring_time << " s."
-            << std::endl;
-  std::cout << "Avg. Dataset scoring time: " << scoring_time / rounds << " s."
-            << std::endl;
-  std::cout << "Avg.    Doc. scoring time: "
-            << scoring_time / dataset->num_instances() / rounds << " s."
-            << std::endl;
+    std::cout << "#" << std::endl << "# Latency by query length with "
+              << results.back().nthreads << " threads:" << std::endl
+              << "#       docs/query  queries    p50 (us)    p99 (us)"
+              << std::endl;
+    benchmark.print_latencies(std::cout, results.back());
+  } else {
+    auto start_scoring = std::chrono::high_resolution_clock::now();
+
+    for (size_t r = 0; r < rounds; r++) {
+      if (model) {
+        model->score_dataset(dataset, &scores[0]);
+        continue;
+      }
+      ranker_batch(dataset->at(0, 0), dataset->num_instances(),
+                   dataset->num_features(), &scores[0]);
+    }
+
+    auto end_scoring = std::chrono::high_resolution_clock::now();
+
+    double scoring_time =
+        std::chrono::duration_cast<std::chrono::duration<double>>(
+            end_scoring - start_scoring).count();
+
+    std::cout << "       Total scoring time: " << scoring_time << " s."
+              << std::endl;
+    std::cout << "Avg. Dataset scoring time: " << scoring_time / rounds << " s."
+              << std::endl;
+    std::cout << "Avg.    Doc. scoring time: "
+              << scoring_time / dataset->num_instances() / rounds << " s."
+              << std::endl;
+  }
 
   // potentially save scores
   if (!scores_file.empty()) {
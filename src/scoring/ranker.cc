@@ -20,6 +20,13 @@
  *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
  */
 
+#include <cstddef>
+
 double ranker(float *v) {
   return 0;
+}
+
+void ranker_batch(const float *docs, size_t n, size_t stride, double *out) {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = ranker((float *) (docs + i * stride));
 }
\ No newline at end of file
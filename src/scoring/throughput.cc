@@ -0,0 +1,191 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "scoring/throughput.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <map>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include "utils/omp-stubs.h"
+#endif
+
+namespace quickrank {
+namespace scoring {
+
+ThroughputBenchmark::ThroughputBenchmark(
+    std::shared_ptr<data::Dataset> dataset, BatchScorer scorer,
+    const size_t batch_size, const size_t warmup_rounds, const size_t rounds,
+    const bool pin)
+    : dataset_(dataset), scorer_(scorer), batch_size_(batch_size),
+      warmup_rounds_(warmup_rounds), rounds_(rounds), pin_(pin) {
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+      if (CPU_ISSET(cpu, &allowed))
+        cpus_.push_back(cpu);
+#endif
+  if (pin_ && cpus_.empty())
+    std::cerr << "!!! Threads cannot be pinned on this system." << std::endl;
+}
+
+double ThroughputBenchmark::score_query(const size_t q, Score *scores) const {
+  const size_t begin = dataset_->offset(q);
+  const size_t end = dataset_->offset(q + 1);
+  const size_t batch = batch_size_ ? batch_size_ : end - begin;
+  const size_t nfeatures = dataset_->num_features();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = begin; i < end; i += batch)
+    scorer_(dataset_->at(i, 0), std::min(batch, end - i), nfeatures,
+            scores + i);
+  auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::duration<double>>(
+      stop - start).count();
+}
+
+ThroughputBenchmark::Result ThroughputBenchmark::run(const size_t nthreads,
+                                                     Score *scores) const {
+  const size_t nqueries = dataset_->num_queries();
+  Result result;
+  result.nthreads = nthreads;
+  result.latencies.resize(rounds_ * nqueries);
+  std::chrono::steady_clock::time_point start, stop;
+
+  #pragma omp parallel num_threads(nthreads)
+  {
+#ifdef __linux__
+    cpu_set_t original;
+    const bool pinned = pin_ && !cpus_.empty()
+        && sched_getaffinity(0, sizeof(original), &original) == 0;
+    if (pinned) {
+      cpu_set_t cpu;
+      CPU_ZERO(&cpu);
+      CPU_SET(cpus_[omp_get_thread_num() % cpus_.size()], &cpu);
+      sched_setaffinity(0, sizeof(cpu), &cpu);
+    }
+#endif
+
+    for (size_t r = 0; r < warmup_rounds_; ++r) {
+      #pragma omp for schedule(dynamic)
+      for (size_t q = 0; q < nqueries; ++q)
+        score_query(q, scores);
+    }
+
+    #pragma omp single
+    start = std::chrono::steady_clock::now();
+
+    for (size_t r = 0; r < rounds_; ++r) {
+      #pragma omp for schedule(dynamic)
+      for (size_t q = 0; q < nqueries; ++q)
+        result.latencies[r * nqueries + q] = score_query(q, scores);
+    }
+
+    #pragma omp single
+    stop = std::chrono::steady_clock::now();
+
+#ifdef __linux__
+    if (pinned)
+      sched_setaffinity(0, sizeof(original), &original);
+#endif
+  }
+
+  result.seconds = std::chrono::duration_cast<std::chrono::duration<double>>(
+      stop - start).count();
+  result.documents_per_second = result.seconds > 0.0 ?
+      rounds_ * dataset_->num_instances() / result.seconds : 0.0;
+  return result;
+}
+
+std::vector<size_t> ThroughputBenchmark::thread_counts(
+    const size_t max_threads) {
+  std::vector<size_t> counts;
+  for (size_t n = 1; n < max_threads; n *= 2)
+    counts.push_back(n);
+  counts.push_back(std::max<size_t>(max_threads, 1));
+  return counts;
+}
+
+double ThroughputBenchmark::percentile(std::vector<double> values,
+                                       const double p) {
+  if (values.empty())
+    return 0.0;
+  const size_t rank = (size_t) std::ceil(p * values.size());
+  const size_t i = std::min(values.size() - 1, rank ? rank - 1 : 0);
+  std::nth_element(values.begin(), values.begin() + i, values.end());
+  return values[i];
+}
+
+void ThroughputBenchmark::print_scaling(std::ostream &os,
+                                        const Result &result,
+                                        const Result &baseline) {
+  const double speedup = baseline.documents_per_second > 0.0 ?
+      result.documents_per_second / baseline.documents_per_second : 0.0;
+  os << std::fixed << std::setw(9) << result.nthreads
+     << std::setw(16) << std::setprecision(0) << result.documents_per_second
+     << std::setw(10) << std::setprecision(2) << speedup
+     << std::setw(12) << std::setprecision(2) << speedup / result.nthreads
+     << std::setw(12) << std::setprecision(1)
+     << percentile(result.latencies, 0.50) * 1e6
+     << std::setw(12) << std::setprecision(1)
+     << percentile(result.latencies, 0.99) * 1e6 << std::endl;
+}
+
+void ThroughputBenchmark::print_latencies(std::ostream &os,
+                                          const Result &result) const {
+  // latencies and number of queries by the upper bound of their length
+  std::map<size_t, std::vector<double>> latencies;
+  std::map<size_t, size_t> nqueries;
+  const size_t nq = dataset_->num_queries();
+  for (size_t q = 0; q < nq; ++q) {
+    const size_t length = dataset_->offset(q + 1) - dataset_->offset(q);
+    size_t limit = 10;
+    while (length > limit)
+      limit *= 10;
+    ++nqueries[limit];
+    for (size_t r = 0; r < rounds_; ++r)
+      latencies[limit].push_back(result.latencies[r * nq + q]);
+  }
+
+  os << std::fixed << std::setprecision(1);
+  for (auto const &bucket: latencies) {
+    const size_t limit = bucket.first;
+    os << std::setw(9) << (limit == 10 ? 1 : limit / 10 + 1) << "-"
+       << std::left << std::setw(8) << limit << std::right
+       << std::setw(9) << nqueries[limit]
+       << std::setw(12) << percentile(bucket.second, 0.50) * 1e6
+       << std::setw(12) << percentile(bucket.second, 0.99) * 1e6
+       << std::endl;
+  }
+}
+
+}  // namespace scoring
+}  // namespace quickrank
@@ -27,6 +27,12 @@ const int omp_get_num_procs() {
 const int omp_get_thread_num() {
   return 0;
 }
+const int omp_get_num_threads() {
+  return 1;
+}
+const int omp_get_max_threads() {
+  return 1;
+}
 const double omp_get_wtime() {
   return 0.0;
 }
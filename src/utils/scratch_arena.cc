@@ -0,0 +1,62 @@
+/*
+ * QuickRank - A C++ suite of Learning to Rank algorithms
+ * Webpage: http://quickrank.isti.cnr.it/
+ * Contact: quickrank@isti.cnr.it
+ *
+ * Unless explicitly acquired and licensed from Licensor under another
+ * license, the contents of this file are subject to the Reciprocal Public
+ * License ("RPL") Version 1.5, or subsequent versions as allowed by the RPL,
+ * and You may not copy or use this file in either source code or executable
+ * form, except in compliance with the terms and conditions of the RPL.
+ *
+ * All software distributed under the RPL is provided strictly on an "AS
+ * IS" basis, WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED, AND
+ * LICENSOR HEREBY DISCLAIMS ALL SUCH WARRANTIES, INCLUDING WITHOUT
+ * LIMITATION, ANY WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, QUIET ENJOYMENT, OR NON-INFRINGEMENT. See the RPL for specific
+ * language governing rights and limitations under the RPL.
+ *
+ * Contributor:
+ *   HPC. Laboratory - ISTI - CNR - http://hpc.isti.cnr.it/
+ */
+#include "utils/scratch_arena.h"
+
+#include <algorithm>
+
+void ScratchArena::reserve(size_t bytes) {
+  if (bytes > capacity_) {
+    full_blocks_.clear();
+    new_block(bytes);
+  }
+  used_ = 0;
+  requested_ = 0;
+}
+
+void ScratchArena::reset() {
+  // a single block will serve the arrays of the last round
+  if (!full_blocks_.empty()) {
+    full_blocks_.clear();
+    new_block(requested_);
+  }
+  used_ = 0;
+  requested_ = 0;
+}
+
+void ScratchArena::grow(size_t bytes) {
+  if (block_)
+    full_blocks_.push_back(std::move(block_));
+  new_block(std::max(bytes, 2 * capacity_));
+}
+
+void ScratchArena::new_block(size_t bytes) {
+  // blocks are a multiple of ALIGNMENT, and the array of a block starts
+  // at its first aligned byte
+  bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  block_.reset(new char[bytes + ALIGNMENT]);
+  ++nallocations_;
+  const size_t misalignment =
+      reinterpret_cast<size_t>(block_.get()) % ALIGNMENT;
+  offset_ = misalignment ? ALIGNMENT - misalignment : 0;
+  capacity_ = bytes;
+  used_ = 0;
+}